@@ -1,6 +1,16 @@
 #pragma once
 
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <gsl/gsl_util>
+
 #include "randomcat/parser/chars/detail/char_traits.hpp"
+#include "randomcat/parser/chars/scan.hpp"
 #include "randomcat/parser/detail/util.hpp"
 #include "randomcat/parser/parse_result.hpp"
 
@@ -25,6 +35,15 @@ namespace randomcat::parser {
             return _source.chars_remaining();
         }
 
+        static inline constexpr auto __has_view = char_traits_detail::has_view_v<CharSource const&>;
+
+        // The chars from the head to the end of the input; only provided if source provides it, which sources holding their chars
+        // contiguously do
+        template<typename CharSource_ = CharSource, typename = decltype(std::declval<CharSource_ const&>().view())>
+        static constexpr string_view_type view(util_detail::no_deduce<CharSource_> const& _source) noexcept(noexcept(_source.view())) {
+            return _source.view();
+        }
+
         static constexpr bool at_end(CharSource const& _source) noexcept(noexcept(_source.at_end())) { return _source.at_end(); }
 
         static constexpr void advance_head(CharSource& _source, size_type _n) noexcept(noexcept(_source.advance_head(_n))) {
@@ -94,6 +113,61 @@ namespace randomcat::parser {
             }
         }
 
+        static inline constexpr auto __has_find = char_traits_detail::has_find_v<CharSource const&, string_view_type>;
+
+        // The number of chars from the head to the first occurrence of _str, or to the end of the input if _str does not occur.
+        // Sources holding their chars contiguously provide find, which searches with string_view::find (memchr for the first char)
+        // instead of peeking char by char.
+        template<typename CharSource_ = CharSource>
+        static constexpr size_type find(util_detail::no_deduce<CharSource_> const& _source, string_view_type _str) {
+            if constexpr (__has_find) {
+                return _source.find(_str);
+            } else {
+                if (_str.empty()) return 0;
+
+                access_wrapper accessWrapper(_source);
+
+                while (not accessWrapper.at_end()) {
+                    if (accessWrapper.peek_char() == _str.front() && accessWrapper.next_is(_str)) break;
+                    accessWrapper.advance_head(1);
+                }
+
+                return accessWrapper.chars_parsed();
+            }
+        }
+
+        static inline constexpr auto __has_find_first_of = char_traits_detail::has_find_first_of_v<CharSource const&, scan_set const&>;
+
+        // The number of chars from the head to the first one in _set, or to the end of the input if there is none. Sources with a
+        // view are searched with parser::find_first_of (see scan.hpp) a block at a time, as are sources providing find_first_of.
+        template<typename CharSource_ = CharSource>
+        static constexpr size_type find_first_of(util_detail::no_deduce<CharSource_> const& _source, scan_set const& _set) {
+            static_assert(std::is_same_v<char_type, char>, "scan_set holds chars");
+
+            if constexpr (__has_find_first_of) {
+                return _source.find_first_of(_set);
+            } else if constexpr (__has_view) {
+                return parser::find_first_of(_source.view(), _set);
+            } else {
+                access_wrapper accessWrapper(_source);
+
+                while (not accessWrapper.at_end() && not _set.contains(accessWrapper.peek_char())) accessWrapper.advance_head(1);
+
+                return accessWrapper.chars_parsed();
+            }
+        }
+
+        static inline constexpr auto __has_share_since = char_traits_detail::has_share_since_v<CharSource const&, location_type>;
+
+        // The chars from _from to the head, as a view that shares ownership of the input and so outlives the source; only provided
+        // if source provides it, which sources whose chars never move (see shared_char_source.hpp) do
+        template<typename CharSource_ = CharSource,
+                 typename = decltype(std::declval<CharSource_ const&>().share_since(std::declval<location_type>()))>
+        static constexpr auto share_since(util_detail::no_deduce<CharSource_> const& _source, location_type _from) noexcept(
+            noexcept(_source.share_since(_from))) {
+            return _source.share_since(_from);
+        }
+
         class access_wrapper {
         public:
             access_wrapper(access_wrapper const&) = default;
@@ -130,6 +204,17 @@ namespace randomcat::parser {
                 return char_source_traits::read_char(as_mutable());
             }
 
+            // Reads up to _n chars onto the end of _out, copying straight out of the source's view if it has one
+            constexpr void read_into(string_type& _out, size_type _n) {
+                if constexpr (__has_view) {
+                    auto const chars = char_source_traits::view(as_immutable()).substr(0, _n);
+                    _out.append(chars);
+                    advance_head(size(chars));
+                } else {
+                    _out += read(_n);
+                }
+            }
+
             constexpr void advance_head(size_type _n) noexcept(noexcept(char_source_traits::advance_head(as_mutable(), _n))) {
                 m_charsParsed += _n;
                 char_source_traits::advance_head(as_mutable(), _n);
@@ -175,6 +260,26 @@ namespace randomcat::parser {
                 return failed_expectation;
             }
 
+            constexpr size_type find(string_view_type _str) const noexcept(noexcept(char_source_traits::find(as_immutable(), _str))) {
+                return char_source_traits::find(as_immutable(), _str);
+            }
+
+            constexpr size_type find_first_of(scan_set const& _set) const noexcept(noexcept(char_source_traits::find_first_of(as_immutable(), _set))) {
+                return char_source_traits::find_first_of(as_immutable(), _set);
+            }
+
+            template<typename CharSource_ = CharSource, typename = decltype(std::declval<CharSource_ const&>().view())>
+            constexpr string_view_type view() const noexcept(noexcept(char_source_traits::view(as_immutable()))) {
+                return char_source_traits::view(as_immutable());
+            }
+
+            // The chars parsed so far, sharing ownership of the input; only provided if the source provides share_since
+            template<typename CharSource_ = CharSource,
+                     typename = decltype(std::declval<CharSource_ const&>().share_since(std::declval<location_type>()))>
+            constexpr auto share_parsed() const noexcept(noexcept(char_source_traits::share_since(as_immutable(), m_startHead))) {
+                return char_source_traits::share_since(as_immutable(), m_startHead);
+            }
+
             constexpr size_type chars_parsed() const noexcept { return m_charsParsed; }
 
             template<typename F>
@@ -293,7 +398,13 @@ namespace randomcat::parser {
         string_type peek(size_type _n) const noexcept { return m_string.substr(m_head, _n); }
         char_type peek_char() const noexcept { return m_string[head()]; }
 
+        size_type find(string_view_type _str) const noexcept {
+            auto const found = string_view_type(m_string).find(_str, m_head);
+            return (found == string_view_type::npos ? size(m_string) : found) - m_head;
+        }
+
         size_type chars_remaining() const noexcept { return size(m_string) - m_head; }
+        string_view_type view() const noexcept { return string_view_type(m_string).substr(m_head); }
 
         void advance_head(size_type _n) noexcept { m_head += _n; }
 
@@ -301,4 +412,39 @@ namespace randomcat::parser {
         size_type m_head = 0;
         string_type m_string;
     };
+
+    // Like string_char_source, but does not own the chars, which must outlive the source
+    template<typename CharT, typename Traits>
+    class string_view_char_source {
+    public:
+        using char_type = CharT;
+        using char_traits_type = Traits;
+        using string_type = std::basic_string<char_type, char_traits_type>;
+        using string_view_type = std::basic_string_view<char_type, char_traits_type>;
+        using size_type = typename string_view_type::size_type;
+        using location_type = size_type;
+
+        explicit string_view_char_source(string_view_type _string) noexcept : m_string(std::move(_string)) {}
+
+        bool at_end() const noexcept { return m_head == size(m_string); }
+        location_type head() const noexcept { return m_head; }
+        void set_head(location_type _head) noexcept { m_head = std::move(_head); }
+
+        string_type peek(size_type _n) const noexcept { return string_type(m_string.substr(m_head, _n)); }
+        char_type peek_char() const noexcept { return at_end() ? char_type() : m_string[head()]; }
+
+        size_type find(string_view_type _str) const noexcept {
+            auto const found = m_string.find(_str, m_head);
+            return (found == string_view_type::npos ? size(m_string) : found) - m_head;
+        }
+
+        size_type chars_remaining() const noexcept { return size(m_string) - m_head; }
+        string_view_type view() const noexcept { return string_view_type(m_string).substr(m_head); }
+
+        void advance_head(size_type _n) noexcept { m_head += _n; }
+
+    private:
+        size_type m_head = 0;
+        string_view_type m_string;
+    };
 }    // namespace randomcat::parser
\ No newline at end of file
@@ -3,9 +3,9 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 
-#include <randomcat/parser/chars/tokenizer.hpp>
 #include <randomcat/parser/detail/util.hpp>
 
 #include "randomcat/parser/detail/defaults.hpp"
@@ -67,6 +67,24 @@ namespace randomcat::parser::char_traits_detail {
     template<typename T, typename Default = default_priority_type>
     using priority_type_t = typename priority_type<T, Default>::type;
 
+    template<typename T, typename Priority, typename = void>
+    struct has_static_priority : std::false_type {};
+
+    template<typename T, typename Priority>
+    struct has_static_priority<T, Priority, std::void_t<std::integral_constant<Priority, T::priority()>>> : std::true_type {};
+
+    template<typename T, typename Priority>
+    inline constexpr auto has_static_priority_v = has_static_priority<T, Priority>::value;
+
+    template<typename T, typename = void>
+    struct has_max_match_size : std::false_type {};
+
+    template<typename T>
+    struct has_max_match_size<T, std::void_t<decltype(std::declval<T const&>().max_match_size())>> : std::true_type {};
+
+    template<typename T>
+    inline constexpr auto has_max_match_size_v = has_max_match_size<T>::value;
+
     template<typename T>
     using token_type_t = typename T::token_type;
 
@@ -111,4 +129,60 @@ namespace randomcat::parser::char_traits_detail {
 
     template<typename CharSource>
     inline auto constexpr has_read_char_v = has_read_char<CharSource>::value;
+
+    template<typename CharSource, typename Enable, typename... Args>
+    struct has_find : std::false_type {};
+
+    template<typename CharSource, typename... Args>
+    struct has_find<CharSource, std::void_t<decltype(std::declval<CharSource>().find(std::declval<Args>()...))>, Args...> : std::true_type {};
+
+    template<typename CharSource, typename... Args>
+    inline constexpr auto has_find_v = has_find<CharSource, void, Args...>::value;
+
+    template<typename CharSource, typename Enable, typename... Args>
+    struct has_find_first_of : std::false_type {};
+
+    template<typename CharSource, typename... Args>
+    struct has_find_first_of<CharSource, std::void_t<decltype(std::declval<CharSource>().find_first_of(std::declval<Args>()...))>, Args...> :
+    std::true_type {};
+
+    template<typename CharSource, typename... Args>
+    inline constexpr auto has_find_first_of_v = has_find_first_of<CharSource, void, Args...>::value;
+
+    template<typename CharSource, typename = void>
+    struct has_view : std::false_type {};
+
+    template<typename CharSource>
+    struct has_view<CharSource, std::void_t<decltype(std::declval<CharSource>().view())>> : std::true_type {};
+
+    template<typename CharSource>
+    inline auto constexpr has_view_v = has_view<CharSource>::value;
+
+    template<typename CharSource, typename Enable, typename... Args>
+    struct has_share_since : std::false_type {};
+
+    template<typename CharSource, typename... Args>
+    struct has_share_since<CharSource, std::void_t<decltype(std::declval<CharSource>().share_since(std::declval<Args>()...))>, Args...> :
+    std::true_type {};
+
+    template<typename CharSource, typename... Args>
+    inline constexpr auto has_share_since_v = has_share_since<CharSource, void, Args...>::value;
+
+    template<typename T, typename Builder, typename = void>
+    struct has_add_to_dfa : std::false_type {};
+
+    template<typename T, typename Builder>
+    struct has_add_to_dfa<T, Builder, std::void_t<decltype(std::declval<T const&>().add_to_dfa(std::declval<Builder&>()))>> : std::true_type {};
+
+    template<typename T, typename Builder>
+    inline auto constexpr has_add_to_dfa_v = has_add_to_dfa<T, Builder>::value;
+
+    template<typename T, typename Hasher, typename = void>
+    struct has_fingerprint : std::false_type {};
+
+    template<typename T, typename Hasher>
+    struct has_fingerprint<T, Hasher, std::void_t<decltype(std::declval<T const&>().fingerprint(std::declval<Hasher&>()))>> : std::true_type {};
+
+    template<typename T, typename Hasher>
+    inline auto constexpr has_fingerprint_v = has_fingerprint<T, Hasher>::value;
 }    // namespace randomcat::parser::char_traits_detail
\ No newline at end of file
@@ -0,0 +1,445 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/chars/detail/char_traits.hpp"
+#include "randomcat/parser/chars/regex.hpp"
+#include "randomcat/parser/chars/tokenizer.hpp"
+#include "randomcat/parser/detail/defaults.hpp"
+#include "randomcat/parser/detail/util.hpp"
+#include "randomcat/parser/diagnostics/stats.hpp"
+#include "randomcat/parser/error_policy.hpp"
+#include "randomcat/parser/parse_result.hpp"
+
+namespace randomcat::parser {
+    namespace dfa_detail {
+        template<typename Token>
+        struct constant_token {
+            Token token;
+
+            template<typename StringView>
+            Token operator()(StringView) const {
+                return token;
+            }
+        };
+
+        template<typename CharSource, typename String, typename StringView>
+        struct dfa_match {
+            // What was scanned, which the match is a prefix of: a view of the source if it provides one, otherwise a copy
+            using scanned_type = std::conditional_t<char_source_traits<CharSource>::__has_view, StringView, String>;
+
+            dfa::pattern_type pattern = dfa::no_pattern;
+            typename char_source_traits<CharSource>::size_type size = 0;
+            scanned_type scanned;
+
+            StringView lexeme() const noexcept { return StringView(scanned).substr(0, size); }
+        };
+
+        // The longest run of _chars that _automaton accepts and _takes agrees to, where _takes(pattern) is asked about each accepting
+        // prefix in turn and decides whether it replaces the one before.
+        template<typename String, typename StringView, typename CharSource, typename Takes>
+        dfa_match<CharSource, String, StringView> longest_match(dfa const& _automaton, CharSource const& _chars, Takes&& _takes) {
+            using source_traits = char_source_traits<CharSource>;
+
+            dfa_match<CharSource, String, StringView> result;
+            auto state = _automaton.start();
+
+            if constexpr (source_traits::__has_view) {
+                result.scanned = source_traits::view(_chars);
+
+                for (std::size_t i = 0; i < result.scanned.size(); ++i) {
+                    state = _automaton.next(state, result.scanned[i]);
+                    if (state == dfa::dead_state) break;
+
+                    if (auto const pattern = _automaton.accepted(state); pattern != dfa::no_pattern && _takes(pattern)) {
+                        result.pattern = pattern;
+                        result.size = i + 1;
+                    }
+                }
+            } else {
+                typename source_traits::access_wrapper accessWrapper(_chars);
+
+                while (not accessWrapper.at_end()) {
+                    auto const c = accessWrapper.peek_char();
+
+                    state = _automaton.next(state, c);
+                    if (state == dfa::dead_state) break;
+
+                    result.scanned += c;
+                    accessWrapper.advance_head(1);
+
+                    if (auto const pattern = _automaton.accepted(state); pattern != dfa::no_pattern && _takes(pattern)) {
+                        result.pattern = pattern;
+                        result.size = accessWrapper.chars_parsed();
+                    }
+                }
+            }
+
+            return result;
+        }
+
+        // What basic_dfa_tokenizer compiles its descriptors into
+        template<typename Priority, typename Size, std::size_t DescriptorCount>
+        struct compiled_descriptors {
+            dfa automaton;
+
+            // Indexed by pattern id; each compiled descriptor adds one pattern
+            std::array<std::size_t, DescriptorCount> patternDescriptors;
+            std::array<Priority, DescriptorCount> patternPriorities;
+
+            // The descriptors that are not compiled, by descending priority and in declaration order among equals
+            std::array<std::size_t, DescriptorCount> fallbacks;
+            std::array<Priority, DescriptorCount> fallbackPriorities;
+            std::array<Size, DescriptorCount> fallbackMaxSizes;
+            std::size_t fallbackCount = 0;
+        };
+    }    // namespace dfa_detail
+
+    // Matches the longest prefix of the input that _pattern accepts (see regex.hpp for the dialect), and makes its token by calling
+    // MakeToken with the matched chars. Used on its own it runs a DFA of just its pattern; dfa_tokenizer instead compiles it into one
+    // automaton with the other descriptors.
+    template<typename Token, typename MakeToken = dfa_detail::constant_token<Token>>
+    class regex_token_descriptor {
+    public:
+        using token_type = Token;
+        using char_type = char_traits_detail::char_type_t<Token>;
+        using char_traits_type = char_traits_detail::char_traits_type_t<Token>;
+
+        using string_type = char_traits_detail::string_type_t<Token>;
+        using string_view_type = char_traits_detail::string_view_type_t<Token>;
+
+        using error_type = no_matching_token_t;
+
+        using parse_result_type = parse_result<token_type, error_type>;
+
+        using priority_type = default_priority_type;
+        using size_type = char_traits_detail::size_type_t<string_type>;
+
+        static_assert(std::is_same_v<char_type, char>, "Patterns are matched byte by byte");
+
+        // Throws std::invalid_argument if _pattern is not a valid pattern
+        regex_token_descriptor(string_type _pattern, priority_type _priority, MakeToken _makeToken)
+        : m_pattern(std::move(_pattern)), m_priority(std::move(_priority)), m_makeToken(std::move(_makeToken)), m_automaton(compile(m_pattern, m_priority)) {}
+
+        template<typename CharSource>
+        parse_result_type parse_first_token(CharSource const& _chars) const noexcept {
+            auto const match = dfa_detail::longest_match<string_type, string_view_type>(*m_automaton, _chars, [](dfa::pattern_type) { return true; });
+            if (match.pattern == dfa::no_pattern) return no_matching_token;
+
+            return {m_makeToken(match.lexeme()), match.size};
+        }
+
+        priority_type priority() const noexcept { return m_priority; }
+
+        template<typename DfaBuilder>
+        void add_to_dfa(DfaBuilder& _builder) const {
+            _builder.add_pattern(m_pattern, m_priority);
+        }
+
+        token_type dfa_token(string_view_type _lexeme) const { return m_makeToken(_lexeme); }
+
+        string_type const& pattern() const noexcept { return m_pattern; }
+
+        // Tokens made from the lexeme are covered by the type of MakeToken, which fingerprints include
+        template<typename Hasher>
+        constexpr void fingerprint(Hasher& _hasher) const {
+            if constexpr (std::is_same_v<MakeToken, dfa_detail::constant_token<Token>>) _hasher(m_makeToken.token);
+            _hasher(m_priority);
+            _hasher(m_pattern);
+        }
+
+    private:
+        static std::shared_ptr<dfa const> compile(string_view_type _pattern, priority_type _priority) {
+            dfa_builder builder;
+            builder.add_pattern(_pattern, _priority);
+
+            return std::make_shared<dfa const>(builder.build());
+        }
+
+        string_type m_pattern;
+        priority_type m_priority;
+        MakeToken m_makeToken;
+
+        // Shared, since copies of the descriptor (e.g. in with_stats) match the same way
+        std::shared_ptr<dfa const> m_automaton;
+    };
+
+    // Matches _pattern as _token
+    template<typename Token>
+    regex_token_descriptor<Token> make_regex_token_descriptor(Token _token, std::string _pattern, default_priority_type _priority = 0) {
+        return regex_token_descriptor<Token>(std::move(_pattern), _priority, dfa_detail::constant_token<Token>{std::move(_token)});
+    }
+
+    // Matches _pattern, making the token from the matched chars with _makeToken
+    template<typename Token, typename MakeToken, typename = std::enable_if_t<std::is_invocable_r_v<Token, MakeToken const&, std::string_view>>>
+    regex_token_descriptor<Token, MakeToken> make_regex_token_descriptor(std::string _pattern, default_priority_type _priority, MakeToken _makeToken) {
+        return regex_token_descriptor<Token, MakeToken>(std::move(_pattern), _priority, std::move(_makeToken));
+    }
+
+    // A tokenizer that compiles every descriptor providing add_to_dfa (simple, multi-form and regex descriptors) into one minimized
+    // DFA when it is constructed, so lexing a token is a single table-driven pass over its chars however many descriptors there are.
+    // Accepting states carry the pattern of the highest priority accepting there, first declared among equals.
+    //
+    // Other descriptors (e.g. raw string literals or delimited comments, which a DFA cannot express) are tried after the pass, from
+    // the highest priority down, and only while they could still beat what matched. Matches are ranked as in simple_tokenizer: by
+    // priority, then length, then declaration order.
+    //
+    // Stats count the pass as one attempt of the descriptor it matched, and the other descriptors as simple_tokenizer counts them.
+    // Errors do not aggregate descriptor errors; under aggregate_errors a failure is reported as no_matching_token.
+    template<typename Stats, typename ErrorPolicy, typename Token, typename... TokenParsers>
+    class basic_dfa_tokenizer {
+    public:
+        using token_type = Token;
+
+        using error_policy = ErrorPolicy;
+        using error_type = typename error_policy::template error_type<no_matching_token_t>;
+        using parse_result_type = parse_result<token_type, error_type>;
+
+        static_assert(util_detail::all_are_same_v<char_traits_detail::char_type_t<Token>, char_traits_detail::char_type_t<TokenParsers>...>);
+        static_assert(util_detail::all_are_same_v<char_traits_detail::char_traits_type_t<Token>, char_traits_detail::char_traits_type_t<TokenParsers>...>);
+
+        static_assert(util_detail::all_are_same_v<char_traits_detail::string_type_t<Token>, char_traits_detail::string_type_t<TokenParsers>...>);
+        static_assert(util_detail::all_are_same_v<char_traits_detail::string_view_type_t<Token>, char_traits_detail::string_view_type_t<TokenParsers>...>);
+
+        using char_type = char_traits_detail::char_type_t<Token>;
+        using char_traits_type = char_traits_detail::char_traits_type_t<Token>;
+        using string_type = char_traits_detail::string_type_t<Token>;
+        using string_view_type = char_traits_detail::string_view_type_t<Token>;
+
+        using size_type = char_traits_detail::size_type_t<Token>;
+
+        static_assert(std::is_same_v<char_type, char>, "Patterns are matched byte by byte");
+
+        static inline constexpr auto token_parser_count = sizeof...(TokenParsers);
+
+        using stats_type = Stats;
+
+        // Throws std::invalid_argument if a regex descriptor's pattern is invalid, and std::length_error if the automaton is too large
+        explicit basic_dfa_tokenizer(TokenParsers... _parsers)
+        : m_descriptors(std::move(_parsers)...), m_compiled(compile(m_descriptors)) {}
+
+        explicit basic_dfa_tokenizer(stats_type _stats, TokenParsers... _parsers)
+        : m_descriptors(std::move(_parsers)...), m_stats(std::move(_stats)), m_compiled(compile(m_descriptors)) {}
+
+        template<typename CharSource>
+        parse_result_type parse_first_token(CharSource const& _input) const noexcept {
+            return parse_first_token_helper(std::make_index_sequence<token_parser_count>(), _input);
+        }
+
+        template<typename Hasher>
+        constexpr void fingerprint(Hasher& _hasher) const {
+            std::apply([&](auto const&... descriptors) { (token_descriptor_traits<TokenParsers>::fingerprint(descriptors, _hasher), ...); }, m_descriptors);
+        }
+
+        // The same tokenizer, reporting to another stats policy; the automaton is shared rather than compiled again
+        template<typename NewStats>
+        basic_dfa_tokenizer<NewStats, ErrorPolicy, Token, TokenParsers...> with_stats(NewStats _stats) const {
+            return basic_dfa_tokenizer<NewStats, ErrorPolicy, Token, TokenParsers...>(std::move(_stats), m_descriptors, m_compiled);
+        }
+
+        template<typename NewErrorPolicy>
+        basic_dfa_tokenizer<Stats, NewErrorPolicy, Token, TokenParsers...> with_error_policy() const {
+            return basic_dfa_tokenizer<Stats, NewErrorPolicy, Token, TokenParsers...>(m_stats, m_descriptors, m_compiled);
+        }
+
+        constexpr stats_type const& stats() const noexcept { return m_stats; }
+
+        // The compiled automaton, e.g. to report its size
+        dfa const& automaton() const noexcept { return m_compiled->automaton; }
+
+    private:
+        template<typename, typename, typename, typename...>
+        friend class basic_dfa_tokenizer;
+
+        static_assert(util_detail::all_are_same_v<char_traits_detail::priority_type_t<token_descriptor_traits<TokenParsers>>...>);
+        static_assert(sizeof...(TokenParsers) > 0);
+
+        using priority_type = char_traits_detail::priority_type_t<util_detail::first_t<token_descriptor_traits<TokenParsers>...>>;
+
+        template<std::size_t I>
+        using descriptor_t = std::tuple_element_t<I, std::tuple<TokenParsers...>>;
+
+        template<std::size_t I>
+        static inline constexpr bool is_compiled = char_traits_detail::has_add_to_dfa_v<descriptor_t<I>, dfa_builder>;
+
+        // Independent of the stats and error policies, so the copies with_stats and with_error_policy make can share it
+        using compiled_descriptors = dfa_detail::compiled_descriptors<priority_type, size_type, token_parser_count>;
+
+        basic_dfa_tokenizer(stats_type _stats, std::tuple<TokenParsers...> _descriptors, std::shared_ptr<compiled_descriptors const> _compiled)
+        : m_descriptors(std::move(_descriptors)), m_stats(std::move(_stats)), m_compiled(std::move(_compiled)) {}
+
+        static std::shared_ptr<compiled_descriptors const> compile(std::tuple<TokenParsers...> const& _descriptors) {
+            return compile_helper(std::make_index_sequence<token_parser_count>(), _descriptors);
+        }
+
+        template<std::size_t... Is>
+        static std::shared_ptr<compiled_descriptors const> compile_helper(std::index_sequence<Is...>, std::tuple<TokenParsers...> const& _descriptors) {
+            auto result = std::make_shared<compiled_descriptors>();
+            dfa_builder builder;
+
+            (add_descriptor<Is>(*result, builder, std::get<Is>(_descriptors)), ...);
+
+            result->automaton = builder.build();
+            return result;
+        }
+
+        template<std::size_t I>
+        static void add_descriptor(compiled_descriptors& _compiled, dfa_builder& _builder, descriptor_t<I> const& _descriptor) {
+            using descriptor_traits = token_descriptor_traits<descriptor_t<I>>;
+
+            auto const priority = descriptor_traits::priority(_descriptor);
+
+            if constexpr (is_compiled<I>) {
+                auto const pattern = _builder.pattern_count();
+                _descriptor.add_to_dfa(_builder);
+
+                _compiled.patternDescriptors[pattern] = I;
+                _compiled.patternPriorities[pattern] = priority;
+            } else {
+                // Insertion sort, which is stable
+                auto k = _compiled.fallbackCount++;
+
+                for (; k > 0 && _compiled.fallbackPriorities[k - 1] < priority; --k) {
+                    _compiled.fallbacks[k] = _compiled.fallbacks[k - 1];
+                    _compiled.fallbackPriorities[k] = _compiled.fallbackPriorities[k - 1];
+                    _compiled.fallbackMaxSizes[k] = _compiled.fallbackMaxSizes[k - 1];
+                }
+
+                _compiled.fallbacks[k] = I;
+                _compiled.fallbackPriorities[k] = priority;
+                _compiled.fallbackMaxSizes[k] = descriptor_traits::max_match_size(_descriptor);
+            }
+        }
+
+        struct best_match {
+            // The descriptor that matched
+            std::size_t index;
+            priority_type priority;
+            size_type size;
+
+            // Only set for matches of descriptors that are not compiled; the pass's token is only made once it has won
+            std::optional<token_type> token;
+        };
+
+        template<std::size_t I>
+        static token_type dfa_token(basic_dfa_tokenizer const& _tokenizer, string_view_type _lexeme) {
+            return std::get<I>(_tokenizer.m_descriptors).dfa_token(_lexeme);
+        }
+
+        template<std::size_t I, typename CharSource>
+        static void attempt(basic_dfa_tokenizer const& _tokenizer, CharSource const& _chars, priority_type _priority, std::optional<best_match>& _best) noexcept {
+            using descriptor_traits = token_descriptor_traits<descriptor_t<I>>;
+
+            _tokenizer.m_stats.descriptor_attempted(I);
+
+            auto tokenResult = descriptor_traits::parse_first_token(std::get<I>(_tokenizer.m_descriptors), _chars);
+            if (not tokenResult) {
+                _tokenizer.m_stats.descriptor_rejected(I);
+                return;
+            }
+
+            auto const size = tokenResult.amount_parsed();
+
+            // Descriptors of a lower priority than the best are never tried
+            if (_best && _best->priority == _priority && (size < _best->size || (size == _best->size && I > _best->index))) return;
+
+            _best = best_match{I, _priority, size, std::move(tokenResult).value()};
+        }
+
+        template<std::size_t I>
+        static constexpr auto dfa_token_function() noexcept {
+            using function = token_type (*)(basic_dfa_tokenizer const&, string_view_type);
+
+            if constexpr (is_compiled<I>) {
+                return function(&basic_dfa_tokenizer::dfa_token<I>);
+            } else {
+                return function(nullptr);
+            }
+        }
+
+        template<std::size_t I, typename CharSource>
+        static constexpr auto attempt_function() noexcept {
+            using function = void (*)(basic_dfa_tokenizer const&, CharSource const&, priority_type, std::optional<best_match>&) noexcept;
+
+            if constexpr (is_compiled<I>) {
+                return function(nullptr);
+            } else {
+                return function(&basic_dfa_tokenizer::attempt<I, CharSource>);
+            }
+        }
+
+        template<std::size_t... Is, typename CharSource>
+        parse_result_type parse_first_token_helper(std::index_sequence<Is...>, CharSource const& _chars) const noexcept {
+            static constexpr decltype(dfa_token_function<0>()) dfaTokens[] = {dfa_token_function<Is>()...};
+            static constexpr decltype(attempt_function<0, CharSource>()) attempts[] = {attempt_function<Is, CharSource>()...};
+
+            auto const& compiled = *m_compiled;
+
+            // Later accepting prefixes are longer, so they replace earlier ones unless those have a higher priority
+            std::optional<priority_type> passPriority;
+            auto const match = dfa_detail::longest_match<string_type, string_view_type>(compiled.automaton, _chars, [&](dfa::pattern_type _pattern) {
+                auto const priority = compiled.patternPriorities[_pattern];
+                if (passPriority && priority < *passPriority) return false;
+
+                passPriority = priority;
+                return true;
+            });
+
+            std::optional<best_match> best;
+
+            if (match.pattern != dfa::no_pattern) {
+                auto const index = compiled.patternDescriptors[match.pattern];
+                m_stats.descriptor_attempted(index);
+
+                best = best_match{index, compiled.patternPriorities[match.pattern], match.size, std::nullopt};
+            }
+
+            for (std::size_t k = 0; k < compiled.fallbackCount; ++k) {
+                auto const priority = compiled.fallbackPriorities[k];
+
+                if (best) {
+                    // The rest all have lower priorities
+                    if (priority < best->priority) break;
+
+                    // Could at most tie with the match
+                    if (priority == best->priority && compiled.fallbackMaxSizes[k] < best->size) continue;
+                }
+
+                attempts[compiled.fallbacks[k]](*this, _chars, priority, best);
+            }
+
+            if (not best) {
+                if constexpr (error_policy::aggregates) {
+                    return no_matching_token;
+                } else {
+                    return error_policy::failure(0);
+                }
+            }
+
+            if (best->token) return {std::move(*best->token), best->size};
+            return {dfaTokens[best->index](*this, match.lexeme()), best->size};
+        }
+
+        std::tuple<TokenParsers...> m_descriptors;
+        stats_type m_stats;
+        std::shared_ptr<compiled_descriptors const> m_compiled;
+    };
+
+    template<typename Token, typename... TokenParsers>
+    using dfa_tokenizer = basic_dfa_tokenizer<no_stats, aggregate_errors, Token, TokenParsers...>;
+
+    template<typename Token, typename... TokenDescriptions>
+    dfa_tokenizer<Token, TokenDescriptions...> make_dfa_tokenizer(TokenDescriptions... _parsers) {
+        return dfa_tokenizer<Token, TokenDescriptions...>(std::move(_parsers)...);
+    }
+}    // namespace randomcat::parser
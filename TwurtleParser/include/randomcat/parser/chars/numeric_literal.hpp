@@ -0,0 +1,531 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/chars/detail/char_traits.hpp"
+#include "randomcat/parser/detail/defaults.hpp"
+#include "randomcat/parser/detail/power_of_five_table.hpp"
+#include "randomcat/parser/detail/swar.hpp"
+#include "randomcat/parser/parse_result.hpp"
+
+namespace randomcat::parser {
+    // A numeric literal's value: an integer if it had neither a fraction nor an exponent, a floating point number otherwise
+    struct numeric_literal {
+        enum class kind_type : std::uint8_t { integer, floating };
+
+        kind_type kind = kind_type::integer;
+
+        std::uint64_t integer = 0;
+        double floating = 0;
+    };
+
+    enum class numeric_literal_error : std::uint8_t {
+        not_a_number,
+
+        // An integer above 2^64 - 1, or a floating point literal too large for a double
+        out_of_range,
+    };
+
+    // Which literals are accepted besides plain decimal integers
+    struct numeric_literal_syntax {
+        // Allowed between two digits, e.g. 1'000'000; '\0' for none
+        char digit_separator = '\'';
+
+        // Integers written 0x1F or 0X1f
+        bool hexadecimal = true;
+
+        // Decimal fractions and exponents: 1.5, .5, 1., 15e-1, 1.5E+3
+        bool floating = true;
+    };
+
+    namespace numeric_detail {
+        constexpr bool is_digit(char _c) noexcept { return '0' <= _c && _c <= '9'; }
+
+        // -1 for chars that are not hexadecimal digits. A table rather than three range checks, whose branches are unpredictable
+        // on hex digits.
+        inline constexpr auto hex_digit_values = [] {
+            std::array<std::int8_t, 256> result = {};
+
+            for (auto& value : result) value = -1;
+            for (int c = '0'; c <= '9'; ++c) result[c] = static_cast<std::int8_t>(c - '0');
+            for (int c = 'a'; c <= 'f'; ++c) result[c] = static_cast<std::int8_t>(c - 'a' + 10);
+            for (int c = 'A'; c <= 'F'; ++c) result[c] = static_cast<std::int8_t>(c - 'A' + 10);
+
+            return result;
+        }();
+
+        constexpr int hex_digit_value(char _c) noexcept { return hex_digit_values[static_cast<unsigned char>(_c)]; }
+
+        constexpr bool is_hex_digit(char _c) noexcept { return hex_digit_value(_c) >= 0; }
+
+        // SWAR: whether all 8 bytes of _word are ASCII digits. Bytes above '9' carry into the high bit when 0x46 is added, and bytes
+        // below '0' borrow into it when 0x30 is subtracted.
+        constexpr bool is_eight_digits(std::uint64_t _word) noexcept {
+            return (((_word + 0x4646464646464646) | (_word - 0x3030303030303030)) & 0x8080808080808080) == 0;
+        }
+
+        // SWAR: the value of the 8 digits in _word, first digit most significant, by combining pairs of digits, then pairs of those,
+        // then the two halves, in three multiplications
+        constexpr std::uint32_t parse_eight_digits(std::uint64_t _word) noexcept {
+            constexpr std::uint64_t mask = 0x000000FF000000FF;
+            constexpr std::uint64_t mul1 = 0x000F424000000064;    // 100 + (1000000 << 32)
+            constexpr std::uint64_t mul2 = 0x0000271000000001;    // 1 + (10000 << 32)
+
+            _word -= 0x3030303030303030;
+            _word = (_word * 10) + (_word >> 8);
+            _word = (((_word & mask) * mul1) + (((_word >> 16) & mask) * mul2)) >> 32;
+
+            return static_cast<std::uint32_t>(_word);
+        }
+
+        // The end of the run of decimal or hexadecimal digits starting at _position, where a separator between two digits belongs
+        // to the run. Decimal runs are skipped 8 digits at a time.
+        template<bool Decimal>
+        std::size_t scan_digits(std::string_view _chars, std::size_t _position, char _separator) noexcept {
+            constexpr auto isDigit = [](char _c) { return Decimal ? is_digit(_c) : is_hex_digit(_c); };
+
+            auto const start = _position;
+
+            while (_position < _chars.size()) {
+                if constexpr (Decimal) {
+                    while (_position + 8 <= _chars.size() && is_eight_digits(swar_detail::load_eight(_chars.data() + _position))) _position += 8;
+                    if (_position == _chars.size()) break;
+                }
+
+                auto const c = _chars[_position];
+
+                if (isDigit(c)) {
+                    ++_position;
+                    continue;
+                }
+
+                if (_separator != '\0' && c == _separator && _position != start && _position + 1 < _chars.size() && isDigit(_chars[_position + 1])) {
+                    ++_position;
+                    continue;
+                }
+
+                break;
+            }
+
+            return _position;
+        }
+
+        // The number of digits in a run found by scan_digits
+        inline std::size_t digit_count(std::string_view _run, char _separator) noexcept {
+            if (_separator == '\0') return _run.size();
+            return _run.size() - static_cast<std::size_t>(std::count(_run.begin(), _run.end(), _separator));
+        }
+
+        // The run without its leading zeros (and the separators between them)
+        inline std::string_view strip_leading_zeros(std::string_view _run, char _separator) noexcept {
+            std::size_t i = 0;
+            while (i < _run.size() && (_run[i] == '0' || (_separator != '\0' && _run[i] == _separator))) ++i;
+
+            return _run.substr(i);
+        }
+
+        // Appends up to _limit - _count digits of _run to _value, 8 at a time where they are contiguous, wrapping on overflow.
+        // Returns the number of digits appended.
+        inline std::size_t accumulate_decimal(std::string_view _run, char _separator, std::uint64_t& _value, std::size_t _count, std::size_t _limit) noexcept {
+            auto const startCount = _count;
+            std::size_t i = 0;
+
+            while (i < _run.size() && _count < _limit) {
+                if (i + 8 <= _run.size() && _count + 8 <= _limit) {
+                    auto const word = swar_detail::load_eight(_run.data() + i);
+
+                    if (is_eight_digits(word)) {
+                        _value = _value * 100000000 + parse_eight_digits(word);
+                        _count += 8;
+                        i += 8;
+                        continue;
+                    }
+                }
+
+                auto const c = _run[i++];
+                if (c == _separator) continue;
+
+                _value = _value * 10 + static_cast<std::uint64_t>(c - '0');
+                ++_count;
+            }
+
+            return _count - startCount;
+        }
+
+        struct value128 {
+            std::uint64_t low;
+            std::uint64_t high;
+        };
+
+        inline value128 full_multiplication(std::uint64_t _first, std::uint64_t _second) noexcept {
+#ifdef __SIZEOF_INT128__
+            auto const product = static_cast<unsigned __int128>(_first) * _second;
+            return {static_cast<std::uint64_t>(product), static_cast<std::uint64_t>(product >> 64)};
+#else
+            auto const firstLow = _first & 0xFFFFFFFF;
+            auto const firstHigh = _first >> 32;
+            auto const secondLow = _second & 0xFFFFFFFF;
+            auto const secondHigh = _second >> 32;
+
+            auto const lowLow = firstLow * secondLow;
+            auto const lowHigh = firstLow * secondHigh;
+            auto const highLow = firstHigh * secondLow;
+            auto const highHigh = firstHigh * secondHigh;
+
+            auto const middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+
+            return {(middle << 32) | (lowLow & 0xFFFFFFFF), highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32)};
+#endif
+        }
+
+        // The IEEE binary64 parameters Eisel-Lemire needs
+        inline constexpr int mantissa_explicit_bits = 52;
+        inline constexpr int minimum_exponent = -1023;
+        inline constexpr int infinite_power = 0x7FF;
+        inline constexpr int min_exponent_round_to_even = -4;
+        inline constexpr int max_exponent_round_to_even = 23;
+
+        // A double's mantissa (without the implicit bit) and biased exponent
+        struct adjusted_mantissa {
+            std::uint64_t mantissa = 0;
+            int power2 = 0;
+
+            friend bool operator==(adjusted_mantissa const& _first, adjusted_mantissa const& _second) noexcept {
+                return _first.mantissa == _second.mantissa && _first.power2 == _second.power2;
+            }
+
+            friend bool operator!=(adjusted_mantissa const& _first, adjusted_mantissa const& _second) noexcept {
+                return not(_first == _second);
+            }
+
+            double to_double() const noexcept {
+                auto const bits = mantissa | (static_cast<std::uint64_t>(power2) << mantissa_explicit_bits);
+
+                double result;
+                std::memcpy(&result, &bits, sizeof(result));
+                return result;
+            }
+        };
+
+        // floor(log2(5^_q)) + _q + 63, for |_q| within the table
+        constexpr int power(int _q) noexcept { return (((152170 + 65536) * _q) >> 16) + 63; }
+
+        // _w (normalized) times 5^_q, to at least Precision + 64 correct bits where that is enough to round
+        template<int Precision>
+        value128 product_approximation(std::int64_t _q, std::uint64_t _w) noexcept {
+            auto const index = static_cast<std::size_t>(2 * (_q - smallest_power_of_five));
+
+            auto result = full_multiplication(_w, power_of_five_128[index]);
+
+            constexpr std::uint64_t precisionMask = std::uint64_t(0xFFFFFFFFFFFFFFFF) >> Precision;
+
+            // Only the low bits of the high word are in doubt, and then the second half of the power settles them
+            if ((result.high & precisionMask) == precisionMask) {
+                auto const second = full_multiplication(_w, power_of_five_128[index + 1]);
+
+                result.low += second.high;
+                if (second.high > result.low) ++result.high;
+            }
+
+            return result;
+        }
+
+        // Eisel-Lemire: the double nearest to _w * 10^_q, for _w below 2^64. _w * 10^_q is _w * 5^_q * 2^_q, and 5^_q is taken from
+        // a table of its 128 most significant bits, so one (rarely two) 64 x 64 bit multiplication gives the mantissa.
+        inline adjusted_mantissa compute_float(std::int64_t _q, std::uint64_t _w) noexcept {
+            adjusted_mantissa answer;
+
+            if (_w == 0 || _q < smallest_power_of_five) return answer;
+
+            if (_q > largest_power_of_five) {
+                answer.power2 = infinite_power;
+                return answer;
+            }
+
+            auto const leadingZeros = __builtin_clzll(_w);
+            _w <<= leadingZeros;
+
+            auto const product = product_approximation<mantissa_explicit_bits + 3>(_q, _w);
+
+            auto const upperBit = static_cast<int>(product.high >> 63);
+            auto const shift = upperBit + 64 - mantissa_explicit_bits - 3;
+
+            answer.mantissa = product.high >> shift;
+            answer.power2 = power(static_cast<int>(_q)) + upperBit - leadingZeros - minimum_exponent;
+
+            if (answer.power2 <= 0) {
+                // Subnormal, or zero
+                if (-answer.power2 + 1 >= 64) return adjusted_mantissa();
+
+                answer.mantissa >>= -answer.power2 + 1;
+                answer.mantissa += (answer.mantissa & 1);
+                answer.mantissa >>= 1;
+                answer.power2 = (answer.mantissa < (std::uint64_t(1) << mantissa_explicit_bits)) ? 0 : 1;
+
+                return answer;
+            }
+
+            // Exactly halfway between two doubles, which can only happen for small exponents: round to even
+            if (product.low <= 1 && _q >= min_exponent_round_to_even && _q <= max_exponent_round_to_even && (answer.mantissa & 3) == 1) {
+                if ((answer.mantissa << shift) == product.high) answer.mantissa &= ~std::uint64_t(1);
+            }
+
+            answer.mantissa += (answer.mantissa & 1);
+            answer.mantissa >>= 1;
+
+            if (answer.mantissa >= (std::uint64_t(2) << mantissa_explicit_bits)) {
+                answer.mantissa = std::uint64_t(1) << mantissa_explicit_bits;
+                ++answer.power2;
+            }
+
+            answer.mantissa &= ~(std::uint64_t(1) << mantissa_explicit_bits);
+
+            if (answer.power2 >= infinite_power) return {0, infinite_power};
+
+            return answer;
+        }
+
+        inline constexpr double exact_powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        // The double nearest to the decimal literal _literal, whose digits are _w * 10^_q if not _truncated, and otherwise start
+        // with _w, followed by more digits
+        inline double to_double(std::string_view _literal, char _separator, std::uint64_t _w, std::int64_t _q, bool _truncated) noexcept {
+            // Clinger: both _w and 10^|_q| are exact doubles, so one rounding gives the nearest double
+            if (not _truncated && _w <= (std::uint64_t(1) << 53) && _q >= -22 && _q <= 22) {
+                auto const value = static_cast<double>(_w);
+                return _q < 0 ? value / exact_powers_of_ten[-_q] : value * exact_powers_of_ten[_q];
+            }
+
+            auto const answer = compute_float(_q, _w);
+
+            // The dropped digits put the value between _w and _w + 1 (times 10^_q); if both round the same way, so does the value
+            if (not _truncated || answer == compute_float(_q, _w + 1)) return answer.to_double();
+
+            // Too close to halfway between two doubles to tell without every digit; this needs over 19 significant digits, so it is
+            // rare enough to leave to the standard library
+            std::string cleaned;
+            cleaned.reserve(_literal.size());
+            for (auto const c : _literal) {
+                if (c != _separator) cleaned += c;
+            }
+
+            double result = 0;
+            std::from_chars(cleaned.data(), cleaned.data() + cleaned.size(), result);
+            return result;
+        }
+
+        inline parse_result<numeric_literal, numeric_literal_error> parse_hexadecimal(std::string_view _chars, char _separator) noexcept {
+            auto const end = scan_digits<false>(_chars, 2, _separator);
+
+            auto const digits = strip_leading_zeros(_chars.substr(2, end - 2), _separator);
+            if (digit_count(digits, _separator) > 16) return numeric_literal_error::out_of_range;
+
+            std::uint64_t value = 0;
+            for (auto const c : digits) {
+                if (c != _separator) value = (value << 4) | static_cast<std::uint64_t>(hex_digit_value(c));
+            }
+
+            return {numeric_literal{numeric_literal::kind_type::integer, value, 0}, end};
+        }
+
+        inline parse_result<numeric_literal, numeric_literal_error> parse_decimal(std::string_view _chars, numeric_literal_syntax _syntax) noexcept {
+            auto const separator = _syntax.digit_separator;
+
+            auto const integerEnd = scan_digits<true>(_chars, 0, separator);
+            auto const integerRun = _chars.substr(0, integerEnd);
+
+            auto position = integerEnd;
+            std::string_view fractionRun;
+            bool isFloating = false;
+
+            if (_syntax.floating && position < _chars.size() && _chars[position] == '.') {
+                auto const fractionEnd = scan_digits<true>(_chars, position + 1, separator);
+
+                // A lone . is not a number
+                if (integerEnd != 0 || fractionEnd != position + 1) {
+                    fractionRun = _chars.substr(position + 1, fractionEnd - position - 1);
+                    position = fractionEnd;
+                    isFloating = true;
+                }
+            }
+
+            if (position == 0) return numeric_literal_error::not_a_number;
+
+            std::int64_t exponent = 0;
+
+            // The exponent only belongs to the literal if it has digits, so 2e is 2 followed by e
+            if (_syntax.floating && position < _chars.size() && (_chars[position] == 'e' || _chars[position] == 'E')) {
+                auto exponentStart = position + 1;
+                bool const negative = exponentStart < _chars.size() && _chars[exponentStart] == '-';
+                if (exponentStart < _chars.size() && (_chars[exponentStart] == '-' || _chars[exponentStart] == '+')) ++exponentStart;
+
+                auto const exponentEnd = scan_digits<true>(_chars, exponentStart, separator);
+
+                if (exponentEnd != exponentStart) {
+                    for (auto const c : _chars.substr(exponentStart, exponentEnd - exponentStart)) {
+                        // Saturates far beyond any exponent a double can take
+                        if (c != separator && exponent < 0x10000000) exponent = exponent * 10 + (c - '0');
+                    }
+
+                    if (negative) exponent = -exponent;
+
+                    position = exponentEnd;
+                    isFloating = true;
+                }
+            }
+
+            auto const literal = _chars.substr(0, position);
+
+            if (not isFloating) {
+                auto const digits = strip_leading_zeros(integerRun, separator);
+                auto const count = digit_count(digits, separator);
+
+                // 2^64 - 1 has 20 digits, the first of them 1; a 20 digit value starting with 1 wraps at most once, to below 10^19
+                if (count > 20 || (count == 20 && digits.front() != '1')) return numeric_literal_error::out_of_range;
+
+                std::uint64_t value = 0;
+                accumulate_decimal(digits, separator, value, 0, 20);
+
+                if (count == 20 && value < 10000000000000000000ULL) return numeric_literal_error::out_of_range;
+
+                return {numeric_literal{numeric_literal::kind_type::integer, value, 0}, position};
+            }
+
+            // The significant digits run from the first non-zero one through the integer part and the fraction; at most 19 of them
+            // are kept, which always fits in 64 bits
+            auto const integerDigits = strip_leading_zeros(integerRun, separator);
+            auto const fractionDigits = integerDigits.empty() ? strip_leading_zeros(fractionRun, separator) : fractionRun;
+
+            auto const fractionCount = static_cast<std::int64_t>(digit_count(fractionRun, separator));
+            auto const significantCount = digit_count(integerDigits, separator) + digit_count(fractionDigits, separator);
+
+            constexpr std::size_t kept_digits = 19;
+
+            std::uint64_t w = 0;
+            auto const integerKept = accumulate_decimal(integerDigits, separator, w, 0, kept_digits);
+            auto const fractionKept = accumulate_decimal(fractionDigits, separator, w, integerKept, kept_digits);
+
+            auto const dropped = static_cast<std::int64_t>(significantCount - integerKept - fractionKept);
+            auto const q = exponent - fractionCount + dropped;
+
+            auto const value = to_double(literal, separator, w, q, dropped != 0);
+            if (std::isinf(value)) return numeric_literal_error::out_of_range;
+
+            return {numeric_literal{numeric_literal::kind_type::floating, 0, value}, position};
+        }
+
+        // Whether _c can continue a numeric literal of which _previous is the last char, so that sources without a view can gather a
+        // literal's chars before parsing them. Overestimates, which is harmless.
+        constexpr bool may_continue(char _c, char _previous, char _separator) noexcept {
+            if (is_hex_digit(_c) || _c == '.' || _c == 'x' || _c == 'X' || (_separator != '\0' && _c == _separator)) return true;
+            return (_c == '+' || _c == '-') && (_previous == 'e' || _previous == 'E');
+        }
+    }    // namespace numeric_detail
+
+    // Reads the numeric literal _chars starts with (a decimal integer, or as _syntax allows, a hexadecimal integer or a floating point
+    // literal), returning its value and how many chars it spans. Decimal digits are read 8 at a time where there are 8 in a row, and
+    // floating point literals are converted with the Clinger fast path or else Eisel-Lemire, which are exact; only literals with more
+    // than 19 significant digits that are very close to halfway between two doubles fall back to std::from_chars.
+    inline parse_result<numeric_literal, numeric_literal_error> parse_numeric_literal(std::string_view _chars, numeric_literal_syntax _syntax = {}) noexcept {
+        if (_chars.empty()) return numeric_literal_error::not_a_number;
+
+        if (_syntax.hexadecimal && _chars.size() > 2 && _chars[0] == '0' && (_chars[1] == 'x' || _chars[1] == 'X') && numeric_detail::is_hex_digit(_chars[2])) {
+            return numeric_detail::parse_hexadecimal(_chars, _syntax.digit_separator);
+        }
+
+        return numeric_detail::parse_decimal(_chars, _syntax);
+    }
+
+    // Matches a numeric literal as parse_numeric_literal reads it, making the token by calling MakeToken with the numeric_literal.
+    // Literals out of range are errors rather than being cut short.
+    template<typename Token, typename MakeToken>
+    class numeric_literal_token_descriptor {
+    public:
+        using token_type = Token;
+        using char_type = char_traits_detail::char_type_t<Token>;
+        using char_traits_type = char_traits_detail::char_traits_type_t<Token>;
+
+        using string_type = char_traits_detail::string_type_t<Token>;
+        using string_view_type = char_traits_detail::string_view_type_t<Token>;
+
+        using error_type = numeric_literal_error;
+
+        using parse_result_type = parse_result<token_type, error_type>;
+
+        using priority_type = default_priority_type;
+        using size_type = char_traits_detail::size_type_t<string_type>;
+
+        static_assert(std::is_same_v<char_type, char>);
+
+        explicit numeric_literal_token_descriptor(MakeToken _makeToken, priority_type _priority = 0, numeric_literal_syntax _syntax = {})
+        : m_makeToken(std::move(_makeToken)), m_priority(std::move(_priority)), m_syntax(std::move(_syntax)) {}
+
+        template<typename CharSource>
+        parse_result_type parse_first_token(CharSource const& _chars) const {
+            using source_traits = char_source_traits<CharSource>;
+
+            if constexpr (source_traits::__has_view) {
+                return make_token(parse_numeric_literal(source_traits::view(_chars), m_syntax));
+            } else {
+                if (source_traits::at_end(_chars)) return numeric_literal_error::not_a_number;
+
+                auto const first = source_traits::peek_char(_chars);
+                if (not numeric_detail::is_digit(first) && first != '.') return numeric_literal_error::not_a_number;
+
+                typename source_traits::access_wrapper accessWrapper(_chars);
+                string_type literal;
+
+                while (not accessWrapper.at_end()) {
+                    auto const c = accessWrapper.peek_char();
+                    if (not literal.empty() && not numeric_detail::may_continue(c, literal.back(), m_syntax.digit_separator)) break;
+
+                    literal += c;
+                    accessWrapper.advance_head(1);
+                }
+
+                return make_token(parse_numeric_literal(literal, m_syntax));
+            }
+        }
+
+        constexpr priority_type priority() const noexcept { return m_priority; }
+
+        template<typename Hasher>
+        constexpr void fingerprint(Hasher& _hasher) const {
+            _hasher(m_priority);
+            _hasher(m_syntax.digit_separator);
+            _hasher(m_syntax.hexadecimal);
+            _hasher(m_syntax.floating);
+        }
+
+    private:
+        parse_result_type make_token(parse_result<numeric_literal, numeric_literal_error> _literal) const {
+            if (not _literal) return std::move(_literal).error();
+
+            auto const size = _literal.amount_parsed();
+            return {m_makeToken(std::move(_literal).value()), size};
+        }
+
+        MakeToken m_makeToken;
+        priority_type m_priority;
+        numeric_literal_syntax m_syntax;
+    };
+
+    template<typename Token, typename MakeToken>
+    numeric_literal_token_descriptor<Token, MakeToken> make_numeric_literal_token_descriptor(MakeToken _makeToken,
+                                                                                             default_priority_type _priority = 0,
+                                                                                             numeric_literal_syntax _syntax = {}) {
+        return numeric_literal_token_descriptor<Token, MakeToken>(std::move(_makeToken), _priority, _syntax);
+    }
+}    // namespace randomcat::parser
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/detail/waiter.hpp"
+
+namespace randomcat::parser {
+    namespace readahead_detail {
+        template<typename CharT>
+        struct block {
+            std::unique_ptr<CharT[]> data;
+            std::size_t size = 0;
+            bool last = false;
+
+            // What reading the stream threw, after the chars read before it; nothing is read after such a block
+            std::exception_ptr exception;
+
+            // Set by the producer once the block may be consumed, cleared by the consumer once it may be refilled
+            std::atomic<bool> full = false;
+        };
+
+        template<typename Stream>
+        class state {
+        public:
+            using stream_type = Stream;
+            using char_type = typename stream_type::char_type;
+            using char_traits_type = typename stream_type::traits_type;
+            using string_type = std::basic_string<char_type, char_traits_type>;
+            using string_view_type = std::basic_string_view<char_type, char_traits_type>;
+            using size_type = typename string_type::size_type;
+
+            state(state const&) = delete;
+            state(state&&) = delete;
+            state& operator=(state const&) = delete;
+            state& operator=(state&&) = delete;
+
+            explicit state(stream_type _stream, size_type _blockSize, size_type _blockCount, size_type _retainedSize)
+            : m_stream(std::move(_stream)), m_blockSize(_blockSize), m_blocks(_blockCount), m_retainedSize(_retainedSize) {
+                if (m_blockSize == 0) throw std::invalid_argument("readahead_char_source block size must be positive");
+                if (m_blocks.size() < 2) throw std::invalid_argument("readahead_char_source requires at least two blocks");
+
+                for (auto& b : m_blocks) b.data = std::make_unique<char_type[]>(m_blockSize);
+
+                m_producer = std::thread([this] { produce(); });
+            }
+
+            ~state() noexcept {
+                m_stop.store(true, std::memory_order_relaxed);
+                m_blockEmptied.notify();
+
+                if (m_producer.joinable()) m_producer.join();
+            }
+
+            size_type head() const noexcept { return m_head; }
+
+            void set_head(size_type _head) {
+                if (_head < m_windowBegin || _head > window_end())
+                    throw std::out_of_range("readahead_char_source head moved outside of the retained window");
+
+                m_head = _head;
+            }
+
+            // Returns the number of chars available after the head, which is less than _n only at the end of the stream. If reading
+            // the stream threw, the exception is rethrown in place of the chars it failed to read.
+            size_type ensure_available(size_type _n) {
+                while (window_end() - m_head < _n && not m_consumedLast) pull_block();
+                return std::min(_n, window_end() - m_head);
+            }
+
+            char_type const* head_pointer() const noexcept { return m_window.data() + (m_head - m_windowBegin); }
+
+            // Pulls blocks until _str is found or the stream ends, so the window may grow past the retained size for far matches
+            size_type find(string_view_type _str) {
+                auto searchFrom = m_head;
+
+                while (true) {
+                    auto const found = string_view_type(m_window).find(_str, searchFrom - m_windowBegin);
+                    if (found != string_view_type::npos) return m_windowBegin + found - m_head;
+
+                    if (m_consumedLast) return window_end() - m_head;
+
+                    // A match may start in the chars already searched and end in the next block
+                    if (window_end() - m_head >= size(_str)) searchFrom = window_end() - (size(_str) - 1);
+
+                    pull_block();
+                }
+            }
+
+            // Pulls blocks until a char in _set is found or the stream ends, like find
+            size_type find_first_of(scan_set const& _set) {
+                auto searchFrom = m_head;
+
+                while (true) {
+                    auto const searched = string_view_type(m_window).substr(searchFrom - m_windowBegin);
+                    auto const found = parser::find_first_of(searched, _set);
+                    if (found != searched.size()) return searchFrom + found - m_head;
+
+                    if (m_consumedLast) return window_end() - m_head;
+
+                    searchFrom = window_end();
+                    pull_block();
+                }
+            }
+
+            void advance_head(size_type _n) { m_head += ensure_available(_n); }
+
+        private:
+            size_type window_end() const noexcept { return m_windowBegin + m_window.size(); }
+
+            void produce() {
+                for (size_type index = 0;; ++index) {
+                    auto& b = m_blocks[index % m_blocks.size()];
+
+                    m_blockEmptied.wait([&] { return not b.full.load(std::memory_order_acquire) || m_stop.load(std::memory_order_relaxed); });
+                    if (m_stop.load(std::memory_order_relaxed)) return;
+
+                    try {
+                        m_stream.read(b.data.get(), m_blockSize);
+                        b.size = static_cast<std::size_t>(m_stream.gcount());
+                        b.last = b.size < m_blockSize || not m_stream;
+                    } catch (...) {
+                        // E.g. a stream with exceptions() enabled; read still counts the chars it stored before throwing
+                        b.size = static_cast<std::size_t>(m_stream.gcount());
+                        b.exception = std::current_exception();
+                    }
+
+                    b.full.store(true, std::memory_order_release);
+                    m_blockFilled.notify();
+
+                    if (b.last || b.exception) return;
+                }
+            }
+
+            void pull_block() {
+                if (m_exception) std::rethrow_exception(m_exception);
+
+                auto& b = m_blocks[m_nextBlock % m_blocks.size()];
+                m_blockFilled.wait([&] { return b.full.load(std::memory_order_acquire); });
+
+                discard_unretained();
+
+                m_window.append(b.data.get(), b.size);
+                m_consumedLast = b.last;
+                m_exception = std::move(b.exception);
+
+                b.full.store(false, std::memory_order_release);
+                m_blockEmptied.notify();
+                ++m_nextBlock;
+            }
+
+            void discard_unretained() {
+                // Only discard once twice the retained size has built up, so that the erase is amortized
+                auto const behindHead = m_head - m_windowBegin;
+                if (behindHead <= 2 * m_retainedSize) return;
+
+                auto const toDiscard = behindHead - m_retainedSize;
+                m_window.erase(0, toDiscard);
+                m_windowBegin += toDiscard;
+            }
+
+            // Producer side
+            stream_type m_stream;
+            size_type m_blockSize;
+            std::vector<block<char_type>> m_blocks;
+            std::atomic<bool> m_stop = false;
+
+            wait_detail::waiter m_blockFilled;
+            wait_detail::waiter m_blockEmptied;
+
+            // Consumer side
+            size_type m_retainedSize;
+            string_type m_window;
+            size_type m_windowBegin = 0;
+            size_type m_head = 0;
+            size_type m_nextBlock = 0;
+            bool m_consumedLast = false;
+            std::exception_ptr m_exception;
+
+            std::thread m_producer;
+        };
+    }    // namespace readahead_detail
+
+    // Reads the stream on a background thread, _blockCount blocks ahead of the consumer.
+    // At least _retainedSize chars before the head are kept, and set_head may move anywhere inside that window.
+    // Anything reading the stream throws is rethrown on the consumer's thread, once the chars read before it are used up.
+    template<typename Stream>
+    class readahead_char_source {
+    private:
+        using state_type = readahead_detail::state<Stream>;
+
+    public:
+        using stream_type = Stream;
+
+        using char_type = typename state_type::char_type;
+        using char_traits_type = typename state_type::char_traits_type;
+        using string_type = typename state_type::string_type;
+        using string_view_type = typename state_type::string_view_type;
+        using size_type = typename state_type::size_type;
+        using location_type = size_type;
+
+        static inline constexpr size_type default_block_size = 64 * 1024;
+        static inline constexpr size_type default_block_count = 4;
+        static inline constexpr size_type default_retained_size = 1024 * 1024;
+
+        explicit readahead_char_source(stream_type _stream,
+                                       size_type _blockSize = default_block_size,
+                                       size_type _blockCount = default_block_count,
+                                       size_type _retainedSize = default_retained_size)
+        : m_state(std::make_unique<state_type>(std::move(_stream), _blockSize, _blockCount, _retainedSize)) {}
+
+        bool at_end() const { return m_state->ensure_available(1) == 0; }
+
+        location_type head() const noexcept { return m_state->head(); }
+        void set_head(location_type _head) { m_state->set_head(_head); }
+
+        string_type peek(size_type _n) const {
+            auto const available = m_state->ensure_available(_n);
+            return string_type(m_state->head_pointer(), available);
+        }
+
+        char_type peek_char() const {
+            if (m_state->ensure_available(1) == 0) return char_type();
+            return *m_state->head_pointer();
+        }
+
+        size_type find(string_view_type _str) const { return m_state->find(_str); }
+        size_type find_first_of(scan_set const& _set) const { return m_state->find_first_of(_set); }
+
+        void advance_head(size_type _n) { m_state->advance_head(_n); }
+
+    private:
+        std::unique_ptr<state_type> m_state;
+    };
+}    // namespace randomcat::parser
@@ -0,0 +1,530 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace randomcat::parser {
+    // Patterns of regex_token_descriptor (and the literal descriptors compiled alongside them) are built into a Thompson NFA, which
+    // is turned into a DFA by subset construction over byte equivalence classes and then minimized.
+    //
+    // The dialect works on bytes and supports:
+    //   c              the byte c, for anything but the special chars below
+    //   \c             the byte c, for any c except the escapes listed next
+    //   \n \r \t \v \f newline, carriage return, tab, vertical tab, form feed
+    //   \xHH          the byte with the two hex digits HH
+    //   \d \w \s       [0-9], [A-Za-z0-9_] and [ \t\n\r\v\f]
+    //   .              any byte but a newline
+    //   [abc] [a-z]    any byte of the set; [^...] any byte not in it. Escapes work inside sets, and ] or - first are literal
+    //   (r)            grouping
+    //   r|s            either
+    //   r* r+ r?       zero or more, one or more, zero or one
+    // Patterns are matched from the head only; there are no anchors, backreferences or lazy quantifiers.
+    namespace regex_detail {
+        using byte_set = std::bitset<256>;
+
+        inline constexpr auto no_state = std::numeric_limits<std::uint32_t>::max();
+        inline constexpr std::int32_t no_pattern = -1;
+
+        struct nfa_state {
+            // Either a byte edge (to next, on any byte of chars) or epsilon edges
+            byte_set chars;
+            std::uint32_t next = no_state;
+            std::vector<std::uint32_t> epsilons;
+
+            std::int32_t accept = no_pattern;
+        };
+
+        struct nfa {
+            std::vector<nfa_state> states;
+            std::uint32_t start = no_state;
+
+            std::uint32_t add_state() {
+                states.emplace_back();
+                return static_cast<std::uint32_t>(states.size() - 1);
+            }
+        };
+
+        // A part of the NFA entered at start, and left from end (which has no edges yet)
+        struct fragment {
+            std::uint32_t start;
+            std::uint32_t end;
+        };
+
+        inline byte_set byte_range(unsigned char _first, unsigned char _last) {
+            byte_set result;
+            for (unsigned c = _first; c <= _last; ++c) result.set(c);
+            return result;
+        }
+
+        inline byte_set single_byte(char _c) {
+            byte_set result;
+            result.set(static_cast<unsigned char>(_c));
+            return result;
+        }
+
+        class pattern_parser {
+        public:
+            explicit pattern_parser(nfa& _nfa, std::string_view _pattern) : m_nfa(_nfa), m_pattern(_pattern) {}
+
+            fragment parse() {
+                auto const result = parse_alternation();
+                if (m_position != m_pattern.size()) fail("unmatched )");
+
+                return result;
+            }
+
+            fragment literal(std::string_view _string) {
+                auto result = empty();
+                for (auto const c : _string) result = concatenate(result, chars(single_byte(c)));
+
+                return result;
+            }
+
+            fragment alternate(fragment _first, fragment _second) {
+                auto const start = m_nfa.add_state();
+                auto const end = m_nfa.add_state();
+
+                m_nfa.states[start].epsilons = {_first.start, _second.start};
+                m_nfa.states[_first.end].epsilons.push_back(end);
+                m_nfa.states[_second.end].epsilons.push_back(end);
+
+                return {start, end};
+            }
+
+        private:
+            [[noreturn]] void fail(char const* _what) const {
+                throw std::invalid_argument("Invalid regex \"" + std::string(m_pattern) + "\" at " + std::to_string(m_position) + ": " + _what);
+            }
+
+            bool at_end() const noexcept { return m_position == m_pattern.size(); }
+            char peek() const noexcept { return m_pattern[m_position]; }
+            char read() noexcept { return m_pattern[m_position++]; }
+
+            fragment empty() {
+                auto const start = m_nfa.add_state();
+                auto const end = m_nfa.add_state();
+                m_nfa.states[start].epsilons.push_back(end);
+
+                return {start, end};
+            }
+
+            fragment chars(byte_set _chars) {
+                auto const start = m_nfa.add_state();
+                auto const end = m_nfa.add_state();
+                m_nfa.states[start].chars = _chars;
+                m_nfa.states[start].next = end;
+
+                return {start, end};
+            }
+
+            fragment concatenate(fragment _first, fragment _second) {
+                m_nfa.states[_first.end].epsilons.push_back(_second.start);
+                return {_first.start, _second.end};
+            }
+
+            fragment parse_alternation() {
+                auto result = parse_sequence();
+
+                while (not at_end() && peek() == '|') {
+                    read();
+                    result = alternate(result, parse_sequence());
+                }
+
+                return result;
+            }
+
+            fragment parse_sequence() {
+                auto result = empty();
+
+                while (not at_end() && peek() != '|' && peek() != ')') result = concatenate(result, parse_repetition());
+
+                return result;
+            }
+
+            fragment parse_repetition() {
+                auto atom = parse_atom();
+
+                while (not at_end() && (peek() == '*' || peek() == '+' || peek() == '?')) {
+                    auto const op = read();
+
+                    auto const start = m_nfa.add_state();
+                    auto const end = m_nfa.add_state();
+
+                    // * and ? may skip the atom, * and + may repeat it
+                    if (op != '+') m_nfa.states[start].epsilons.push_back(end);
+                    m_nfa.states[start].epsilons.push_back(atom.start);
+
+                    if (op != '?') m_nfa.states[atom.end].epsilons.push_back(atom.start);
+                    m_nfa.states[atom.end].epsilons.push_back(end);
+
+                    atom = {start, end};
+                }
+
+                return atom;
+            }
+
+            fragment parse_atom() {
+                auto const c = read();
+
+                switch (c) {
+                    case '(': {
+                        auto const inner = parse_alternation();
+                        if (at_end() || read() != ')') fail("missing )");
+
+                        return inner;
+                    }
+                    case '[': return chars(parse_set());
+                    case '.': return chars(~single_byte('\n'));
+                    case '\\': return chars(parse_escape());
+                    case '*':
+                    case '+':
+                    case '?': fail("quantifier without anything to repeat");
+                    default: return chars(single_byte(c));
+                }
+            }
+
+            byte_set parse_escape() {
+                if (at_end()) fail("trailing \\");
+
+                switch (auto const c = read()) {
+                    case 'n': return single_byte('\n');
+                    case 'r': return single_byte('\r');
+                    case 't': return single_byte('\t');
+                    case 'v': return single_byte('\v');
+                    case 'f': return single_byte('\f');
+                    case 'x': {
+                        auto const high = hex_digit();
+                        return single_byte(static_cast<char>(high * 16 + hex_digit()));
+                    }
+                    case 'd': return byte_range('0', '9');
+                    case 'w': return byte_range('a', 'z') | byte_range('A', 'Z') | byte_range('0', '9') | single_byte('_');
+                    case 's': return single_byte(' ') | single_byte('\t') | single_byte('\n') | single_byte('\r') | single_byte('\v') | single_byte('\f');
+                    default: return single_byte(c);
+                }
+            }
+
+            unsigned hex_digit() {
+                if (at_end()) fail("\\x needs two hex digits");
+
+                auto const c = read();
+                if (c >= '0' && c <= '9') return unsigned(c - '0');
+                if (c >= 'a' && c <= 'f') return unsigned(c - 'a' + 10);
+                if (c >= 'A' && c <= 'F') return unsigned(c - 'A' + 10);
+
+                fail("\\x needs two hex digits");
+            }
+
+            byte_set parse_set() {
+                byte_set result;
+
+                auto const negated = not at_end() && peek() == '^';
+                if (negated) read();
+
+                for (bool first = true;; first = false) {
+                    if (at_end()) fail("missing ]");
+                    if (peek() == ']' && not first) {
+                        read();
+                        break;
+                    }
+
+                    auto const c = read();
+                    if (c == '\\') {
+                        auto const escaped = parse_escape();
+
+                        // Multi-byte escapes (\d, \w, \s) cannot start a range
+                        if (escaped.count() != 1) {
+                            result |= escaped;
+                            continue;
+                        }
+
+                        result |= range_from(static_cast<unsigned char>(lowest_byte(escaped)));
+                    } else {
+                        result |= range_from(static_cast<unsigned char>(c));
+                    }
+                }
+
+                return negated ? ~result : result;
+            }
+
+            // The byte _first, or the range from it if a - and an upper bound follow
+            byte_set range_from(unsigned char _first) {
+                if (m_position + 1 >= m_pattern.size() || peek() != '-' || m_pattern[m_position + 1] == ']') return single_byte(static_cast<char>(_first));
+
+                read();
+
+                auto last = static_cast<unsigned char>(read());
+                if (last == '\\') {
+                    auto const escaped = parse_escape();
+                    if (escaped.count() != 1) fail("range ends in a class");
+
+                    last = lowest_byte(escaped);
+                }
+
+                if (last < _first) fail("range is reversed");
+                return byte_range(_first, last);
+            }
+
+            static unsigned char lowest_byte(byte_set const& _set) noexcept {
+                for (unsigned c = 0; c < 256; ++c) {
+                    if (_set.test(c)) return static_cast<unsigned char>(c);
+                }
+
+                return 0;
+            }
+
+            nfa& m_nfa;
+            std::string_view m_pattern;
+            std::size_t m_position = 0;
+        };
+    }    // namespace regex_detail
+
+    // A minimized DFA over byte equivalence classes, whose accepting states name the pattern they accept.
+    // State 0 is the dead state, which no match continues from.
+    class dfa {
+    public:
+        using state_type = std::uint16_t;
+        using pattern_type = std::int32_t;
+
+        static inline constexpr state_type dead_state = 0;
+        static inline constexpr pattern_type no_pattern = regex_detail::no_pattern;
+
+        state_type start() const noexcept { return m_start; }
+
+        state_type next(state_type _state, char _c) const noexcept {
+            return m_transitions[std::size_t(_state) * m_classCount + m_classes[static_cast<unsigned char>(_c)]];
+        }
+
+        // The pattern accepted in _state, or no_pattern
+        pattern_type accepted(state_type _state) const noexcept { return m_accepts[_state]; }
+
+        std::size_t state_count() const noexcept { return m_accepts.size(); }
+        std::size_t class_count() const noexcept { return m_classCount; }
+
+    private:
+        friend class dfa_builder;
+
+        std::array<std::uint8_t, 256> m_classes = {};
+        std::size_t m_classCount = 0;
+
+        // Indexed by state * class_count + class
+        std::vector<state_type> m_transitions;
+        std::vector<pattern_type> m_accepts;
+        state_type m_start = dead_state;
+    };
+
+    // Collects patterns and literals, each accepted as its own pattern id (in the order added), and builds a DFA accepting all of
+    // them. Where several patterns accept the same input, the state accepts the one with the highest priority, and the first added
+    // of those.
+    class dfa_builder {
+    public:
+        using priority_type = std::int64_t;
+
+        dfa_builder() { m_nfa.start = m_nfa.add_state(); }
+
+        // Throws std::invalid_argument if _pattern is not valid in the dialect described in regex_detail
+        dfa::pattern_type add_pattern(std::string_view _pattern, priority_type _priority) {
+            return add(regex_detail::pattern_parser(m_nfa, _pattern).parse(), _priority);
+        }
+
+        dfa::pattern_type add_literal(std::string_view _literal, priority_type _priority) {
+            return add(regex_detail::pattern_parser(m_nfa, {}).literal(_literal), _priority);
+        }
+
+        // Any of _literals, as one pattern
+        template<typename... Strings>
+        dfa::pattern_type add_literals(priority_type _priority, Strings const&... _literals) {
+            static_assert(sizeof...(Strings) > 0);
+
+            regex_detail::pattern_parser parser(m_nfa, {});
+
+            std::vector<regex_detail::fragment> fragments = {parser.literal(_literals)...};
+
+            auto result = fragments.front();
+            for (std::size_t i = 1; i < fragments.size(); ++i) result = parser.alternate(result, fragments[i]);
+
+            return add(result, _priority);
+        }
+
+        std::size_t pattern_count() const noexcept { return m_priorities.size(); }
+
+        dfa build() const {
+            auto const [classes, classCount] = byte_classes();
+
+            // Subset construction; state 0 is the empty set, which becomes the dead state
+            std::vector<std::vector<std::uint32_t>> sets = {{}, closure({m_nfa.start})};
+            std::map<std::vector<std::uint32_t>, std::uint32_t> ids = {{sets[0], 0}, {sets[1], 1}};
+            std::vector<std::uint32_t> transitions;
+
+            auto representatives = std::vector<unsigned>(classCount);
+            for (unsigned c = 256; c-- > 0;) representatives[classes[c]] = c;
+
+            for (std::size_t current = 0; current < sets.size(); ++current) {
+                for (std::size_t byteClass = 0; byteClass < classCount; ++byteClass) {
+                    std::vector<std::uint32_t> moved;
+                    for (auto const state : sets[current]) {
+                        auto const& nfaState = m_nfa.states[state];
+                        if (nfaState.next != regex_detail::no_state && nfaState.chars.test(representatives[byteClass])) moved.push_back(nfaState.next);
+                    }
+
+                    auto target = closure(std::move(moved));
+
+                    auto const [it, inserted] = ids.emplace(target, static_cast<std::uint32_t>(sets.size()));
+                    if (inserted) sets.push_back(std::move(target));
+
+                    transitions.push_back(it->second);
+                }
+            }
+
+            std::vector<dfa::pattern_type> accepts(sets.size(), dfa::no_pattern);
+            for (std::size_t state = 0; state < sets.size(); ++state) {
+                for (auto const nfaState : sets[state]) accepts[state] = better(accepts[state], m_nfa.states[nfaState].accept);
+            }
+
+            return minimize(classes, classCount, transitions, accepts);
+        }
+
+    private:
+        dfa::pattern_type add(regex_detail::fragment _fragment, priority_type _priority) {
+            auto const id = static_cast<dfa::pattern_type>(m_priorities.size());
+
+            m_nfa.states[m_nfa.start].epsilons.push_back(_fragment.start);
+            m_nfa.states[_fragment.end].accept = id;
+            m_priorities.push_back(_priority);
+
+            return id;
+        }
+
+        dfa::pattern_type better(dfa::pattern_type _first, dfa::pattern_type _second) const noexcept {
+            if (_first == dfa::no_pattern) return _second;
+            if (_second == dfa::no_pattern) return _first;
+
+            if (m_priorities[_first] != m_priorities[_second]) return m_priorities[_first] > m_priorities[_second] ? _first : _second;
+            return std::min(_first, _second);
+        }
+
+        // The NFA states reachable from _states by epsilon edges, sorted
+        std::vector<std::uint32_t> closure(std::vector<std::uint32_t> _states) const {
+            std::vector<bool> seen(m_nfa.states.size());
+            std::vector<std::uint32_t> pending = _states;
+            _states.clear();
+
+            while (not pending.empty()) {
+                auto const state = pending.back();
+                pending.pop_back();
+
+                if (seen[state]) continue;
+                seen[state] = true;
+                _states.push_back(state);
+
+                for (auto const next : m_nfa.states[state].epsilons) pending.push_back(next);
+            }
+
+            std::sort(_states.begin(), _states.end());
+            return _states;
+        }
+
+        // Bytes no pattern tells apart share a class, so transitions are stored per class rather than per byte
+        std::pair<std::array<std::uint8_t, 256>, std::size_t> byte_classes() const {
+            std::vector<regex_detail::byte_set> sets;
+            for (auto const& state : m_nfa.states) {
+                if (state.next != regex_detail::no_state && std::find(sets.begin(), sets.end(), state.chars) == sets.end()) sets.push_back(state.chars);
+            }
+
+            std::array<std::uint8_t, 256> classes = {};
+            std::map<std::vector<bool>, std::size_t> signatures;
+
+            for (unsigned c = 0; c < 256; ++c) {
+                std::vector<bool> signature(sets.size());
+                for (std::size_t i = 0; i < sets.size(); ++i) signature[i] = sets[i].test(c);
+
+                auto const it = signatures.emplace(std::move(signature), signatures.size()).first;
+                classes[c] = static_cast<std::uint8_t>(it->second);
+            }
+
+            return {classes, signatures.size()};
+        }
+
+        // Moore's algorithm: states start out grouped by what they accept, and groups are split until all members of a group move
+        // to the same groups on every byte class
+        static dfa minimize(std::array<std::uint8_t, 256> const& _classes,
+                            std::size_t _classCount,
+                            std::vector<std::uint32_t> const& _transitions,
+                            std::vector<dfa::pattern_type> const& _accepts) {
+            auto const stateCount = _accepts.size();
+
+            std::vector<std::uint32_t> group(stateCount);
+            std::size_t groupCount = 0;
+
+            {
+                std::map<dfa::pattern_type, std::uint32_t> initial;
+                for (std::size_t state = 0; state < stateCount; ++state) {
+                    group[state] = initial.emplace(_accepts[state], static_cast<std::uint32_t>(initial.size())).first->second;
+                }
+
+                groupCount = initial.size();
+            }
+
+            while (true) {
+                std::map<std::vector<std::uint32_t>, std::uint32_t> signatures;
+                std::vector<std::uint32_t> refined(stateCount);
+
+                for (std::size_t state = 0; state < stateCount; ++state) {
+                    std::vector<std::uint32_t> signature = {group[state]};
+                    for (std::size_t byteClass = 0; byteClass < _classCount; ++byteClass) {
+                        signature.push_back(group[_transitions[state * _classCount + byteClass]]);
+                    }
+
+                    refined[state] = signatures.emplace(std::move(signature), static_cast<std::uint32_t>(signatures.size())).first->second;
+                }
+
+                group = std::move(refined);
+                if (signatures.size() == groupCount) break;
+
+                groupCount = signatures.size();
+            }
+
+            if (groupCount > std::numeric_limits<dfa::state_type>::max()) throw std::length_error("DFA has too many states");
+
+            // Renumber so that the dead state's group is 0
+            std::vector<std::uint32_t> number(groupCount, std::numeric_limits<std::uint32_t>::max());
+            number[group[0]] = 0;
+
+            dfa::state_type nextNumber = 1;
+            for (std::size_t state = 0; state < stateCount; ++state) {
+                if (number[group[state]] == std::numeric_limits<std::uint32_t>::max()) number[group[state]] = nextNumber++;
+            }
+
+            dfa result;
+            result.m_classes = _classes;
+            result.m_classCount = _classCount;
+            result.m_transitions.resize(groupCount * _classCount);
+            result.m_accepts.resize(groupCount);
+            result.m_start = static_cast<dfa::state_type>(number[group[1]]);
+
+            for (std::size_t state = 0; state < stateCount; ++state) {
+                auto const minimal = number[group[state]];
+                result.m_accepts[minimal] = _accepts[state];
+
+                for (std::size_t byteClass = 0; byteClass < _classCount; ++byteClass) {
+                    result.m_transitions[minimal * _classCount + byteClass] =
+                        static_cast<dfa::state_type>(number[group[_transitions[state * _classCount + byteClass]]]);
+                }
+            }
+
+            return result;
+        }
+
+        regex_detail::nfa m_nfa;
+        std::vector<priority_type> m_priorities;
+    };
+}    // namespace randomcat::parser
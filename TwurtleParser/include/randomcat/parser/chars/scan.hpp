@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+#include "randomcat/parser/detail/swar.hpp"
+
+namespace randomcat::parser {
+    // The chars find_first_of stops at: up to max_chars chars, and optionally every char below a bound (such as the control chars,
+    // below ' '). Small and fixed so that a whole block of input is checked against all of them at once.
+    class scan_set {
+    public:
+        static constexpr std::size_t max_chars = 4;
+
+        // The largest bound the SWAR fallback can compare against
+        static constexpr unsigned char max_below = 0x80;
+
+        // Throws std::invalid_argument unless _chars has 1 to max_chars chars and _below is at most max_below
+        constexpr explicit scan_set(std::string_view _chars, unsigned char _below = 0) : m_below(_below) {
+            if (_chars.empty() || _chars.size() > max_chars) {
+                throw std::invalid_argument("A scan_set needs 1 to " + std::to_string(max_chars) + " chars");
+            }
+
+            if (_below > max_below) throw std::invalid_argument("A scan_set can only stop at chars below " + std::to_string(max_below));
+
+            // Repeating the first char makes every search compare against exactly max_chars chars
+            for (std::size_t i = 0; i < max_chars; ++i) m_chars[i] = _chars[i < _chars.size() ? i : 0];
+        }
+
+        constexpr bool contains(char _c) const noexcept {
+            return _c == m_chars[0] || _c == m_chars[1] || _c == m_chars[2] || _c == m_chars[3] || static_cast<unsigned char>(_c) < m_below;
+        }
+
+        constexpr char at(std::size_t _index) const noexcept { return m_chars[_index]; }
+        constexpr unsigned char below() const noexcept { return m_below; }
+
+    private:
+        char m_chars[max_chars] = {};
+        unsigned char m_below;
+    };
+
+    namespace scan_detail {
+        template<bool UseBelow>
+        std::size_t find_first_of(std::string_view _chars, scan_set const& _set) noexcept {
+            auto const* const data = _chars.data();
+            auto const size = _chars.size();
+
+            std::size_t position = 0;
+
+#if defined(__SSE2__)
+            auto const first = _mm_set1_epi8(_set.at(0));
+            auto const second = _mm_set1_epi8(_set.at(1));
+            auto const third = _mm_set1_epi8(_set.at(2));
+            auto const fourth = _mm_set1_epi8(_set.at(3));
+
+            // x is below the bound if and only if subtracting bound - 1 (saturating at 0) leaves 0
+            auto const belowLimit = _mm_set1_epi8(static_cast<char>(_set.below() - 1));
+            auto const zero = _mm_setzero_si128();
+
+            for (; position + 16 <= size; position += 16) {
+                auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + position));
+
+                auto matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second)),
+                                            _mm_or_si128(_mm_cmpeq_epi8(block, third), _mm_cmpeq_epi8(block, fourth)));
+
+                if constexpr (UseBelow) matches = _mm_or_si128(matches, _mm_cmpeq_epi8(_mm_subs_epu8(block, belowLimit), zero));
+
+                auto const mask = _mm_movemask_epi8(matches);
+                if (mask != 0) return position + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+            }
+#else
+            using namespace swar_detail;
+
+            for (; position + 8 <= size; position += 8) {
+                auto const word = load_eight(data + position);
+
+                auto marks = bytes_equal(word, static_cast<unsigned char>(_set.at(0))) | bytes_equal(word, static_cast<unsigned char>(_set.at(1)))
+                             | bytes_equal(word, static_cast<unsigned char>(_set.at(2))) | bytes_equal(word, static_cast<unsigned char>(_set.at(3)));
+
+                if constexpr (UseBelow) marks |= bytes_below(word, _set.below());
+
+                if (marks != 0) return position + first_marked_byte(marks);
+            }
+#endif
+
+            for (; position < size; ++position) {
+                if (_set.contains(data[position])) return position;
+            }
+
+            return size;
+        }
+    }    // namespace scan_detail
+
+    // The index of the first char of _chars in _set, or _chars.size() if there is none. Checks 16 chars at a time with SSE2 where
+    // the target has it, and 8 at a time with word arithmetic otherwise, so long runs of uninteresting chars (string literal
+    // bodies, say) are skipped at close to memchr speed.
+    inline std::size_t find_first_of(std::string_view _chars, scan_set const& _set) noexcept {
+        if (_set.below() == 0) return scan_detail::find_first_of<false>(_chars, _set);
+        return scan_detail::find_first_of<true>(_chars, _set);
+    }
+}    // namespace randomcat::parser
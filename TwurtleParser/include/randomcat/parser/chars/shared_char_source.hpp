@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/detail/mapped_file.hpp"
+
+namespace randomcat::parser {
+    // A view that shares ownership of the chars it views, so it stays valid after the source it came from is gone
+    template<typename CharT, typename Traits = std::char_traits<CharT>>
+    class basic_shared_string_view {
+    public:
+        using char_type = CharT;
+        using char_traits_type = Traits;
+        using string_view_type = std::basic_string_view<char_type, char_traits_type>;
+        using size_type = typename string_view_type::size_type;
+
+        basic_shared_string_view() noexcept = default;
+
+        explicit basic_shared_string_view(std::shared_ptr<char_type const> _data, size_type _size) noexcept
+        : m_data(std::move(_data)), m_size(_size) {}
+
+        string_view_type view() const noexcept { return string_view_type(m_data.get(), m_size); }
+        operator string_view_type() const noexcept { return view(); }
+
+        size_type size() const noexcept { return m_size; }
+        bool empty() const noexcept { return m_size == 0; }
+
+        // Shares ownership with this view, like string_view::substr (but _pos must be at most size())
+        basic_shared_string_view substr(size_type _pos, size_type _n = string_view_type::npos) const noexcept {
+            auto const size = std::min(_n, m_size - _pos);
+            return basic_shared_string_view(std::shared_ptr<char_type const>(m_data, m_data.get() + _pos), size);
+        }
+
+    private:
+        std::shared_ptr<char_type const> m_data;
+        size_type m_size = 0;
+    };
+
+    using shared_string_view = basic_shared_string_view<char>;
+
+    // Like string_char_source, but shares ownership of its chars, which therefore never move. Tokenizers can keep views into the
+    // input (see share_since) instead of copying out of it.
+    template<typename CharT, typename Traits>
+    class shared_char_source {
+    public:
+        using char_type = CharT;
+        using char_traits_type = Traits;
+        using string_type = std::basic_string<char_type, char_traits_type>;
+        using string_view_type = std::basic_string_view<char_type, char_traits_type>;
+        using shared_string_view_type = basic_shared_string_view<char_type, char_traits_type>;
+        using size_type = typename string_view_type::size_type;
+        using location_type = size_type;
+
+        explicit shared_char_source(shared_string_view_type _string) noexcept : m_string(std::move(_string)) {}
+
+        explicit shared_char_source(string_type _string) : m_string(share(std::move(_string))) {}
+
+        // Maps the file at _path; returns nullopt if it cannot be mapped (including if it is empty)
+        static std::optional<shared_char_source> map_file(std::string const& _path) {
+            static_assert(sizeof(char_type) == 1, "Only files of single byte chars can be mapped");
+
+            auto file = std::make_shared<file_detail::mapped_file const>(file_detail::mapped_file::open(_path));
+            if (not *file) return std::nullopt;
+
+            auto const size = file->size();
+            auto const chars = reinterpret_cast<char_type const*>(file->data());
+            return shared_char_source(shared_string_view_type(std::shared_ptr<char_type const>(file, chars), size));
+        }
+
+        bool at_end() const noexcept { return m_head == m_string.size(); }
+        location_type head() const noexcept { return m_head; }
+        void set_head(location_type _head) noexcept { m_head = std::move(_head); }
+
+        string_type peek(size_type _n) const noexcept { return string_type(view().substr(0, _n)); }
+        char_type peek_char() const noexcept { return at_end() ? char_type() : m_string.view()[head()]; }
+
+        size_type find(string_view_type _str) const noexcept {
+            auto const found = m_string.view().find(_str, m_head);
+            return (found == string_view_type::npos ? m_string.size() : found) - m_head;
+        }
+
+        size_type chars_remaining() const noexcept { return m_string.size() - m_head; }
+        string_view_type view() const noexcept { return m_string.view().substr(m_head); }
+
+        // The chars from _from to the head, sharing ownership of the input
+        shared_string_view_type share_since(location_type _from) const noexcept { return m_string.substr(_from, m_head - _from); }
+
+        void advance_head(size_type _n) noexcept { m_head += _n; }
+
+    private:
+        static shared_string_view_type share(string_type _string) {
+            auto owner = std::make_shared<string_type const>(std::move(_string));
+            auto const size = owner->size();
+            auto const chars = owner->data();
+            return shared_string_view_type(std::shared_ptr<char_type const>(owner, chars), size);
+        }
+
+        size_type m_head = 0;
+        shared_string_view_type m_string;
+    };
+
+    template<typename CharT, typename Traits>
+    shared_char_source(basic_shared_string_view<CharT, Traits>) -> shared_char_source<CharT, Traits>;
+}    // namespace randomcat::parser
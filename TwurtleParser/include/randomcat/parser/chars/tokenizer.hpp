@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -17,8 +22,14 @@
 #include "randomcat/parser/chars/detail/char_traits.hpp"
 #include "randomcat/parser/detail/defaults.hpp"
 #include "randomcat/parser/detail/util.hpp"
+#include "randomcat/parser/diagnostics/stats.hpp"
+#include "randomcat/parser/error_policy.hpp"
 #include "randomcat/parser/parse_result.hpp"
 
+#ifdef RANDOMCAT_PARSER_TRACING
+#    include "randomcat/parser/diagnostics/trace.hpp"
+#endif
+
 namespace randomcat::parser {
     template<typename Tokenizer>
     struct tokenizer_traits {
@@ -34,11 +45,20 @@ namespace randomcat::parser {
 
         using parse_result_type = parse_result<token_type, error_type>;
 
+        // See error_policy.hpp; token streams and grammars reading from the tokenizer use it too
+        using error_policy = error_policy_detail::error_policy_t<Tokenizer>;
+
         template<typename CharSource>
         static constexpr parse_result_type parse_first_token(Tokenizer const& _tokenizer,
                                                              CharSource const& _input) noexcept(noexcept(_tokenizer.parse_first_token(_input))) {
             return _tokenizer.parse_first_token(_input);
         }
+
+        // Feeds everything that determines how the tokenizer splits input into _hasher, if the tokenizer supports it
+        template<typename Hasher>
+        static constexpr void fingerprint(Tokenizer const& _tokenizer, Hasher& _hasher) {
+            if constexpr (char_traits_detail::has_fingerprint_v<Tokenizer, Hasher>) _tokenizer.fingerprint(_hasher);
+        }
     };
 
     struct no_matching_token_t {};
@@ -60,6 +80,20 @@ namespace randomcat::parser {
             return _tokenDescriptor.priority();
         }
 
+        // Whether priority() is static and constexpr, which lets tokenizers order descriptors by priority while compiling
+        static inline constexpr bool has_static_priority = char_traits_detail::has_static_priority_v<TokenDescriptor, priority_type>;
+
+        using size_type = char_traits_detail::size_type_t<TokenDescriptor>;
+
+        // The most chars a match can span, if the descriptor knows; tokenizers skip descriptors that could only tie with a longer match
+        static constexpr size_type max_match_size(TokenDescriptor const& _tokenDescriptor) noexcept {
+            if constexpr (char_traits_detail::has_max_match_size_v<TokenDescriptor>) {
+                return _tokenDescriptor.max_match_size();
+            } else {
+                return std::numeric_limits<size_type>::max();
+            }
+        }
+
         using error_type = char_traits_detail::error_type_t<TokenDescriptor>;
         using parse_result_type = parse_result<token_type, error_type>;
 
@@ -68,6 +102,11 @@ namespace randomcat::parser {
                                                              CharSource const& _chars) noexcept(noexcept(_tokenDescriptor.parse_first_token(_chars))) {
             return _tokenDescriptor.parse_first_token(_chars);
         }
+
+        template<typename Hasher>
+        static constexpr void fingerprint(TokenDescriptor const& _tokenDescriptor, Hasher& _hasher) {
+            if constexpr (char_traits_detail::has_fingerprint_v<TokenDescriptor, Hasher>) _tokenDescriptor.fingerprint(_hasher);
+        }
     };
 
     template<typename Token>
@@ -104,6 +143,23 @@ namespace randomcat::parser {
 
         constexpr priority_type priority() const noexcept { return m_priority; }
 
+        constexpr size_type max_match_size() const noexcept { return m_string.size(); }
+
+        // Lets dfa_tokenizer (see dfa_tokenizer.hpp) match the string in its automaton instead of calling parse_first_token
+        template<typename DfaBuilder>
+        void add_to_dfa(DfaBuilder& _builder) const {
+            _builder.add_literal(m_string, m_priority);
+        }
+
+        constexpr token_type dfa_token(string_view_type) const { return m_token; }
+
+        template<typename Hasher>
+        constexpr void fingerprint(Hasher& _hasher) const {
+            _hasher(m_token);
+            _hasher(m_priority);
+            _hasher(m_string);
+        }
+
     private:
         size_type size() const noexcept { return m_string.size(); }
 
@@ -140,6 +196,25 @@ namespace randomcat::parser {
 
         constexpr auto priority() const noexcept { return m_priority; }
 
+        constexpr size_type max_match_size() const noexcept {
+            return std::apply([](auto const&... strings) { return std::max({size_type(0), size_type(size(strings))...}); }, m_strings);
+        }
+
+        // Every form is one pattern of the automaton, see simple_token_descriptor::add_to_dfa
+        template<typename DfaBuilder>
+        void add_to_dfa(DfaBuilder& _builder) const {
+            std::apply([&](auto const&... strings) { _builder.add_literals(m_priority, strings...); }, m_strings);
+        }
+
+        constexpr token_type dfa_token(string_view_type) const { return m_token; }
+
+        template<typename Hasher>
+        constexpr void fingerprint(Hasher& _hasher) const {
+            _hasher(m_token);
+            _hasher(m_priority);
+            std::apply([&](auto const&... strings) { (_hasher(strings), ...); }, m_strings);
+        }
+
     private:
         static constexpr auto num_strings = sizeof...(Strings);
 
@@ -175,12 +250,84 @@ namespace randomcat::parser {
         return multi_form_token_descriptor<Token, util_detail::first_t<std::string, Strings>...>(_token, _priority, std::forward<Strings>(_strings)...);
     }
 
-    template<typename Token, typename... TokenParsers>
-    class simple_tokenizer {
+    // Whether a delimited token includes its closing delimiter or leaves it to be lexed as the next token
+    enum class closing_delimiter : std::uint8_t { consumed, left };
+
+    // Matches _open and everything after it up to _close as a single token, or up to the end of the input if _close does not occur.
+    // The chars in between are never lexed: once _open matches, the tokenizer is in effect in a "skip until _close" mode, and the
+    // body is found with one char_source_traits::find. Meant for comments, whose contents would otherwise be lexed only to be dropped.
+    template<typename Token>
+    class delimited_token_descriptor {
     public:
         using token_type = Token;
+        using char_type = char_traits_detail::char_type_t<Token>;
+        using char_traits_type = char_traits_detail::char_traits_type_t<Token>;
+
+        using string_type = char_traits_detail::string_type_t<Token>;
+        using string_view_type = char_traits_detail::string_view_type_t<Token>;
+
+        using error_type = no_matching_token_t;
 
-        using error_type = std::tuple<typename token_descriptor_traits<TokenParsers>::error_type...>;
+        using parse_result_type = parse_result<token_type, error_type>;
+
+        using priority_type = default_priority_type;
+        using size_type = char_traits_detail::size_type_t<string_type>;
+
+        constexpr explicit delimited_token_descriptor(token_type _token,
+                                                      string_type _open,
+                                                      string_type _close,
+                                                      closing_delimiter _closing = closing_delimiter::consumed) noexcept
+        // This is okay, since braced-init-list rules guarantee left-to-right evalution
+        : delimited_token_descriptor{_token, gsl::narrow<priority_type>(_open.size()), std::move(_open), std::move(_close), _closing} {}
+
+        constexpr delimited_token_descriptor(token_type _token,
+                                             priority_type _priority,
+                                             string_type _open,
+                                             string_type _close,
+                                             closing_delimiter _closing = closing_delimiter::consumed) noexcept
+        : m_open(std::move(_open)), m_close(std::move(_close)), m_token(std::move(_token)), m_priority(std::move(_priority)), m_closing(_closing) {}
+
+        template<typename CharSource>
+        constexpr parse_result_type parse_first_token(CharSource const& _chars) const noexcept {
+            typename char_source_traits<CharSource>::access_wrapper accessWrapper(_chars);
+
+            if (not accessWrapper.expect(m_open)) return no_matching_token;
+
+            accessWrapper.advance_head(accessWrapper.find(m_close));
+            if (m_closing == closing_delimiter::consumed && not accessWrapper.at_end()) accessWrapper.advance_head(m_close.size());
+
+            return {m_token, accessWrapper.chars_parsed()};
+        }
+
+        constexpr priority_type priority() const noexcept { return m_priority; }
+
+        template<typename Hasher>
+        constexpr void fingerprint(Hasher& _hasher) const {
+            _hasher(m_token);
+            _hasher(m_priority);
+            _hasher(m_open);
+            _hasher(m_close);
+            _hasher(m_closing);
+        }
+
+    private:
+        string_type m_open;
+        string_type m_close;
+        token_type m_token;
+        priority_type m_priority;
+        closing_delimiter m_closing;
+    };
+
+    // Stats is a stats policy (see diagnostics/stats.hpp) told about every descriptor attempt and rejection.
+    // ErrorPolicy (see error_policy.hpp) decides whether a failure reports every descriptor's error.
+    template<typename Stats, typename ErrorPolicy, typename Token, typename... TokenParsers>
+    class basic_simple_tokenizer {
+    public:
+        using token_type = Token;
+
+        using error_policy = ErrorPolicy;
+        using aggregate_error_type = std::tuple<typename token_descriptor_traits<TokenParsers>::error_type...>;
+        using error_type = typename error_policy::template error_type<aggregate_error_type>;
         using parse_result_type = parse_result<token_type, error_type>;
 
         static_assert(util_detail::all_are_same_v<char_traits_detail::char_type_t<Token>, char_traits_detail::char_type_t<TokenParsers>...>);
@@ -200,13 +347,48 @@ namespace randomcat::parser {
 
         static inline constexpr auto token_parser_count = sizeof...(TokenParsers);
 
-        explicit constexpr simple_tokenizer(TokenParsers... _parsers) : m_descriptors(std::move(_parsers)...) {}
+        using stats_type = Stats;
 
+        explicit constexpr basic_simple_tokenizer(TokenParsers... _parsers)
+        : m_descriptors(std::move(_parsers)...), m_order(make_evaluation_order(m_descriptors)) {}
+
+        explicit constexpr basic_simple_tokenizer(stats_type _stats, TokenParsers... _parsers)
+        : m_descriptors(std::move(_parsers)...), m_stats(std::move(_stats)), m_order(make_evaluation_order(m_descriptors)) {}
+
+        // Descriptors are tried from the highest priority down, stopping at the first match once no remaining descriptor could
+        // outrank it. Among matches of equal priority the longest wins, and of those the first declared.
         template<typename CharSource>
-        constexpr parse_result_type parse_first_token(CharSource const& _input) const noexcept {
+        parse_result_type parse_first_token(CharSource const& _input) const noexcept {
             return parse_first_token_helper(std::make_index_sequence<token_parser_count>(), _input);
         }
 
+        template<typename Hasher>
+        constexpr void fingerprint(Hasher& _hasher) const {
+            std::apply([&](auto const&... descriptors) { (token_descriptor_traits<TokenParsers>::fingerprint(descriptors, _hasher), ...); }, m_descriptors);
+        }
+
+        // The same tokenizer, reporting to another stats policy
+        template<typename NewStats>
+        constexpr basic_simple_tokenizer<NewStats, ErrorPolicy, Token, TokenParsers...> with_stats(NewStats _stats) const {
+            return std::apply(
+                [&](auto const&... descriptors) {
+                    return basic_simple_tokenizer<NewStats, ErrorPolicy, Token, TokenParsers...>(std::move(_stats), descriptors...);
+                },
+                m_descriptors);
+        }
+
+        // The same tokenizer with another error policy, e.g. make_tokenizer().with_error_policy<fast_fail_errors>()
+        template<typename NewErrorPolicy>
+        constexpr basic_simple_tokenizer<Stats, NewErrorPolicy, Token, TokenParsers...> with_error_policy() const {
+            return std::apply(
+                [&](auto const&... descriptors) {
+                    return basic_simple_tokenizer<Stats, NewErrorPolicy, Token, TokenParsers...>(m_stats, descriptors...);
+                },
+                m_descriptors);
+        }
+
+        constexpr stats_type const& stats() const noexcept { return m_stats; }
+
     private:
         static_assert(util_detail::all_are_same_v<char_traits_detail::priority_type_t<token_descriptor_traits<TokenParsers>>...>);
         static_assert(sizeof...(TokenParsers) > 0);
@@ -219,52 +401,143 @@ namespace randomcat::parser {
             size_type size;
         };
 
+        // The order descriptors are tried in: by descending priority, and in declaration order among equal priorities
+        struct evaluation_order {
+            std::array<std::size_t, token_parser_count> indices;
+
+            // priorities[k] and maxSizes[k] belong to the descriptor indices[k]
+            std::array<priority_type, token_parser_count> priorities;
+            std::array<size_type, token_parser_count> maxSizes;
+        };
+
+        static constexpr evaluation_order sort_by_priority(std::array<priority_type, token_parser_count> const& _priorities,
+                                                           std::array<size_type, token_parser_count> const& _maxSizes) noexcept {
+            evaluation_order order = {};
+
+            // Insertion sort, which is stable
+            for (std::size_t i = 0; i < token_parser_count; ++i) {
+                auto k = i;
+
+                for (; k > 0 && order.priorities[k - 1] < _priorities[i]; --k) {
+                    order.indices[k] = order.indices[k - 1];
+                    order.priorities[k] = order.priorities[k - 1];
+                    order.maxSizes[k] = order.maxSizes[k - 1];
+                }
+
+                order.indices[k] = i;
+                order.priorities[k] = _priorities[i];
+                order.maxSizes[k] = _maxSizes[i];
+            }
+
+            return order;
+        }
+
+        static constexpr evaluation_order make_evaluation_order(std::tuple<TokenParsers...> const& _descriptors) noexcept {
+            return std::apply(
+                [](auto const&... descriptors) {
+                    std::array<size_type, token_parser_count> const maxSizes = {token_descriptor_traits<TokenParsers>::max_match_size(descriptors)...};
+
+                    if constexpr ((token_descriptor_traits<TokenParsers>::has_static_priority && ...)) {
+                        // Sorted while compiling; only the sizes are filled in afterwards
+                        constexpr auto order = sort_by_priority({TokenParsers::priority()...}, {});
+
+                        auto result = order;
+                        for (std::size_t k = 0; k < token_parser_count; ++k) result.maxSizes[k] = maxSizes[order.indices[k]];
+                        return result;
+                    } else {
+                        return sort_by_priority({token_descriptor_traits<TokenParsers>::priority(descriptors)...}, maxSizes);
+                    }
+                },
+                _descriptors);
+        }
+
+        using errors_type = std::tuple<std::optional<typename token_descriptor_traits<TokenParsers>::error_type>...>;
+
+        struct attempt_state {
+            std::optional<max_token_t> best;
+
+            // Only filled in if the error policy aggregates
+            std::conditional_t<error_policy::aggregates, errors_type, std::tuple<>> errors;
+        };
+
+        template<std::size_t I, typename CharSource>
+        static void attempt(basic_simple_tokenizer const& _tokenizer, CharSource const& _chars, priority_type _priority, attempt_state& _state) noexcept {
+            using descriptor_traits = token_descriptor_traits<std::tuple_element_t<I, std::tuple<TokenParsers...>>>;
+
+            _tokenizer.m_stats.descriptor_attempted(I);
+
+            auto tokenResult = descriptor_traits::parse_first_token(std::get<I>(_tokenizer.m_descriptors), _chars);
+            if (tokenResult) {
+                auto const size = tokenResult.amount_parsed();
+
+                // Only descriptors of the best priority so far are tried once there is a match, so this is the longest-match tie-break
+                if (not _state.best || size > _state.best->size) _state.best = {std::move(tokenResult).value(), _priority, size};
+            } else {
+                _tokenizer.m_stats.descriptor_rejected(I);
+                if constexpr (error_policy::aggregates) std::get<I>(_state.errors) = std::move(tokenResult).error();
+            }
+        }
+
         template<std::size_t... Is, typename CharSource>
-        constexpr parse_result_type parse_first_token_helper(std::index_sequence<Is...>, CharSource const& _chars) const noexcept {
-            std::optional<max_token_t> maxToken;
+        parse_result_type parse_first_token_helper(std::index_sequence<Is...>, CharSource const& _chars) const noexcept {
+            using attempt_function = void (*)(basic_simple_tokenizer const&, CharSource const&, priority_type, attempt_state&) noexcept;
+            static constexpr attempt_function attempts[] = {&basic_simple_tokenizer::attempt<Is, CharSource>...};
 
-            std::tuple<std::optional<typename token_descriptor_traits<TokenParsers>::error_type>...> errors;
+            attempt_state state;
 
-            ((
-                 [&](auto const& tokenDescriptor) {
-                     using descriptor_traits = token_descriptor_traits<std::tuple_element_t<Is, decltype(m_descriptors)>>;
-                     auto const priority = descriptor_traits::priority(tokenDescriptor);
-                     if (maxToken.has_value() && (priority <= maxToken->priority)) return;
-
-                     auto tokenResult = descriptor_traits::parse_first_token(tokenDescriptor, _chars);
-                     if (tokenResult) {
-                         auto const token = tokenResult.value();
-                         maxToken = {token, priority, tokenResult.amount_parsed()};
-                     } else {
-                         std::get<Is>(errors) = tokenResult.error();
-                     }
-                 }(std::get<Is>(m_descriptors)),
-                 void()),
-             ...);
+            for (std::size_t k = 0; k < token_parser_count; ++k) {
+                auto const priority = m_order.priorities[k];
+
+                if (state.best) {
+                    // The rest all have lower priorities
+                    if (priority < state.best->priority) break;
 
-            if (not maxToken) return error_type{std::move(std::get<Is>(errors)).value()...};
+                    // Could at most tie with the match
+                    if (m_order.maxSizes[k] <= state.best->size) continue;
+                }
 
-            return {maxToken->token, maxToken->size};
+                attempts[m_order.indices[k]](*this, _chars, priority, state);
+            }
+
+            if (not state.best) {
+                if constexpr (error_policy::aggregates) {
+                    return error_type{std::move(std::get<Is>(state.errors)).value()...};
+                } else {
+                    // Every descriptor failed at the start
+                    return error_policy::failure(0);
+                }
+            }
+
+            return {std::move(state.best->token), state.best->size};
         }
 
         std::tuple<TokenParsers...> m_descriptors;
+        stats_type m_stats;
+        evaluation_order m_order;
     };
 
+    template<typename Token, typename... TokenParsers>
+    using simple_tokenizer = basic_simple_tokenizer<no_stats, aggregate_errors, Token, TokenParsers...>;
+
     template<typename Token, typename... TokenDescriptions>
     constexpr inline simple_tokenizer<Token, TokenDescriptions...> make_simple_tokenizer(TokenDescriptions... _parsers) {
         return simple_tokenizer<Token, TokenDescriptions...>(std::move(_parsers)...);
     }
 
-    template<typename Tokenizer, typename CharSource>
-    constexpr inline parse_result<std::vector<typename tokenizer_traits<Tokenizer>::token_type>, typename tokenizer_traits<Tokenizer>::error_type> tokenize(
-        Tokenizer const& _tokenizer,
-        CharSource const& _chars) {
+    // _allocator backs the returned tokens, e.g. a std::pmr::polymorphic_allocator over scratch memory that is copied out of
+    template<typename Tokenizer, typename CharSource, typename Allocator = std::allocator<typename tokenizer_traits<Tokenizer>::token_type>>
+    constexpr inline parse_result<std::vector<typename tokenizer_traits<Tokenizer>::token_type, Allocator>, typename tokenizer_traits<Tokenizer>::error_type>
+    tokenize(Tokenizer const& _tokenizer, CharSource const& _chars, Allocator const& _allocator = Allocator()) {
         using token_type = char_traits_detail::token_type_t<tokenizer_traits<Tokenizer>>;
         using source_traits = char_source_traits<CharSource>;
 
+#ifdef RANDOMCAT_PARSER_TRACING
+        trace_span span(trace_category::tokenize, "tokenize");
+#endif
+
         typename source_traits::access_wrapper accessWrapper(_chars);
 
-        std::vector<token_type> tokens;
+        std::vector<token_type, Allocator> tokens(_allocator);
 
         while (not accessWrapper.at_end()) {
             auto tokenResult = accessWrapper.sub_parse([&](CharSource const& source) -> decltype(auto) {
@@ -275,7 +548,12 @@ namespace randomcat::parser {
                 tokens.push_back(tokenResult.value());
                 accessWrapper.advance_head(tokenResult.amount_parsed());
             } else {
-                return tokenResult.error();
+                auto error = std::move(tokenResult).error();
+
+                // Relative to the start of the whole input rather than the failed token
+                if constexpr (std::is_same_v<decltype(error), farthest_failure>) error.position += accessWrapper.chars_parsed();
+
+                return error;
             }
         }
 
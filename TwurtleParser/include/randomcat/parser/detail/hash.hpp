@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace randomcat::parser::hash_detail {
+    constexpr inline std::uint64_t rotate_left(std::uint64_t _value, int _amount) noexcept {
+        return (_value << _amount) | (_value >> (64 - _amount));
+    }
+
+    // The finalizer of MurmurHash3
+    constexpr inline std::uint64_t mix(std::uint64_t _value) noexcept {
+        _value ^= _value >> 33;
+        _value *= 0xff51afd7ed558ccdULL;
+        _value ^= _value >> 33;
+        _value *= 0xc4ceb9fe1a85ec53ULL;
+        _value ^= _value >> 33;
+        return _value;
+    }
+
+    constexpr inline std::uint64_t combine(std::uint64_t _seed, std::uint64_t _value) noexcept {
+        return mix(rotate_left(_seed, 27) * 5 + 0x52dce729 + mix(_value));
+    }
+
+    // Not cryptographic; consumes 8 bytes per step, which is enough to key caches by file contents
+    inline std::uint64_t hash_bytes(void const* _data, std::size_t _size, std::uint64_t _seed = 0) noexcept {
+        auto const bytes = static_cast<unsigned char const*>(_data);
+        auto hash = combine(_seed, _size);
+
+        std::size_t i = 0;
+        for (; i + 8 <= _size; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            hash = rotate_left(hash ^ (word * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+        }
+
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, bytes + i, _size - i);
+
+        return mix(hash ^ (tail * 0x87c37b91114253d5ULL));
+    }
+
+    inline std::uint64_t hash_string(std::string_view _string, std::uint64_t _seed = 0) noexcept {
+        return hash_bytes(_string.data(), _string.size(), _seed);
+    }
+}    // namespace randomcat::parser::hash_detail
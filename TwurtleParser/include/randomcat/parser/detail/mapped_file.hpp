@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace randomcat::parser::file_detail {
+    // A read-only private mapping of a whole file
+    class mapped_file {
+    public:
+        mapped_file() noexcept = default;
+
+        mapped_file(mapped_file const&) = delete;
+        mapped_file& operator=(mapped_file const&) = delete;
+
+        mapped_file(mapped_file&& _other) noexcept
+        : m_data(std::exchange(_other.m_data, nullptr)), m_size(std::exchange(_other.m_size, 0)) {}
+
+        mapped_file& operator=(mapped_file&& _other) noexcept {
+            mapped_file(std::move(_other)).swap(*this);
+            return *this;
+        }
+
+        ~mapped_file() noexcept {
+            if (m_data) ::munmap(m_data, m_size);
+        }
+
+        // Returns an empty mapping if the file cannot be mapped (including if it is empty)
+        static mapped_file open(std::string const& _path) noexcept {
+            auto const fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return {};
+
+            mapped_file result;
+
+            struct stat info;
+            if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+                auto const size = static_cast<std::size_t>(info.st_size);
+                auto const data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (data != MAP_FAILED) {
+                    result.m_data = data;
+                    result.m_size = size;
+                }
+            }
+
+            ::close(fd);
+            return result;
+        }
+
+        explicit operator bool() const noexcept { return m_data != nullptr; }
+
+        std::byte const* data() const noexcept { return static_cast<std::byte const*>(m_data); }
+        std::size_t size() const noexcept { return m_size; }
+
+        void swap(mapped_file& _other) noexcept {
+            std::swap(m_data, _other.m_data);
+            std::swap(m_size, _other.m_size);
+        }
+
+    private:
+        void* m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+}    // namespace randomcat::parser::file_detail
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "randomcat/parser/detail/waiter.hpp"
+
+namespace randomcat::parser::spsc_detail {
+    // Keeps the producer's and the consumer's index on separate cache lines, so that neither write invalidates the other's reads
+    inline constexpr std::size_t cache_line_size = 64;
+
+    // A bounded ring of T with one producer thread and one consumer thread and no locks on the fast path: each index is only
+    // written by one side, which publishes slots to the other with a release store. A side that has to wait for the other spins
+    // briefly and then blocks (see wait_detail::waiter), so a stalled peer costs no CPU.
+    template<typename T>
+    class spsc_ring {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        spsc_ring(spsc_ring const&) = delete;
+        spsc_ring(spsc_ring&&) = delete;
+        spsc_ring& operator=(spsc_ring const&) = delete;
+        spsc_ring& operator=(spsc_ring&&) = delete;
+
+        explicit spsc_ring(size_type _capacity) : m_slots(_capacity) {
+            if (_capacity == 0) throw std::invalid_argument("spsc_ring capacity must be positive");
+        }
+
+        size_type capacity() const noexcept { return m_slots.size(); }
+
+        // Producer side; leaves _value alone and returns false if the ring is full
+        bool try_push(value_type& _value) {
+            auto const tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) return false;
+
+            m_slots[tail % m_slots.size()] = std::move(_value);
+            m_tail.store(tail + 1, std::memory_order_release);
+            m_notEmpty.notify();
+            return true;
+        }
+
+        // Producer side; waits for a free slot, which is how the consumer applies backpressure. Returns false without pushing if
+        // _stop is set while waiting, which whoever sets it must follow with wake_producer.
+        bool push(value_type _value, std::atomic<bool> const& _stop) {
+            while (not try_push(_value)) {
+                m_notFull.wait([&] { return not full() || _stop.load(std::memory_order_relaxed); });
+                if (_stop.load(std::memory_order_relaxed)) return false;
+            }
+
+            return true;
+        }
+
+        // Wakes a producer waiting in push, so that it sees its stop flag
+        void wake_producer() { m_notFull.notify(); }
+
+        // Consumer side; returns false if the ring is empty
+        bool try_pop(value_type& _out) {
+            auto const head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire)) return false;
+
+            _out = std::move(m_slots[head % m_slots.size()]);
+            m_head.store(head + 1, std::memory_order_release);
+            m_notFull.notify();
+            return true;
+        }
+
+        // Consumer side; waits until there is a value
+        value_type pop() {
+            value_type result;
+            while (not try_pop(result)) m_notEmpty.wait([&] { return not empty(); });
+            return result;
+        }
+
+    private:
+        // Producer side
+        bool full() const noexcept {
+            return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) == m_slots.size();
+        }
+
+        // Consumer side
+        bool empty() const noexcept { return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire); }
+
+        std::vector<value_type> m_slots;
+
+        alignas(cache_line_size) std::atomic<size_type> m_head = 0;
+        alignas(cache_line_size) std::atomic<size_type> m_tail = 0;
+
+        // Waited on by the consumer and the producer respectively
+        wait_detail::waiter m_notEmpty;
+        wait_detail::waiter m_notFull;
+    };
+}    // namespace randomcat::parser::spsc_detail
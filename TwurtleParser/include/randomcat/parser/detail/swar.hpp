@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// SIMD within a register: treating a 64 bit word as 8 bytes processed at once
+namespace randomcat::parser::swar_detail {
+    inline constexpr std::uint64_t low_bits = 0x0101010101010101;
+    inline constexpr std::uint64_t high_bits = 0x8080808080808080;
+
+    // The 8 chars at _chars as a little endian word, so the first char is the lowest byte
+    inline std::uint64_t load_eight(char const* _chars) noexcept {
+        std::uint64_t result;
+        std::memcpy(&result, _chars, sizeof(result));
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        result = __builtin_bswap64(result);
+#endif
+
+        return result;
+    }
+
+    constexpr std::uint64_t broadcast(unsigned char _byte) noexcept { return low_bits * _byte; }
+
+    // The high bit of each byte of _word below _bound, which must be at most 0x80. Bytes above the first such byte may be marked
+    // even if they are not below _bound (the subtraction borrows into them), so only the lowest marked byte is reliable.
+    constexpr std::uint64_t bytes_below(std::uint64_t _word, unsigned char _bound) noexcept {
+        return (_word - broadcast(_bound)) & ~_word & high_bits;
+    }
+
+    // The high bit of each byte of _word that is _byte, with bytes_below's caveat
+    constexpr std::uint64_t bytes_equal(std::uint64_t _word, unsigned char _byte) noexcept { return bytes_below(_word ^ broadcast(_byte), 1); }
+
+    // The high bit of each byte of _word that is _byte, reliable for every byte (unlike bytes_equal) at the cost of a few more
+    // operations: adding 0x7F to the low 7 bits of a byte sets its high bit if and only if they are nonzero, without carrying out
+    constexpr std::uint64_t bytes_equal_exact(std::uint64_t _word, unsigned char _byte) noexcept {
+        auto const differences = _word ^ broadcast(_byte);
+        return ~(((differences & ~high_bits) + ~high_bits) | differences) & high_bits;
+    }
+
+    // One bit per byte of the result of bytes_equal_exact, the lowest byte's in bit 0
+    constexpr unsigned marked_bytes_mask(std::uint64_t _marks) noexcept {
+        return static_cast<unsigned>(((_marks >> 7) * 0x0102040810204080) >> 56);
+    }
+
+    // The index of the lowest marked byte of a nonzero result of bytes_below or bytes_equal
+    constexpr std::size_t first_marked_byte(std::uint64_t _marks) noexcept { return static_cast<std::size_t>(__builtin_ctzll(_marks)) / 8; }
+}    // namespace randomcat::parser::swar_detail
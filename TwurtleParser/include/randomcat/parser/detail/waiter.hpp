@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace randomcat::parser::wait_detail {
+    // Lets one thread wait for a condition that another thread makes true and then calls notify. Waiters spin for a while first,
+    // since handoffs between a producer and a consumer that keep up with each other are short, and then block, so that a thread
+    // waiting on a stalled peer costs no CPU. notify only takes the lock when a thread is blocked.
+    class waiter {
+    public:
+        static inline constexpr std::size_t spin_count = 64;
+
+        waiter() = default;
+
+        waiter(waiter const&) = delete;
+        waiter(waiter&&) = delete;
+        waiter& operator=(waiter const&) = delete;
+        waiter& operator=(waiter&&) = delete;
+
+        // Returns once _ready() returns true; _ready must only read state that is changed before notify is called
+        template<typename Ready>
+        void wait(Ready&& _ready) {
+            for (std::size_t i = 0; i < spin_count; ++i) {
+                if (_ready()) return;
+                std::this_thread::yield();
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            // Pairs with the fence in notify: either notify sees this sleeper, or _ready sees what was changed before notify
+            m_sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            m_condition.wait(lock, _ready);
+
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleepers.load(std::memory_order_relaxed) == 0) return;
+
+            // Taking the lock orders this notify after a sleeper that has checked _ready but not yet started waiting
+            { std::lock_guard<std::mutex> lock(m_mutex); }
+            m_condition.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::atomic<std::size_t> m_sleepers = 0;
+    };
+}    // namespace randomcat::parser::wait_detail
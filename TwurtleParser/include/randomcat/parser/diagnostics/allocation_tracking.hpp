@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace randomcat::parser {
+    struct allocation_counts {
+        std::uint64_t allocations = 0;
+        std::uint64_t deallocations = 0;
+        std::uint64_t bytes_allocated = 0;
+        std::uint64_t bytes_deallocated = 0;
+
+        // The most bytes that were allocated inside the scope and not freed yet at any one time
+        std::uint64_t peak_live_bytes = 0;
+    };
+
+    class allocation_scope;
+
+    // Called by the counting operator new and delete; custom allocators may report through these too
+    inline void record_allocation(std::size_t _size) noexcept;
+    inline void record_deallocation(std::size_t _size) noexcept;
+
+    namespace allocation_detail {
+        struct thread_state {
+            // Bytes allocated minus bytes freed on this thread; memory freed on another thread than it was allocated on makes this drift
+            std::int64_t liveBytes = 0;
+            allocation_scope* innermost = nullptr;
+        };
+
+        inline thread_local thread_state t_state;
+
+        inline std::atomic<bool> counting_installed = false;
+    }    // namespace allocation_detail
+
+    // Whether allocations are reported at all, i.e. whether counting_operator_new.hpp is part of the program.
+    // If not, every allocation_scope counts zero.
+    inline bool allocation_counting_installed() noexcept { return allocation_detail::counting_installed.load(std::memory_order_relaxed); }
+
+    // Counts the allocations made on the current thread during its lifetime, including those in nested scopes.
+    // Scopes nest, so a whole parse and each of its phases can be measured at once; they must be destroyed in reverse order.
+    class allocation_scope {
+    public:
+        allocation_scope(allocation_scope const&) = delete;
+        allocation_scope& operator=(allocation_scope const&) = delete;
+
+        allocation_scope() noexcept : m_outer(allocation_detail::t_state.innermost), m_startLiveBytes(allocation_detail::t_state.liveBytes) {
+            allocation_detail::t_state.innermost = this;
+        }
+
+        ~allocation_scope() noexcept { allocation_detail::t_state.innermost = m_outer; }
+
+        allocation_counts const& counts() const noexcept { return m_counts; }
+
+    private:
+        friend void record_allocation(std::size_t _size) noexcept;
+        friend void record_deallocation(std::size_t _size) noexcept;
+
+        allocation_scope* m_outer;
+        std::int64_t m_startLiveBytes;
+        allocation_counts m_counts;
+    };
+
+    inline void record_allocation(std::size_t _size) noexcept {
+        auto& state = allocation_detail::t_state;
+        state.liveBytes += static_cast<std::int64_t>(_size);
+
+        for (auto* scope = state.innermost; scope; scope = scope->m_outer) {
+            auto& counts = scope->m_counts;
+            ++counts.allocations;
+            counts.bytes_allocated += _size;
+
+            auto const live = state.liveBytes - scope->m_startLiveBytes;
+            if (live > 0) counts.peak_live_bytes = std::max(counts.peak_live_bytes, static_cast<std::uint64_t>(live));
+        }
+    }
+
+    inline void record_deallocation(std::size_t _size) noexcept {
+        auto& state = allocation_detail::t_state;
+        state.liveBytes -= static_cast<std::int64_t>(_size);
+
+        for (auto* scope = state.innermost; scope; scope = scope->m_outer) {
+            ++scope->m_counts.deallocations;
+            scope->m_counts.bytes_deallocated += _size;
+        }
+    }
+}    // namespace randomcat::parser
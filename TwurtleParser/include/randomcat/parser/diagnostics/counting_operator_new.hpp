@@ -0,0 +1,143 @@
+#pragma once
+
+// Replaces the global operator new and delete with versions that report every allocation to allocation_scope.
+// Include this in exactly one translation unit of a program (e.g. next to main()); the rest of the program
+// only needs allocation_tracking.hpp.
+//
+// Most allocations made while parsing (strings in descriptors and tokens, std::any payloads, grammar tree nodes) go through
+// std::allocator, so replacing operator new is the one place they can all be seen without changing those types.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "randomcat/parser/diagnostics/allocation_tracking.hpp"
+
+namespace randomcat::parser::allocation_detail {
+    // Every block starts with a header holding the requested size, padded so the user's memory keeps its alignment
+    inline constexpr std::size_t default_header_size = alignof(std::max_align_t);
+
+    inline void* counted_allocate(std::size_t _size, std::size_t _alignment) noexcept {
+        auto const headerSize = std::max(_alignment, default_header_size);
+
+        void* block = nullptr;
+        if (_alignment <= default_header_size) {
+            block = std::malloc(_size + headerSize);
+        } else {
+            // aligned_alloc needs a multiple of the alignment
+            block = std::aligned_alloc(_alignment, (_size + headerSize + _alignment - 1) / _alignment * _alignment);
+        }
+
+        if (not block) return nullptr;
+
+        auto* const memory = static_cast<std::byte*>(block) + headerSize;
+        reinterpret_cast<std::size_t*>(memory)[-1] = _size;
+
+        record_allocation(_size);
+        return memory;
+    }
+
+    inline void counted_free(void* _memory, std::size_t _alignment) noexcept {
+        if (not _memory) return;
+
+        auto const headerSize = std::max(_alignment, default_header_size);
+        record_deallocation(static_cast<std::size_t*>(_memory)[-1]);
+
+        std::free(static_cast<std::byte*>(_memory) - headerSize);
+    }
+
+    inline void* counted_allocate_or_throw(std::size_t _size, std::size_t _alignment) {
+        while (true) {
+            if (auto* const memory = counted_allocate(_size, _alignment)) return memory;
+
+            auto const handler = std::get_new_handler();
+            if (not handler) throw std::bad_alloc();
+
+            handler();
+        }
+    }
+
+    inline bool const counting_registered = (counting_installed.store(true, std::memory_order_relaxed), true);
+}    // namespace randomcat::parser::allocation_detail
+
+void* operator new(std::size_t _size) {
+    return randomcat::parser::allocation_detail::counted_allocate_or_throw(_size, 0);
+}
+
+void* operator new[](std::size_t _size) {
+    return randomcat::parser::allocation_detail::counted_allocate_or_throw(_size, 0);
+}
+
+void* operator new(std::size_t _size, std::align_val_t _alignment) {
+    return randomcat::parser::allocation_detail::counted_allocate_or_throw(_size, static_cast<std::size_t>(_alignment));
+}
+
+void* operator new[](std::size_t _size, std::align_val_t _alignment) {
+    return randomcat::parser::allocation_detail::counted_allocate_or_throw(_size, static_cast<std::size_t>(_alignment));
+}
+
+void* operator new(std::size_t _size, std::nothrow_t const&) noexcept {
+    return randomcat::parser::allocation_detail::counted_allocate(_size, 0);
+}
+
+void* operator new[](std::size_t _size, std::nothrow_t const&) noexcept {
+    return randomcat::parser::allocation_detail::counted_allocate(_size, 0);
+}
+
+void* operator new(std::size_t _size, std::align_val_t _alignment, std::nothrow_t const&) noexcept {
+    return randomcat::parser::allocation_detail::counted_allocate(_size, static_cast<std::size_t>(_alignment));
+}
+
+void* operator new[](std::size_t _size, std::align_val_t _alignment, std::nothrow_t const&) noexcept {
+    return randomcat::parser::allocation_detail::counted_allocate(_size, static_cast<std::size_t>(_alignment));
+}
+
+void operator delete(void* _memory) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, 0);
+}
+
+void operator delete[](void* _memory) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, 0);
+}
+
+void operator delete(void* _memory, std::size_t) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, 0);
+}
+
+void operator delete[](void* _memory, std::size_t) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, 0);
+}
+
+void operator delete(void* _memory, std::align_val_t _alignment) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, static_cast<std::size_t>(_alignment));
+}
+
+void operator delete[](void* _memory, std::align_val_t _alignment) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, static_cast<std::size_t>(_alignment));
+}
+
+void operator delete(void* _memory, std::size_t, std::align_val_t _alignment) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, static_cast<std::size_t>(_alignment));
+}
+
+void operator delete[](void* _memory, std::size_t, std::align_val_t _alignment) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, static_cast<std::size_t>(_alignment));
+}
+
+void operator delete(void* _memory, std::nothrow_t const&) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, 0);
+}
+
+void operator delete[](void* _memory, std::nothrow_t const&) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, 0);
+}
+
+void operator delete(void* _memory, std::align_val_t _alignment, std::nothrow_t const&) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, static_cast<std::size_t>(_alignment));
+}
+
+void operator delete[](void* _memory, std::align_val_t _alignment, std::nothrow_t const&) noexcept {
+    randomcat::parser::allocation_detail::counted_free(_memory, static_cast<std::size_t>(_alignment));
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#    include <cxxabi.h>
+#endif
+
+namespace randomcat::parser {
+    struct grammar_rule_profile {
+        std::string name;
+
+        std::uint64_t calls = 0;
+        std::uint64_t successes = 0;
+        std::uint64_t failures = 0;
+
+        // Tokens matched by successful calls
+        std::uint64_t tokens_consumed = 0;
+
+        // Tokens matched by tagged sub-rules that this rule threw away: everything they matched if the call failed, and whatever
+        // they matched beyond the call's own match if it succeeded (i.e. alternatives that were abandoned)
+        std::uint64_t tokens_backtracked = 0;
+
+        // Inclusive time is only counted for the outermost call of a recursive rule, so it never exceeds the wall time
+        std::chrono::nanoseconds inclusive_time = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds exclusive_time = std::chrono::nanoseconds::zero();
+    };
+
+    namespace grammar_profiler_detail {
+        template<typename Tag, typename = void>
+        struct has_name : std::false_type {};
+
+        template<typename Tag>
+        struct has_name<Tag, std::void_t<decltype(std::string_view(Tag::name))>> : std::true_type {};
+
+        template<typename Tag>
+        std::string tag_name() {
+            if constexpr (has_name<Tag>::value) {
+                return std::string(std::string_view(Tag::name));
+            } else {
+                auto const mangled = typeid(Tag).name();
+
+#if __has_include(<cxxabi.h>)
+                int status = 0;
+                auto const demangled = std::unique_ptr<char, void (*)(void*)>(abi::__cxa_demangle(mangled, nullptr, nullptr, &status), std::free);
+                if (status == 0 && demangled) return demangled.get();
+#endif
+
+                return mangled;
+            }
+        }
+
+        // The rule name for a tag list is its tags' names joined by ", "; tags may name themselves with a static name member
+        template<typename... Tags>
+        std::string const& rule_name() {
+            static std::string const name = [] {
+                std::string result;
+                ((result += (result.empty() ? "" : ", ") + tag_name<Tags>()), ...);
+                return result;
+            }();
+
+            return name;
+        }
+    }    // namespace grammar_profiler_detail
+
+    // Collects a grammar_rule_profile for every tagged grammar (see tag_grammar_t) tested on a thread where this profiler is
+    // installed with a grammar_profiling_scope. Only has an effect when RANDOMCAT_PARSER_GRAMMAR_PROFILING is defined.
+    class grammar_profiler {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        grammar_profiler() = default;
+
+        grammar_profiler(grammar_profiler const&) = delete;
+        grammar_profiler& operator=(grammar_profiler const&) = delete;
+
+        static grammar_profiler* current() noexcept { return t_current; }
+
+        // Records one call of a rule from construction until finish() (or destruction, which records a failure)
+        class rule_call {
+        public:
+            rule_call(rule_call const&) = delete;
+            rule_call& operator=(rule_call const&) = delete;
+
+            explicit rule_call(grammar_profiler& _profiler, std::string const& _name) : m_profiler(_profiler) { m_profiler.enter(_name); }
+
+            ~rule_call() noexcept {
+                if (not m_finished) m_profiler.exit(false, 0);
+            }
+
+            void finish(bool _success, std::uint64_t _tokensConsumed) noexcept {
+                m_finished = true;
+                m_profiler.exit(_success, _tokensConsumed);
+            }
+
+        private:
+            grammar_profiler& m_profiler;
+            bool m_finished = false;
+        };
+
+        // Profiles sorted by exclusive time, longest first
+        std::vector<grammar_rule_profile> report() const {
+            std::vector<grammar_rule_profile> result;
+            result.reserve(m_records.size());
+
+            for (auto const& [name, record] : m_records) result.push_back(record.profile);
+
+            std::sort(begin(result), end(result), [](auto const& _first, auto const& _second) {
+                return _first.exclusive_time > _second.exclusive_time;
+            });
+
+            return result;
+        }
+
+        void write_report(std::ostream& _out) const {
+            char line[256];
+
+            std::snprintf(line, sizeof(line), "%-40s %10s %10s %10s %12s %12s %12s %12s\n", "rule", "calls", "successes", "failures", "consumed",
+                          "backtracked", "incl. ms", "excl. ms");
+            _out << line;
+
+            for (auto const& profile : report()) {
+                std::snprintf(line,
+                              sizeof(line),
+                              "%-40.40s %10llu %10llu %10llu %12llu %12llu %12.3f %12.3f\n",
+                              profile.name.c_str(),
+                              static_cast<unsigned long long>(profile.calls),
+                              static_cast<unsigned long long>(profile.successes),
+                              static_cast<unsigned long long>(profile.failures),
+                              static_cast<unsigned long long>(profile.tokens_consumed),
+                              static_cast<unsigned long long>(profile.tokens_backtracked),
+                              std::chrono::duration<double, std::milli>(profile.inclusive_time).count(),
+                              std::chrono::duration<double, std::milli>(profile.exclusive_time).count());
+                _out << line;
+            }
+        }
+
+        void reset() {
+            m_records.clear();
+            m_frames.clear();
+        }
+
+    private:
+        friend class grammar_profiling_scope;
+
+        struct record {
+            grammar_rule_profile profile;
+            std::size_t activeCalls = 0;
+        };
+
+        struct frame {
+            record* rule;
+            clock::time_point start;
+            clock::duration childTime;
+            std::uint64_t childTokensConsumed;
+        };
+
+        void enter(std::string const& _name) {
+            // Rule names are function-local statics, so their addresses identify the rule
+            auto& rule = m_records[&_name];
+            if (rule.profile.calls == 0) rule.profile.name = _name;
+
+            ++rule.profile.calls;
+            ++rule.activeCalls;
+
+            m_frames.push_back({&rule, clock::now(), clock::duration::zero(), 0});
+        }
+
+        void exit(bool _success, std::uint64_t _tokensConsumed) noexcept {
+            auto const end = clock::now();
+            auto const current = m_frames.back();
+            m_frames.pop_back();
+
+            auto& profile = current.rule->profile;
+            auto const inclusive = end - current.start;
+
+            --current.rule->activeCalls;
+
+            if (_success) {
+                ++profile.successes;
+                profile.tokens_consumed += _tokensConsumed;
+            } else {
+                ++profile.failures;
+                _tokensConsumed = 0;
+            }
+
+            if (current.childTokensConsumed > _tokensConsumed) profile.tokens_backtracked += current.childTokensConsumed - _tokensConsumed;
+
+            profile.exclusive_time += std::chrono::duration_cast<std::chrono::nanoseconds>(inclusive - current.childTime);
+            if (current.rule->activeCalls == 0) profile.inclusive_time += std::chrono::duration_cast<std::chrono::nanoseconds>(inclusive);
+
+            if (not m_frames.empty()) {
+                m_frames.back().childTime += inclusive;
+                m_frames.back().childTokensConsumed += _tokensConsumed;
+            }
+        }
+
+        std::unordered_map<std::string const*, record> m_records;
+        std::vector<frame> m_frames;
+
+        static inline thread_local grammar_profiler* t_current = nullptr;
+    };
+
+    // Installs a profiler on the current thread for the lifetime of the scope
+    class grammar_profiling_scope {
+    public:
+        grammar_profiling_scope(grammar_profiling_scope const&) = delete;
+        grammar_profiling_scope& operator=(grammar_profiling_scope const&) = delete;
+
+        explicit grammar_profiling_scope(grammar_profiler& _profiler) noexcept : m_previous(grammar_profiler::t_current) {
+            grammar_profiler::t_current = &_profiler;
+        }
+
+        ~grammar_profiling_scope() noexcept { grammar_profiler::t_current = m_previous; }
+
+    private:
+        grammar_profiler* m_previous;
+    };
+}    // namespace randomcat::parser
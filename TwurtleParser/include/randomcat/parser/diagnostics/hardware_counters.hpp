@@ -0,0 +1,240 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <ostream>
+
+#if __has_include(<linux/perf_event.h>)
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#    define RANDOMCAT_PARSER_HAS_PERF_EVENTS
+#endif
+
+namespace randomcat::parser {
+    enum class hardware_counter : std::uint8_t {
+        cycles,
+        instructions,
+        branch_misses,
+
+        // L1 data cache read misses
+        l1d_misses,
+
+        // Last level cache read misses
+        llc_misses,
+    };
+
+    inline constexpr std::size_t hardware_counter_count = 5;
+
+    inline constexpr char const* hardware_counter_name(hardware_counter _counter) noexcept {
+        switch (_counter) {
+            case hardware_counter::cycles: return "cycles";
+            case hardware_counter::instructions: return "instructions";
+            case hardware_counter::branch_misses: return "branch_misses";
+            case hardware_counter::l1d_misses: return "l1d_misses";
+            case hardware_counter::llc_misses: return "llc_misses";
+        }
+
+        return "unknown";
+    }
+
+    struct hardware_counts {
+        std::chrono::nanoseconds wall_time = std::chrono::nanoseconds::zero();
+
+        // Indexed by hardware_counter; empty for counters that could not be read (no PMU, a VM without counter passthrough,
+        // perf_event_paranoid too high or a platform without perf_event_open)
+        std::optional<std::uint64_t> values[hardware_counter_count] = {};
+
+        std::optional<std::uint64_t> value(hardware_counter _counter) const noexcept { return values[static_cast<std::size_t>(_counter)]; }
+
+        bool any_available() const noexcept {
+            for (auto const& value : values) {
+                if (value) return true;
+            }
+
+            return false;
+        }
+
+        // The counter divided by _amount (e.g. the number of bytes or tokens processed)
+        std::optional<double> per(hardware_counter _counter, std::uint64_t _amount) const noexcept {
+            auto const counterValue = value(_counter);
+            if (not counterValue || _amount == 0) return std::nullopt;
+
+            return static_cast<double>(*counterValue) / static_cast<double>(_amount);
+        }
+
+        std::optional<double> instructions_per_cycle() const noexcept {
+            auto const cycles = value(hardware_counter::cycles);
+            if (not cycles) return std::nullopt;
+
+            return per(hardware_counter::instructions, *cycles);
+        }
+    };
+
+    // Counts hardware events of the current thread (user space only) from construction until stop(), using perf_event_open on Linux.
+    // Counters that cannot be opened are left out of the result, so a scope always degrades to measuring wall time only.
+    class hardware_counter_scope {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        hardware_counter_scope(hardware_counter_scope const&) = delete;
+        hardware_counter_scope& operator=(hardware_counter_scope const&) = delete;
+
+        hardware_counter_scope() noexcept {
+#ifdef RANDOMCAT_PARSER_HAS_PERF_EVENTS
+            for (std::size_t i = 0; i < hardware_counter_count; ++i) m_descriptors[i] = open_counter(static_cast<hardware_counter>(i));
+            for (auto const descriptor : m_descriptors) {
+                if (descriptor >= 0) ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+
+            m_start = clock::now();
+        }
+
+        ~hardware_counter_scope() noexcept { close_all(); }
+
+        // Whether at least one counter could be opened
+        bool counters_available() const noexcept {
+            for (auto const descriptor : m_descriptors) {
+                if (descriptor >= 0) return true;
+            }
+
+            return false;
+        }
+
+        // Stops counting; the scope must not be used afterwards
+        hardware_counts stop() noexcept {
+            hardware_counts result;
+
+#ifdef RANDOMCAT_PARSER_HAS_PERF_EVENTS
+            for (auto const descriptor : m_descriptors) {
+                if (descriptor >= 0) ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            }
+#endif
+
+            result.wall_time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start);
+
+#ifdef RANDOMCAT_PARSER_HAS_PERF_EVENTS
+            for (std::size_t i = 0; i < hardware_counter_count; ++i) {
+                if (m_descriptors[i] >= 0) result.values[i] = read_counter(m_descriptors[i]);
+            }
+#endif
+
+            close_all();
+            return result;
+        }
+
+    private:
+#ifdef RANDOMCAT_PARSER_HAS_PERF_EVENTS
+        static int open_counter(hardware_counter _counter) noexcept {
+            perf_event_attr attributes = {};
+            attributes.size = sizeof(attributes);
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            constexpr auto cache_read_miss = [](std::uint64_t _cache) {
+                return _cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            };
+
+            switch (_counter) {
+                case hardware_counter::cycles:
+                    attributes.type = PERF_TYPE_HARDWARE;
+                    attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+                    break;
+                case hardware_counter::instructions:
+                    attributes.type = PERF_TYPE_HARDWARE;
+                    attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+                    break;
+                case hardware_counter::branch_misses:
+                    attributes.type = PERF_TYPE_HARDWARE;
+                    attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+                    break;
+                case hardware_counter::l1d_misses:
+                    attributes.type = PERF_TYPE_HW_CACHE;
+                    attributes.config = cache_read_miss(PERF_COUNT_HW_CACHE_L1D);
+                    break;
+                case hardware_counter::llc_misses:
+                    attributes.type = PERF_TYPE_HW_CACHE;
+                    attributes.config = cache_read_miss(PERF_COUNT_HW_CACHE_LL);
+                    break;
+            }
+
+            // Counters are opened separately rather than as a group, so that one unsupported event does not lose the others
+            return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        }
+
+        static std::optional<std::uint64_t> read_counter(int _descriptor) noexcept {
+            struct {
+                std::uint64_t value;
+                std::uint64_t timeEnabled;
+                std::uint64_t timeRunning;
+            } data = {};
+
+            if (read(_descriptor, &data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) return std::nullopt;
+            if (data.timeRunning == 0) return std::nullopt;
+
+            // The kernel multiplexes counters when there are more events than hardware counters; scale up to the whole scope
+            if (data.timeRunning < data.timeEnabled) {
+                return static_cast<std::uint64_t>(static_cast<double>(data.value) * static_cast<double>(data.timeEnabled)
+                                                  / static_cast<double>(data.timeRunning));
+            }
+
+            return data.value;
+        }
+#endif
+
+        void close_all() noexcept {
+            for (auto& descriptor : m_descriptors) {
+#ifdef RANDOMCAT_PARSER_HAS_PERF_EVENTS
+                if (descriptor >= 0) close(descriptor);
+#endif
+                descriptor = -1;
+            }
+        }
+
+        int m_descriptors[hardware_counter_count] = {-1, -1, -1, -1, -1};
+        clock::time_point m_start;
+    };
+
+    // Writes the counters with their ratios per byte and per token; unavailable counters are reported as such
+    inline void write_hardware_report(std::ostream& _out, hardware_counts const& _counts, std::uint64_t _bytes, std::uint64_t _tokens) {
+        char line[256];
+
+        std::snprintf(line, sizeof(line), "%-16s %16.3f ms\n", "wall time", std::chrono::duration<double, std::milli>(_counts.wall_time).count());
+        _out << line;
+
+        if (not _counts.any_available()) {
+            _out << "hardware counters unavailable, timing only\n";
+            return;
+        }
+
+        for (std::size_t i = 0; i < hardware_counter_count; ++i) {
+            auto const counter = static_cast<hardware_counter>(i);
+            auto const value = _counts.value(counter);
+
+            if (not value) {
+                std::snprintf(line, sizeof(line), "%-16s %16s\n", hardware_counter_name(counter), "unavailable");
+            } else {
+                std::snprintf(line,
+                              sizeof(line),
+                              "%-16s %16llu %12.3f /byte %12.3f /token\n",
+                              hardware_counter_name(counter),
+                              static_cast<unsigned long long>(*value),
+                              _counts.per(counter, _bytes).value_or(0),
+                              _counts.per(counter, _tokens).value_or(0));
+            }
+
+            _out << line;
+        }
+
+        if (auto const ipc = _counts.instructions_per_cycle()) {
+            std::snprintf(line, sizeof(line), "%-16s %16.3f\n", "IPC", *ipc);
+            _out << line;
+        }
+    }
+}    // namespace randomcat::parser
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/chars/tokenizer.hpp"
+#include "randomcat/parser/diagnostics/stats.hpp"
+#include "randomcat/parser/tokens/token_stream/token_stream.hpp"
+
+namespace randomcat::parser {
+    // Wraps a char source, telling Stats how many chars are peeked and consumed, and about every set_head and how far it rewinds
+    template<typename CharSource, typename Stats>
+    class instrumented_char_source {
+    private:
+        using source_traits = char_source_traits<CharSource>;
+
+    public:
+        static_assert(util_detail::is_simple_type_v<CharSource>);
+
+        using char_type = typename source_traits::char_type;
+        using char_traits_type = typename source_traits::char_traits_type;
+        using string_type = typename source_traits::string_type;
+        using string_view_type = typename source_traits::string_view_type;
+        using size_type = typename source_traits::size_type;
+        using location_type = typename source_traits::location_type;
+
+        explicit instrumented_char_source(CharSource _source, Stats _stats) : m_source(std::move(_source)), m_stats(std::move(_stats)) {}
+
+        bool at_end() const noexcept(noexcept(source_traits::at_end(std::declval<CharSource const&>()))) { return source_traits::at_end(m_source); }
+
+        location_type head() const noexcept(noexcept(source_traits::head(std::declval<CharSource const&>()))) { return source_traits::head(m_source); }
+
+        void set_head(location_type _head) noexcept(noexcept(source_traits::set_head(std::declval<CharSource&>(), _head))) {
+            if constexpr (Stats::enabled) {
+                m_stats.head_set();
+
+                auto const distance = stats_detail::location_distance(head(), _head);
+                if (distance && *distance < 0) m_stats.head_rewound(static_cast<std::uint64_t>(-*distance));
+            }
+
+            source_traits::set_head(m_source, std::move(_head));
+        }
+
+        string_type peek(size_type _n) const {
+            auto result = source_traits::peek(m_source, _n);
+            m_stats.chars_peeked(size(result));
+            return result;
+        }
+
+        char_type peek_char() const {
+            m_stats.chars_peeked(1);
+            return source_traits::peek_char(m_source);
+        }
+
+        // Counts the chars searched before the match as peeked
+        size_type find(string_view_type _str) const {
+            auto const distance = source_traits::find(m_source, _str);
+            m_stats.chars_peeked(distance);
+            return distance;
+        }
+
+        void advance_head(size_type _n) noexcept(noexcept(source_traits::advance_head(std::declval<CharSource&>(), _n))) {
+            m_stats.chars_consumed(_n);
+            source_traits::advance_head(m_source, _n);
+        }
+
+        // Only provided if the wrapped source provides it
+        template<typename CharSource_ = CharSource, typename = decltype(std::declval<CharSource_ const&>().chars_remaining())>
+        size_type chars_remaining() const noexcept(noexcept(source_traits::chars_remaining(std::declval<CharSource const&>()))) {
+            return source_traits::chars_remaining(m_source);
+        }
+
+        CharSource const& source() const noexcept { return m_source; }
+
+    private:
+        CharSource m_source;
+        Stats m_stats;
+    };
+
+    namespace stats_detail {
+        template<typename Tokenizer, typename Stats, typename = void>
+        struct has_with_stats : std::false_type {};
+
+        template<typename Tokenizer, typename Stats>
+        struct has_with_stats<Tokenizer, Stats, std::void_t<decltype(std::declval<Tokenizer const&>().with_stats(std::declval<Stats>()))>> :
+        std::true_type {};
+    }    // namespace stats_detail
+
+    // Tokenizers that support stats policies (e.g. simple_tokenizer) count into _stats, others are used as they are
+    template<typename Tokenizer>
+    auto make_instrumented_tokenizer(Tokenizer const& _tokenizer, parser_stats& _stats) {
+        if constexpr (stats_detail::has_with_stats<Tokenizer, counting_stats>::value) {
+            return _tokenizer.with_stats(counting_stats(_stats));
+        } else {
+            return _tokenizer;
+        }
+    }
+
+    template<typename CharSource>
+    instrumented_char_source<CharSource, counting_stats> make_instrumented_char_source(CharSource _source, parser_stats& _stats) {
+        return instrumented_char_source<CharSource, counting_stats>(std::move(_source), counting_stats(_stats));
+    }
+
+    // A char_source_token_stream counting chars, lexes and descriptor attempts into _stats.
+    // _stats should have room for the tokenizer's descriptors, e.g. parser_stats(decltype(tokenizer)::token_parser_count).
+    template<typename CharSource, typename Tokenizer>
+    auto make_instrumented_token_stream(CharSource _source, Tokenizer const& _tokenizer, parser_stats& _stats) {
+        return char_source_token_stream(make_instrumented_char_source(std::move(_source), _stats),
+                                        make_instrumented_tokenizer(_tokenizer, _stats),
+                                        counting_stats(_stats));
+    }
+}    // namespace randomcat::parser
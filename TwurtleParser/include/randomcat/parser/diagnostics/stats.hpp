@@ -0,0 +1,238 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace randomcat::parser {
+    // A counter that may be bumped from several threads at once (e.g. by a tokenizer shared across the batch driver's workers)
+    class stat_counter {
+    public:
+        stat_counter() noexcept = default;
+
+        stat_counter(stat_counter const&) = delete;
+        stat_counter& operator=(stat_counter const&) = delete;
+
+        void add(std::uint64_t _n = 1) noexcept { m_value.fetch_add(_n, std::memory_order_relaxed); }
+        std::uint64_t value() const noexcept { return m_value.load(std::memory_order_relaxed); }
+        void reset() noexcept { m_value.store(0, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<std::uint64_t> m_value = 0;
+    };
+
+    struct descriptor_counts {
+        // Times the descriptor was asked for a token (descriptors outranked by an earlier match are not asked)
+        std::uint64_t attempts = 0;
+
+        // Times it was asked but did not match
+        std::uint64_t rejections = 0;
+    };
+
+    struct parser_stats_snapshot {
+        // Indexed like the tokenizer's descriptors
+        std::vector<descriptor_counts> descriptors;
+
+        std::uint64_t chars_peeked = 0;
+        std::uint64_t chars_consumed = 0;
+
+        std::uint64_t head_sets = 0;
+        std::uint64_t rewinds = 0;
+        std::uint64_t rewind_distance = 0;
+
+        std::uint64_t lexes = 0;
+        std::uint64_t relexes = 0;
+
+        std::uint64_t transform_runs = 0;
+        std::uint64_t transform_reruns = 0;
+
+        std::uint64_t descriptor_attempts() const noexcept {
+            std::uint64_t result = 0;
+            for (auto const& counts : descriptors) result += counts.attempts;
+            return result;
+        }
+
+        std::uint64_t descriptor_rejections() const noexcept {
+            std::uint64_t result = 0;
+            for (auto const& counts : descriptors) result += counts.rejections;
+            return result;
+        }
+    };
+
+    // Counters filled in by components that are instantiated with counting_stats.
+    // Must outlive every component that counts into it.
+    class parser_stats {
+    public:
+        explicit parser_stats(std::size_t _descriptorCount = 0)
+        : m_descriptorCount(_descriptorCount), m_descriptors(std::make_unique<descriptor_counters[]>(_descriptorCount)) {}
+
+        parser_stats(parser_stats const&) = delete;
+        parser_stats& operator=(parser_stats const&) = delete;
+
+        std::size_t descriptor_count() const noexcept { return m_descriptorCount; }
+
+        parser_stats_snapshot snapshot() const {
+            parser_stats_snapshot result;
+
+            result.descriptors.reserve(m_descriptorCount);
+            for (std::size_t i = 0; i < m_descriptorCount; ++i) {
+                result.descriptors.push_back({m_descriptors[i].attempts.value(), m_descriptors[i].rejections.value()});
+            }
+
+            result.chars_peeked = m_charsPeeked.value();
+            result.chars_consumed = m_charsConsumed.value();
+            result.head_sets = m_headSets.value();
+            result.rewinds = m_rewinds.value();
+            result.rewind_distance = m_rewindDistance.value();
+            result.lexes = m_lexes.value();
+            result.relexes = m_relexes.value();
+            result.transform_runs = m_transformRuns.value();
+            result.transform_reruns = m_transformReruns.value();
+
+            return result;
+        }
+
+        void reset() noexcept {
+            for (std::size_t i = 0; i < m_descriptorCount; ++i) {
+                m_descriptors[i].attempts.reset();
+                m_descriptors[i].rejections.reset();
+            }
+
+            for (auto* counter : {&m_charsPeeked,
+                                  &m_charsConsumed,
+                                  &m_headSets,
+                                  &m_rewinds,
+                                  &m_rewindDistance,
+                                  &m_lexes,
+                                  &m_relexes,
+                                  &m_transformRuns,
+                                  &m_transformReruns}) {
+                counter->reset();
+            }
+        }
+
+    private:
+        friend class counting_stats;
+
+        struct descriptor_counters {
+            stat_counter attempts;
+            stat_counter rejections;
+        };
+
+        std::size_t m_descriptorCount;
+        std::unique_ptr<descriptor_counters[]> m_descriptors;
+
+        stat_counter m_charsPeeked;
+        stat_counter m_charsConsumed;
+
+        stat_counter m_headSets;
+        stat_counter m_rewinds;
+        stat_counter m_rewindDistance;
+
+        stat_counter m_lexes;
+        stat_counter m_relexes;
+
+        stat_counter m_transformRuns;
+        stat_counter m_transformReruns;
+    };
+
+    // Stats policies are passed to tokenizers, token streams and instrumented_char_source.
+    // no_stats is the default; every hook is empty and is compiled away, as are the checks guarded by enabled.
+    struct no_stats {
+        static inline constexpr bool enabled = false;
+
+        constexpr void descriptor_attempted(std::size_t) const noexcept {}
+        constexpr void descriptor_rejected(std::size_t) const noexcept {}
+
+        constexpr void chars_peeked(std::uint64_t) const noexcept {}
+        constexpr void chars_consumed(std::uint64_t) const noexcept {}
+
+        constexpr void head_set() const noexcept {}
+        constexpr void head_rewound(std::uint64_t) const noexcept {}
+
+        constexpr void token_lexed(bool) const noexcept {}
+        constexpr void transform_ran(bool) const noexcept {}
+    };
+
+    // Counts into a parser_stats. Copies count into the same parser_stats.
+    class counting_stats {
+    public:
+        static inline constexpr bool enabled = true;
+
+        explicit counting_stats(parser_stats& _stats) noexcept : m_stats(&_stats) {}
+
+        void descriptor_attempted(std::size_t _index) const noexcept {
+            if (_index < m_stats->m_descriptorCount) m_stats->m_descriptors[_index].attempts.add();
+        }
+
+        void descriptor_rejected(std::size_t _index) const noexcept {
+            if (_index < m_stats->m_descriptorCount) m_stats->m_descriptors[_index].rejections.add();
+        }
+
+        void chars_peeked(std::uint64_t _n) const noexcept { m_stats->m_charsPeeked.add(_n); }
+        void chars_consumed(std::uint64_t _n) const noexcept { m_stats->m_charsConsumed.add(_n); }
+
+        void head_set() const noexcept { m_stats->m_headSets.add(); }
+
+        void head_rewound(std::uint64_t _distance) const noexcept {
+            m_stats->m_rewinds.add();
+            m_stats->m_rewindDistance.add(_distance);
+        }
+
+        // _relex is true if the token at this position was already lexed before
+        void token_lexed(bool _relex) const noexcept {
+            m_stats->m_lexes.add();
+            if (_relex) m_stats->m_relexes.add();
+        }
+
+        // _rerun is true if the transform ran because the stream's head was set, so it is redoing work
+        void transform_ran(bool _rerun) const noexcept {
+            m_stats->m_transformRuns.add();
+            if (_rerun) m_stats->m_transformReruns.add();
+        }
+
+    private:
+        parser_stats* m_stats;
+    };
+
+    inline std::ostream& operator<<(std::ostream& _out, parser_stats_snapshot const& _snapshot) {
+        _out << "chars peeked: " << _snapshot.chars_peeked << ", consumed: " << _snapshot.chars_consumed << '\n';
+        _out << "head sets: " << _snapshot.head_sets << ", rewinds: " << _snapshot.rewinds << " (" << _snapshot.rewind_distance << " chars)\n";
+        _out << "lexes: " << _snapshot.lexes << ", relexes: " << _snapshot.relexes << '\n';
+        _out << "transform runs: " << _snapshot.transform_runs << ", reruns: " << _snapshot.transform_reruns << '\n';
+
+        for (std::size_t i = 0; i < _snapshot.descriptors.size(); ++i) {
+            auto const& counts = _snapshot.descriptors[i];
+            _out << "descriptor " << i << ": " << counts.attempts << " attempts, " << counts.rejections << " rejections\n";
+        }
+
+        return _out;
+    }
+
+    namespace stats_detail {
+        template<typename Location, typename = void>
+        struct has_location_difference : std::false_type {};
+
+        template<typename Location>
+        struct has_location_difference<Location, std::void_t<decltype(std::declval<Location const&>() - std::declval<Location const&>())>> :
+        std::true_type {};
+
+        // How far _to is ahead of _from, if locations can be subtracted (string offsets and stream positions can)
+        template<typename Location>
+        std::optional<std::int64_t> location_distance(Location const& _from, Location const& _to) noexcept {
+            if constexpr (std::is_arithmetic_v<Location>) {
+                return static_cast<std::int64_t>(_to) - static_cast<std::int64_t>(_from);
+            } else if constexpr (has_location_difference<Location>::value) {
+                return static_cast<std::int64_t>(_to - _from);
+            } else {
+                return std::nullopt;
+            }
+        }
+    }    // namespace stats_detail
+}    // namespace randomcat::parser
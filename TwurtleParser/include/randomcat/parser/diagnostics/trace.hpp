@@ -0,0 +1,300 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace randomcat::parser {
+    enum class trace_category : std::uint8_t {
+        // Whole tokenize() calls
+        tokenize,
+
+        // One token lexed by char_source_token_stream::read
+        lex,
+
+        // One run of a transform_token_stream transform
+        transform,
+
+        // One grammar test
+        grammar,
+
+        // Reading and processing files in the batch driver
+        driver,
+    };
+
+    inline constexpr std::size_t trace_category_count = 5;
+
+    inline constexpr char const* trace_category_name(trace_category _category) noexcept {
+        switch (_category) {
+            case trace_category::tokenize: return "tokenize";
+            case trace_category::lex: return "lex";
+            case trace_category::transform: return "transform";
+            case trace_category::grammar: return "grammar";
+            case trace_category::driver: return "driver";
+        }
+
+        return "unknown";
+    }
+
+    struct trace_options {
+        // Which categories are recorded, indexed by trace_category
+        bool categories[trace_category_count] = {true, true, true, true, true};
+
+        // Only every sample_period-th span of the lex, transform and grammar categories is recorded on each thread.
+        // tokenize and driver spans are rare and always recorded.
+        std::uint32_t sample_period = 1;
+
+        // Spans shorter than this are dropped when they end
+        std::chrono::nanoseconds min_duration = std::chrono::nanoseconds::zero();
+
+        // Untagged grammars are named after their type, which makes for long names and many spans
+        bool untagged_grammars = false;
+
+        // If not empty, only grammar rules with one of these names are recorded
+        std::vector<std::string> grammar_rules = {};
+
+        // Events kept per thread; older events are overwritten
+        std::size_t buffer_capacity = 1 << 16;
+    };
+
+    // Records spans from every thread into per-thread ring buffers while it is started, and writes them as Chrome trace_event
+    // JSON (loadable in chrome://tracing and Perfetto). Spans are only recorded when RANDOMCAT_PARSER_TRACING is defined.
+    class trace_recorder {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        explicit trace_recorder(trace_options _options = {}) : m_options(std::move(_options)), m_epoch(clock::now()) {
+            m_options.sample_period = std::max<std::uint32_t>(m_options.sample_period, 1);
+            m_options.buffer_capacity = std::max<std::size_t>(m_options.buffer_capacity, 1);
+        }
+
+        trace_recorder(trace_recorder const&) = delete;
+        trace_recorder& operator=(trace_recorder const&) = delete;
+
+        ~trace_recorder() noexcept { stop(); }
+
+        // Only one recorder can be started at a time
+        void start() noexcept {
+            m_session = s_nextSession.fetch_add(1, std::memory_order_relaxed) + 1;
+            s_active.store(this, std::memory_order_release);
+        }
+
+        void stop() noexcept {
+            auto expected = this;
+            s_active.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+        }
+
+        static trace_recorder* active() noexcept { return s_active.load(std::memory_order_acquire); }
+
+        trace_options const& options() const noexcept { return m_options; }
+
+        // Number of events lost because a thread's buffer was full
+        std::uint64_t overwritten_events() const {
+            std::lock_guard lock(m_mutex);
+
+            std::uint64_t result = 0;
+            for (auto const& buffer : m_buffers) result += buffer->written > buffer->events.size() ? buffer->written - buffer->events.size() : 0;
+            return result;
+        }
+
+        // Must only be called once no thread is recording into this recorder anymore
+        void write_json(std::ostream& _out) const {
+            std::lock_guard lock(m_mutex);
+
+            _out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+            bool first = true;
+            char line[512];
+
+            for (auto const& buffer : m_buffers) {
+                std::snprintf(line,
+                              sizeof(line),
+                              "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %zu, \"args\": {\"name\": \"thread %zu\"}}",
+                              first ? "" : ",",
+                              buffer->thread,
+                              buffer->thread);
+                _out << line;
+                first = false;
+
+                auto const count = std::min<std::uint64_t>(buffer->written, buffer->events.size());
+                auto const oldest = buffer->written - count;
+
+                for (std::uint64_t i = oldest; i < buffer->written; ++i) {
+                    auto const& event = buffer->events[i % buffer->events.size()];
+
+                    _out << ",\n{\"name\": ";
+                    write_string(_out, event.name);
+                    std::snprintf(line,
+                                  sizeof(line),
+                                  ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %zu}",
+                                  trace_category_name(event.category),
+                                  static_cast<double>(event.start) / 1000.0,
+                                  static_cast<double>(event.duration) / 1000.0,
+                                  buffer->thread);
+                    _out << line;
+                }
+            }
+
+            _out << "\n]}\n";
+        }
+
+    private:
+        friend class trace_span;
+
+        struct event {
+            // Names are string literals or strings with static storage duration, so events never own memory
+            char const* name;
+            trace_category category;
+            std::int64_t start;
+            std::int64_t duration;
+        };
+
+        struct thread_buffer {
+            std::size_t thread;
+            std::vector<event> events;
+            std::uint64_t written = 0;
+
+            std::uint32_t sampleCounters[trace_category_count] = {};
+
+            // Whether grammar rule names pass options.grammar_rules, by name address
+            std::unordered_map<char const*, bool> ruleFilter = {};
+        };
+
+        // Cached per thread, so that finding the buffer does not take the lock after the first span
+        struct thread_binding {
+            std::uint64_t session = 0;
+            thread_buffer* buffer = nullptr;
+        };
+
+        thread_buffer* buffer_for_current_thread() {
+            static thread_local thread_binding binding;
+            if (binding.session == m_session) return binding.buffer;
+
+            std::lock_guard lock(m_mutex);
+
+            auto buffer = std::make_unique<thread_buffer>();
+            buffer->thread = m_buffers.size();
+            buffer->events.resize(m_options.buffer_capacity);
+
+            binding = {m_session, buffer.get()};
+            m_buffers.push_back(std::move(buffer));
+
+            return binding.buffer;
+        }
+
+        bool sampled(thread_buffer& _buffer, trace_category _category) const noexcept {
+            auto const index = static_cast<std::size_t>(_category);
+            if (not m_options.categories[index]) return false;
+            if (_category == trace_category::tokenize || _category == trace_category::driver) return true;
+
+            auto& counter = _buffer.sampleCounters[index];
+            auto const result = counter == 0;
+            if (++counter == m_options.sample_period) counter = 0;
+
+            return result;
+        }
+
+        bool rule_selected(thread_buffer& _buffer, char const* _name) const {
+            if (m_options.grammar_rules.empty()) return true;
+
+            auto const [it, inserted] = _buffer.ruleFilter.try_emplace(_name, false);
+            if (inserted) it->second = std::find(begin(m_options.grammar_rules), end(m_options.grammar_rules), _name) != end(m_options.grammar_rules);
+
+            return it->second;
+        }
+
+        void record(thread_buffer& _buffer, trace_category _category, char const* _name, clock::time_point _start, clock::time_point _end) const noexcept {
+            auto const duration = _end - _start;
+            if (duration < m_options.min_duration) return;
+
+            _buffer.events[_buffer.written % _buffer.events.size()] = {
+                _name,
+                _category,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(_start - m_epoch).count(),
+                std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+            };
+
+            ++_buffer.written;
+        }
+
+        static void write_string(std::ostream& _out, std::string_view _value) {
+            _out << '"';
+
+            for (auto const c : _value) {
+                if (c == '"' || c == '\\') {
+                    _out << '\\' << c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                    _out << buffer;
+                } else {
+                    _out << c;
+                }
+            }
+
+            _out << '"';
+        }
+
+        trace_options m_options;
+        clock::time_point m_epoch;
+        std::uint64_t m_session = 0;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<thread_buffer>> m_buffers;
+
+        static inline std::atomic<trace_recorder*> s_active = nullptr;
+        static inline std::atomic<std::uint64_t> s_nextSession = 0;
+    };
+
+    // Records the time from its construction to its destruction as a span, if a recorder is started and the span is sampled.
+    // _name() is only called for sampled spans; it returns a name with static storage duration, or nullptr to skip the span.
+    class trace_span {
+    public:
+        trace_span(trace_span const&) = delete;
+        trace_span& operator=(trace_span const&) = delete;
+
+        template<typename NameGetter>
+        explicit trace_span(trace_category _category, NameGetter&& _name) noexcept : m_category(_category) {
+            auto* const recorder = trace_recorder::active();
+            if (not recorder) return;
+
+            try {
+                auto* const buffer = recorder->buffer_for_current_thread();
+                if (not recorder->sampled(*buffer, _category)) return;
+
+                m_name = std::forward<NameGetter>(_name)();
+                if (not m_name) return;
+                if (_category == trace_category::grammar && not recorder->rule_selected(*buffer, m_name)) return;
+
+                m_recorder = recorder;
+                m_buffer = buffer;
+                m_start = trace_recorder::clock::now();
+            } catch (...) {
+                // Tracing never makes parsing fail; the span is dropped instead
+            }
+        }
+
+        explicit trace_span(trace_category _category, char const* _name) noexcept : trace_span(_category, [=] { return _name; }) {}
+
+        ~trace_span() noexcept {
+            if (m_buffer) m_recorder->record(*m_buffer, m_category, m_name, m_start, trace_recorder::clock::now());
+        }
+
+    private:
+        trace_category m_category;
+        char const* m_name = nullptr;
+        trace_recorder* m_recorder = nullptr;
+        trace_recorder::thread_buffer* m_buffer = nullptr;
+        trace_recorder::clock::time_point m_start = {};
+    };
+}    // namespace randomcat::parser
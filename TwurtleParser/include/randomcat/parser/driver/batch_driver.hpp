@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/chars/tokenizer.hpp"
+#include "randomcat/parser/diagnostics/allocation_tracking.hpp"
+#include "randomcat/parser/driver/detail/work_stealing_pool.hpp"
+#include "randomcat/parser/driver/file_ingestion.hpp"
+#include "randomcat/parser/grammar/grammar_terms.hpp"
+#include "randomcat/parser/tokens/token_stream/token_stream.hpp"
+
+#ifdef RANDOMCAT_PARSER_TRACING
+#    include "randomcat/parser/diagnostics/trace.hpp"
+#endif
+
+namespace randomcat::parser {
+    enum class batch_file_reading {
+        // Every worker reads the files it processes into its own reused buffer
+        per_worker,
+
+        // Files are read ahead through ingest_files (io_uring where available) and handed to the workers
+        batched,
+    };
+
+    struct batch_options {
+        // 0 means one thread per hardware thread
+        std::size_t thread_count = 0;
+
+        // Size of the buffer backing each worker's arena before it has to fall back to the heap
+        std::size_t arena_size = 64 * 1024;
+
+        batch_file_reading file_reading = batch_file_reading::per_worker;
+
+        // Only used for batch_file_reading::batched. max_in_flight also bounds the number of read files waiting for a worker.
+        ingestion_options ingestion = {};
+    };
+
+    // State that belongs to one worker and is reused for every file it processes
+    class batch_worker_context {
+    public:
+        batch_worker_context(batch_worker_context const&) = delete;
+        batch_worker_context(batch_worker_context&&) = delete;
+        batch_worker_context& operator=(batch_worker_context const&) = delete;
+        batch_worker_context& operator=(batch_worker_context&&) = delete;
+
+        explicit batch_worker_context(std::size_t _index, std::size_t _arenaSize)
+        : m_index(_index), m_arenaBuffer(_arenaSize), m_arena(m_arenaBuffer.data(), m_arenaBuffer.size()) {}
+
+        std::size_t index() const noexcept { return m_index; }
+
+        // Holds the contents of the file currently being processed
+        std::string& buffer() noexcept { return m_buffer; }
+
+        // Scratch memory, released after every file, so it must not back anything that is returned. batch_tokenize collects tokens
+        // in it; batch_parse does not use it, since grammars allocate their results from the global heap.
+        std::pmr::memory_resource& arena() noexcept { return m_arena; }
+
+        void release_arena() noexcept { m_arena.release(); }
+
+    private:
+        std::size_t m_index;
+        std::string m_buffer;
+        std::vector<std::byte> m_arenaBuffer;
+        std::pmr::monotonic_buffer_resource m_arena;
+    };
+
+    template<typename Result>
+    struct batch_file_result {
+        std::string path;
+        std::uintmax_t size = 0;
+
+        // Empty if the file could not be read or processing it threw, in which case error holds the exception
+        std::optional<Result> result = std::nullopt;
+        std::exception_ptr error = nullptr;
+
+        std::size_t worker = 0;
+        std::chrono::nanoseconds read_time = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds process_time = std::chrono::nanoseconds::zero();
+
+        // Allocations made while processing the file (not reading it); all zero unless counting_operator_new.hpp is linked in
+        allocation_counts allocations = {};
+    };
+
+    namespace driver_detail {
+        inline void read_file(std::string const& _path, std::uintmax_t _size, std::string& _buffer) {
+            std::ifstream stream(_path, std::ios::binary);
+            if (not stream) throw std::runtime_error("Unable to open file: " + _path);
+
+            _buffer.resize(_size);
+            stream.read(_buffer.data(), static_cast<std::streamsize>(_size));
+            _buffer.resize(static_cast<std::size_t>(stream.gcount()));
+
+            if (stream.bad()) throw std::runtime_error("Unable to read file: " + _path);
+        }
+    }    // namespace driver_detail
+
+    // Runs _workerFactory(context) once on every worker thread, then calls the returned processor as
+    // processor(std::string_view contents, batch_worker_context&) for each file that worker picks up.
+    // Files are scheduled largest first. Results are returned in the order of _paths.
+    template<typename WorkerFactory>
+    auto batch_process(std::vector<std::string> const& _paths, WorkerFactory const& _workerFactory, batch_options const& _options = {}) {
+        using processor_type = std::decay_t<std::invoke_result_t<WorkerFactory const&, batch_worker_context&>>;
+        using result_type = std::decay_t<std::invoke_result_t<processor_type&, std::string_view, batch_worker_context&>>;
+        using clock = std::chrono::steady_clock;
+
+        std::vector<batch_file_result<result_type>> results(_paths.size());
+        for (std::size_t i = 0; i < _paths.size(); ++i) {
+            results[i].path = _paths[i];
+            results[i].size = ingestion_detail::file_size_or_zero(_paths[i]);
+        }
+
+        std::vector<std::size_t> order(_paths.size());
+        std::iota(begin(order), end(order), std::size_t(0));
+        std::stable_sort(begin(order), end(order), [&](std::size_t a, std::size_t b) { return results[a].size > results[b].size; });
+
+        driver_detail::work_stealing_pool pool(_options.thread_count);
+
+        std::vector<std::unique_ptr<batch_worker_context>> contexts;
+        for (std::size_t i = 0; i < pool.thread_count(); ++i) contexts.push_back(std::make_unique<batch_worker_context>(i, _options.arena_size));
+
+        // Each slot is only ever touched by the worker with the same index
+        std::vector<std::optional<processor_type>> processors(pool.thread_count());
+
+        auto const process = [&](std::size_t _fileIndex, std::size_t _worker, auto&& _readContents) {
+            auto& fileResult = results[_fileIndex];
+            auto& context = *contexts[_worker];
+            fileResult.worker = _worker;
+
+            try {
+                if (not processors[_worker]) processors[_worker].emplace(_workerFactory(context));
+
+                auto const readStart = clock::now();
+                auto const contents = [&] {
+#ifdef RANDOMCAT_PARSER_TRACING
+                    trace_span span(trace_category::driver, "read file");
+#endif
+                    return _readContents(context);
+                }();
+                auto const processStart = clock::now();
+
+                {
+#ifdef RANDOMCAT_PARSER_TRACING
+                    trace_span span(trace_category::driver, "process file");
+#endif
+                    allocation_scope allocations;
+                    fileResult.result.emplace((*processors[_worker])(contents, context));
+                    fileResult.allocations = allocations.counts();
+                }
+
+                fileResult.read_time = processStart - readStart;
+                fileResult.process_time = clock::now() - processStart;
+            } catch (...) { fileResult.error = std::current_exception(); }
+
+            context.release_arena();
+        };
+
+        if (_options.file_reading == batch_file_reading::per_worker) {
+            for (auto const fileIndex : order) {
+                pool.submit([&, fileIndex](std::size_t _worker) {
+                    process(fileIndex, _worker, [&](batch_worker_context& _context) {
+                        driver_detail::read_file(results[fileIndex].path, results[fileIndex].size, _context.buffer());
+                        return std::string_view(_context.buffer());
+                    });
+                });
+            }
+
+            pool.wait();
+            return results;
+        }
+
+        std::vector<std::string> orderedPaths;
+        std::vector<std::uintmax_t> orderedSizes;
+        for (auto const fileIndex : order) {
+            orderedPaths.push_back(results[fileIndex].path);
+            orderedSizes.push_back(results[fileIndex].size);
+        }
+
+        // Read files that no worker has picked up yet count towards the in-flight limit, so that reading cannot run away from processing
+        std::mutex waitingMutex;
+        std::condition_variable waitingChanged;
+        std::size_t waiting = 0;
+        auto const maxWaiting = std::max<std::size_t>(_options.ingestion.max_in_flight, 1);
+
+        ingest_files(
+            orderedPaths,
+            std::move(orderedSizes),
+            [&](std::size_t _orderIndex, ingested_file&& _file) {
+                {
+                    std::unique_lock lock(waitingMutex);
+                    waitingChanged.wait(lock, [&] { return waiting < maxWaiting; });
+                    ++waiting;
+                }
+
+                auto const fileIndex = order[_orderIndex];
+                auto file = std::make_shared<ingested_file>(std::move(_file));
+
+                pool.submit([&, fileIndex, file](std::size_t _worker) {
+                    {
+                        std::lock_guard lock(waitingMutex);
+                        --waiting;
+                    }
+
+                    waitingChanged.notify_one();
+
+                    process(fileIndex, _worker, [&](batch_worker_context&) { return file->contents(); });
+                    results[fileIndex].read_time = file->read_time();
+                });
+            },
+            [&](std::size_t _orderIndex, std::exception_ptr _error) { results[order[_orderIndex]].error = std::move(_error); },
+            _options.ingestion);
+
+        pool.wait();
+        return results;
+    }
+
+    // Tokenizes every file with a tokenizer created once per worker by _tokenizerFactory(). Tokens are collected in the worker's
+    // arena while the file is tokenized, so growing the list reuses the same memory for every file, and are then moved into a
+    // result of exactly the right size.
+    template<typename TokenizerFactory>
+    auto batch_tokenize(std::vector<std::string> const& _paths, TokenizerFactory const& _tokenizerFactory, batch_options const& _options = {}) {
+        using tokenizer_type = std::decay_t<std::invoke_result_t<TokenizerFactory const&>>;
+        using token_type = typename tokenizer_traits<tokenizer_type>::token_type;
+        using result_type = decltype(tokenize(std::declval<tokenizer_type const&>(), string_view_char_source(std::string_view())));
+
+        return batch_process(
+            _paths,
+            [&](batch_worker_context&) {
+                return [tokenizer = _tokenizerFactory()](std::string_view _contents, batch_worker_context& _context) -> result_type {
+                    auto scratch = tokenize(tokenizer, string_view_char_source(_contents), std::pmr::polymorphic_allocator<token_type>(&_context.arena()));
+                    if (scratch.is_error()) return std::move(scratch).error();
+
+                    auto const amountParsed = scratch.amount_parsed();
+                    auto tokens = std::move(scratch).value();
+
+                    return {std::vector<token_type>(std::make_move_iterator(tokens.begin()), std::make_move_iterator(tokens.end())), amountParsed};
+                };
+            },
+            _options);
+    }
+
+    template<typename GrammarResult>
+    struct batch_parse_result {
+        GrammarResult result;
+
+        // Whether the grammar matched the file up to its end
+        bool complete;
+    };
+
+    struct identity_stream_adaptor {
+        template<typename TokenStream>
+        TokenStream operator()(TokenStream _stream) const {
+            return _stream;
+        }
+    };
+
+    // Parses every file with a tokenizer and a grammar that are created once per worker.
+    // _streamAdaptor may wrap the token stream (e.g. to strip whitespace) before the grammar sees it.
+    template<typename TokenizerFactory, typename GrammarFactory, typename StreamAdaptor = identity_stream_adaptor>
+    auto batch_parse(std::vector<std::string> const& _paths,
+                     TokenizerFactory const& _tokenizerFactory,
+                     GrammarFactory const& _grammarFactory,
+                     batch_options const& _options = {},
+                     StreamAdaptor const& _streamAdaptor = {}) {
+        return batch_process(
+            _paths,
+            [&](batch_worker_context&) {
+                return [&, tokenizer = _tokenizerFactory(), grammar = _grammarFactory()](std::string_view _contents, batch_worker_context&) {
+                    auto stream = _streamAdaptor(char_source_token_stream(string_view_char_source(_contents), tokenizer));
+                    auto result = grammar_advance_if_matches(grammar, stream);
+                    auto const complete = result.is_value() && stream.at_end();
+
+                    return batch_parse_result<decltype(result)>{std::move(result), complete};
+                };
+            },
+            _options);
+    }
+}    // namespace randomcat::parser
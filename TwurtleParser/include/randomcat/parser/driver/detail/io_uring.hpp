@@ -0,0 +1,208 @@
+#pragma once
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && not defined(RANDOMCAT_PARSER_NO_IO_URING)
+#    define RANDOMCAT_PARSER_HAS_IO_URING 1
+#else
+#    define RANDOMCAT_PARSER_HAS_IO_URING 0
+#endif
+
+#if RANDOMCAT_PARSER_HAS_IO_URING
+
+#    include <algorithm>
+#    include <cerrno>
+#    include <cstdint>
+#    include <cstring>
+
+#    include <fcntl.h>
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+
+namespace randomcat::parser::driver_detail {
+    // A minimal io_uring binding on top of the raw syscalls, so that liburing is not required.
+    // Only a single thread may use a ring.
+    class io_uring_ring {
+    public:
+        io_uring_ring(io_uring_ring const&) = delete;
+        io_uring_ring(io_uring_ring&&) = delete;
+        io_uring_ring& operator=(io_uring_ring const&) = delete;
+        io_uring_ring& operator=(io_uring_ring&&) = delete;
+
+        // Leaves the ring invalid if the kernel refuses to set one up
+        explicit io_uring_ring(unsigned _entries) noexcept {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+
+            m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, _entries, &params));
+            if (m_fd < 0) return;
+
+            m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            bool const singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (singleMmap) m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+            m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+            if (m_sqRing == MAP_FAILED) {
+                fail();
+                return;
+            }
+
+            m_cqRing = singleMmap ? m_sqRing
+                                  : ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+            if (m_cqRing == MAP_FAILED) {
+                fail();
+                return;
+            }
+
+            m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            auto const sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED) {
+                fail();
+                return;
+            }
+            m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+            auto const sqBase = static_cast<char*>(m_sqRing);
+            m_sqHead = reinterpret_cast<unsigned*>(sqBase + params.sq_off.head);
+            m_sqTail = reinterpret_cast<unsigned*>(sqBase + params.sq_off.tail);
+            m_sqMask = *reinterpret_cast<unsigned*>(sqBase + params.sq_off.ring_mask);
+            m_sqArray = reinterpret_cast<unsigned*>(sqBase + params.sq_off.array);
+
+            auto const cqBase = static_cast<char*>(m_cqRing);
+            m_cqHead = reinterpret_cast<unsigned*>(cqBase + params.cq_off.head);
+            m_cqTail = reinterpret_cast<unsigned*>(cqBase + params.cq_off.tail);
+            m_cqMask = *reinterpret_cast<unsigned*>(cqBase + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(cqBase + params.cq_off.cqes);
+
+            m_entries = params.sq_entries;
+        }
+
+        ~io_uring_ring() noexcept { fail(); }
+
+        bool valid() const noexcept { return m_entries != 0; }
+
+        unsigned entries() const noexcept { return m_entries; }
+
+        void prepare_openat(char const* _path, std::uint64_t _userData) noexcept {
+            auto& sqe = next_sqe();
+            sqe.opcode = IORING_OP_OPENAT;
+            sqe.fd = AT_FDCWD;
+            sqe.addr = reinterpret_cast<std::uint64_t>(_path);
+            sqe.open_flags = O_RDONLY | O_CLOEXEC;
+            sqe.user_data = _userData;
+        }
+
+        void prepare_read(int _fd, char* _buffer, unsigned _length, std::uint64_t _offset, std::uint64_t _userData) noexcept {
+            auto& sqe = next_sqe();
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = _fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(_buffer);
+            sqe.len = _length;
+            sqe.off = _offset;
+            sqe.user_data = _userData;
+        }
+
+        // Submits every prepared entry, along with any that an earlier call could not submit, and waits for at least _minComplete
+        // completions. The kernel stops early, without waiting, when it cannot take an entry; the rest stay in the ring and are
+        // submitted by the next call. Returns the number of entries submitted, or a negative errno on failure, including when
+        // none of the pending entries could be submitted.
+        int submit_and_wait(unsigned _minComplete) noexcept {
+            __atomic_store_n(m_sqTail, *m_sqTail + m_prepared, __ATOMIC_RELEASE);
+            m_unsubmitted += m_prepared;
+            m_prepared = 0;
+
+            int result;
+            do {
+                result = static_cast<int>(::syscall(__NR_io_uring_enter, m_fd, m_unsubmitted, _minComplete, IORING_ENTER_GETEVENTS, nullptr, 0));
+            } while (result < 0 && errno == EINTR);
+
+            if (result < 0) return -errno;
+            if (result == 0 && m_unsubmitted != 0) return -EAGAIN;
+
+            m_unsubmitted -= static_cast<unsigned>(result);
+            return result;
+        }
+
+        // Calls _f(user_data, res) for every available completion
+        template<typename F>
+        void drain_completions(F&& _f) {
+            auto head = *m_cqHead;
+
+            while (head != __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+                auto const& cqe = m_cqes[head & m_cqMask];
+                auto const userData = cqe.user_data;
+                auto const res = cqe.res;
+
+                ++head;
+                __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+                _f(userData, res);
+            }
+        }
+
+        // Takes back every submitted entry that the kernel has not consumed, calling _f(user_data) for each. The kernel only
+        // consumes entries inside submit_and_wait, so after one fails the entries it left are never going to run.
+        template<typename F>
+        void withdraw_unconsumed(F&& _f) {
+            auto const head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+
+            for (auto i = head; i != *m_sqTail; ++i) _f(m_sqes[m_sqArray[i & m_sqMask]].user_data);
+
+            __atomic_store_n(m_sqTail, head, __ATOMIC_RELEASE);
+            m_unsubmitted = 0;
+        }
+
+    private:
+        io_uring_sqe& next_sqe() noexcept {
+            // The tail is only published to the kernel in submit_and_wait
+            auto const index = (*m_sqTail + m_prepared) & m_sqMask;
+
+            auto& sqe = m_sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+
+            m_sqArray[index] = index;
+            ++m_prepared;
+
+            return sqe;
+        }
+
+        void fail() noexcept {
+            if (m_sqes) ::munmap(m_sqes, m_sqesSize);
+            if (m_cqRing && m_cqRing != MAP_FAILED && m_cqRing != m_sqRing) ::munmap(m_cqRing, m_cqRingSize);
+            if (m_sqRing && m_sqRing != MAP_FAILED) ::munmap(m_sqRing, m_sqRingSize);
+            if (m_fd >= 0) ::close(m_fd);
+
+            m_sqes = nullptr;
+            m_cqRing = nullptr;
+            m_sqRing = nullptr;
+            m_fd = -1;
+            m_entries = 0;
+        }
+
+        int m_fd = -1;
+        unsigned m_entries = 0;
+        unsigned m_prepared = 0;
+        unsigned m_unsubmitted = 0;
+
+        void* m_sqRing = nullptr;
+        void* m_cqRing = nullptr;
+        std::size_t m_sqRingSize = 0;
+        std::size_t m_cqRingSize = 0;
+        std::size_t m_sqesSize = 0;
+
+        io_uring_sqe* m_sqes = nullptr;
+        unsigned* m_sqHead = nullptr;
+        unsigned* m_sqTail = nullptr;
+        unsigned m_sqMask = 0;
+        unsigned* m_sqArray = nullptr;
+
+        unsigned* m_cqHead = nullptr;
+        unsigned* m_cqTail = nullptr;
+        unsigned m_cqMask = 0;
+        io_uring_cqe* m_cqes = nullptr;
+    };
+}    // namespace randomcat::parser::driver_detail
+
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace randomcat::parser::driver_detail {
+    inline std::size_t resolve_thread_count(std::size_t _requested) noexcept {
+        if (_requested != 0) return _requested;
+        return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    // Every worker owns a queue, which it drains from the front.
+    // Idle workers steal from the back of other workers' queues.
+    class work_stealing_pool {
+    public:
+        // Tasks receive the index of the worker running them and must not throw
+        using task_type = std::function<void(std::size_t)>;
+
+        work_stealing_pool(work_stealing_pool const&) = delete;
+        work_stealing_pool(work_stealing_pool&&) = delete;
+        work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+        work_stealing_pool& operator=(work_stealing_pool&&) = delete;
+
+        explicit work_stealing_pool(std::size_t _threadCount) {
+            auto const threadCount = resolve_thread_count(_threadCount);
+
+            for (std::size_t i = 0; i < threadCount; ++i) m_queues.push_back(std::make_unique<worker_queue>());
+            for (std::size_t i = 0; i < threadCount; ++i) m_threads.emplace_back([this, i] { run(i); });
+        }
+
+        ~work_stealing_pool() noexcept {
+            {
+                std::lock_guard lock(m_stateMutex);
+                m_stop = true;
+            }
+
+            m_wake.notify_all();
+            for (auto& thread : m_threads) thread.join();
+        }
+
+        std::size_t thread_count() const noexcept { return m_threads.size(); }
+
+        // Tasks submitted to the same worker run in submission order unless stolen
+        void submit(task_type _task) {
+            auto const queueIndex = m_nextQueue++ % m_queues.size();
+
+            // Counted before the task is published, so that a worker which takes it at once cannot decrement either count below zero
+            {
+                std::lock_guard lock(m_stateMutex);
+                ++m_queued;
+                ++m_unfinished;
+            }
+
+            {
+                auto& queue = *m_queues[queueIndex];
+                std::lock_guard lock(queue.mutex);
+                queue.tasks.push_back(std::move(_task));
+            }
+
+            m_wake.notify_one();
+        }
+
+        void wait() {
+            std::unique_lock lock(m_stateMutex);
+            m_idle.wait(lock, [&] { return m_unfinished == 0; });
+        }
+
+    private:
+        struct worker_queue {
+            std::mutex mutex;
+            std::deque<task_type> tasks;
+        };
+
+        std::optional<task_type> take_own(std::size_t _index) {
+            auto& queue = *m_queues[_index];
+            std::lock_guard lock(queue.mutex);
+
+            if (queue.tasks.empty()) return std::nullopt;
+
+            auto task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return task;
+        }
+
+        std::optional<task_type> steal(std::size_t _thief) {
+            for (std::size_t offset = 1; offset < m_queues.size(); ++offset) {
+                auto& queue = *m_queues[(_thief + offset) % m_queues.size()];
+                std::lock_guard lock(queue.mutex);
+
+                if (queue.tasks.empty()) continue;
+
+                auto task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                return task;
+            }
+
+            return std::nullopt;
+        }
+
+        void run(std::size_t _index) {
+            while (true) {
+                auto task = take_own(_index);
+                if (not task) task = steal(_index);
+
+                if (task) {
+                    {
+                        std::lock_guard lock(m_stateMutex);
+                        --m_queued;
+                    }
+
+                    (*task)(_index);
+
+                    std::lock_guard lock(m_stateMutex);
+                    if (--m_unfinished == 0) m_idle.notify_all();
+                    continue;
+                }
+
+                std::unique_lock lock(m_stateMutex);
+                m_wake.wait(lock, [&] { return m_stop || m_queued != 0; });
+                if (m_stop) return;
+            }
+        }
+
+        std::vector<std::unique_ptr<worker_queue>> m_queues;
+        std::atomic<std::size_t> m_nextQueue = 0;
+
+        std::mutex m_stateMutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::size_t m_queued = 0;
+        std::size_t m_unfinished = 0;
+        bool m_stop = false;
+
+        std::vector<std::thread> m_threads;
+    };
+}    // namespace randomcat::parser::driver_detail
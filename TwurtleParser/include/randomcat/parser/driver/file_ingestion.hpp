@@ -0,0 +1,337 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/driver/detail/io_uring.hpp"
+#include "randomcat/parser/driver/detail/work_stealing_pool.hpp"
+
+namespace randomcat::parser {
+    // The whole contents of a file, read into a buffer that char sources can view without copying
+    class ingested_file {
+    public:
+        explicit ingested_file(std::unique_ptr<char[]> _data, std::size_t _size, std::chrono::nanoseconds _readTime) noexcept
+        : m_data(std::move(_data)), m_size(_size), m_readTime(_readTime) {}
+
+        std::string_view contents() const noexcept { return std::string_view(m_data.get(), m_size); }
+
+        // The source is only valid for as long as this object is alive
+        string_view_char_source<char, std::char_traits<char>> char_source() const noexcept { return string_view_char_source(contents()); }
+
+        std::chrono::nanoseconds read_time() const noexcept { return m_readTime; }
+
+    private:
+        std::unique_ptr<char[]> m_data;
+        std::size_t m_size;
+        std::chrono::nanoseconds m_readTime;
+    };
+
+    enum class ingestion_backend {
+        io_uring,
+        thread_pool,
+    };
+
+    struct ingestion_options {
+        // Upper bound on the number of files that are open at once
+        std::size_t max_in_flight = 64;
+
+        // Threads used for the pread fallback; 0 means one per hardware thread
+        std::size_t fallback_thread_count = 0;
+
+        bool allow_io_uring = true;
+    };
+
+    namespace ingestion_detail {
+        using clock = std::chrono::steady_clock;
+
+        inline std::uintmax_t file_size_or_zero(std::string const& _path) noexcept {
+            std::error_code ec;
+            auto const size = std::filesystem::file_size(_path, ec);
+            return ec ? 0 : size;
+        }
+
+        // Reads are limited so that a single request always fits the length field of an io_uring entry
+        inline constexpr std::size_t max_read_size = std::size_t(1) << 30;
+
+        inline std::size_t initial_capacity(std::uintmax_t _sizeHint) noexcept {
+            // One more than the hint, so that a correct hint is confirmed by a single short read
+            return static_cast<std::size_t>(_sizeHint) + 1;
+        }
+
+        inline void grow(std::unique_ptr<char[]>& _buffer, std::size_t& _capacity, std::size_t _used) {
+            auto const newCapacity = _capacity * 2;
+            auto newBuffer = std::make_unique<char[]>(newCapacity);
+            std::copy_n(_buffer.get(), _used, newBuffer.get());
+
+            _buffer = std::move(newBuffer);
+            _capacity = newCapacity;
+        }
+
+        inline ingested_file read_with_pread(std::string const& _path, std::uintmax_t _sizeHint) {
+            auto const start = clock::now();
+
+            auto const fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) throw std::system_error(errno, std::system_category(), "Unable to open file: " + _path);
+
+            auto capacity = initial_capacity(_sizeHint);
+            auto buffer = std::make_unique<char[]>(capacity);
+            std::size_t size = 0;
+
+            while (true) {
+                if (size == capacity) grow(buffer, capacity, size);
+
+                auto const requested = std::min(capacity - size, max_read_size);
+                auto const result = ::pread(fd, buffer.get() + size, requested, static_cast<off_t>(size));
+
+                if (result < 0) {
+                    if (errno == EINTR) continue;
+
+                    auto const error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::system_category(), "Unable to read file: " + _path);
+                }
+
+                if (result == 0) break;
+                size += static_cast<std::size_t>(result);
+            }
+
+            ::close(fd);
+            return ingested_file(std::move(buffer), size, clock::now() - start);
+        }
+
+        template<typename OnComplete, typename OnError>
+        void ingest_with_pool(std::vector<std::string> const& _paths,
+                              std::vector<std::uintmax_t> const& _sizeHints,
+                              OnComplete& _onComplete,
+                              OnError& _onError,
+                              ingestion_options const& _options) {
+            auto const threadCount = std::min(driver_detail::resolve_thread_count(_options.fallback_thread_count), std::max<std::size_t>(_options.max_in_flight, 1));
+            driver_detail::work_stealing_pool pool(threadCount);
+
+            for (std::size_t i = 0; i < _paths.size(); ++i) {
+                pool.submit([&, i](std::size_t) {
+                    std::optional<ingested_file> file;
+
+                    try {
+                        file.emplace(read_with_pread(_paths[i], _sizeHints[i]));
+                    } catch (...) {
+                        _onError(i, std::current_exception());
+                        return;
+                    }
+
+                    _onComplete(i, std::move(*file));
+                });
+            }
+
+            pool.wait();
+        }
+
+#if RANDOMCAT_PARSER_HAS_IO_URING
+        struct pending_file {
+            std::size_t index;
+            int fd = -1;
+            std::unique_ptr<char[]> buffer;
+            std::size_t capacity;
+            std::size_t size = 0;
+            std::size_t requested = 0;
+            clock::time_point start;
+        };
+
+        // Returns false without calling any callbacks if no ring could be set up
+        template<typename OnComplete, typename OnError>
+        bool ingest_with_io_uring(std::vector<std::string> const& _paths,
+                                  std::vector<std::uintmax_t> const& _sizeHints,
+                                  OnComplete& _onComplete,
+                                  OnError& _onError,
+                                  ingestion_options const& _options) {
+            auto const requestedSlots = static_cast<unsigned>(std::clamp<std::size_t>(_options.max_in_flight, 1, 4096));
+
+            driver_detail::io_uring_ring ring(requestedSlots);
+            if (not ring.valid()) return false;
+
+            // Every slot has at most one request outstanding, so neither ring can overflow
+            auto const slotCount = std::min<std::size_t>(requestedSlots, ring.entries());
+            std::vector<std::optional<pending_file>> slots(slotCount);
+            std::vector<std::size_t> freeSlots(slotCount);
+            for (std::size_t i = 0; i < slotCount; ++i) freeSlots[i] = slotCount - 1 - i;
+
+            auto const prepare_read = [&](std::size_t _slot) {
+                auto& file = *slots[_slot];
+                if (file.size == file.capacity) grow(file.buffer, file.capacity, file.size);
+
+                file.requested = std::min(file.capacity - file.size, max_read_size);
+                ring.prepare_read(file.fd, file.buffer.get() + file.size, static_cast<unsigned>(file.requested), file.size, _slot);
+            };
+
+            auto const finish = [&](std::size_t _slot, int _error) {
+                auto file = std::move(*slots[_slot]);
+                slots[_slot].reset();
+                freeSlots.push_back(_slot);
+
+                if (file.fd >= 0) ::close(file.fd);
+
+                if (_error != 0) {
+                    auto const& path = _paths[file.index];
+                    _onError(file.index, std::make_exception_ptr(std::system_error(_error, std::system_category(), "Unable to read file: " + path)));
+                } else {
+                    _onComplete(file.index, ingested_file(std::move(file.buffer), file.size, clock::now() - file.start));
+                }
+            };
+
+            auto const read_with_fallback = [&](std::size_t _index) {
+                std::optional<ingested_file> file;
+
+                try {
+                    file.emplace(read_with_pread(_paths[_index], _sizeHints[_index]));
+                } catch (...) {
+                    _onError(_index, std::current_exception());
+                    return;
+                }
+
+                _onComplete(_index, std::move(*file));
+            };
+
+            auto const fall_back = [&](std::size_t _slot) {
+                auto const index = slots[_slot]->index;
+                slots[_slot].reset();
+                freeSlots.push_back(_slot);
+
+                read_with_fallback(index);
+            };
+
+            // After io_uring_enter fails, waits until the kernel is done with every request that is still in flight, so that no
+            // buffer is freed while it may still be written to, then reads every unfinished file with pread instead
+            auto const abandon_ring = [&](std::size_t _nextFile) {
+                std::vector<bool> inFlight(slotCount);
+                std::size_t inFlightCount = 0;
+
+                for (std::size_t slot = 0; slot < slotCount; ++slot) {
+                    inFlight[slot] = slots[slot].has_value();
+                    inFlightCount += inFlight[slot];
+                }
+
+                ring.withdraw_unconsumed([&](std::uint64_t _slot) {
+                    inFlight[_slot] = false;
+                    --inFlightCount;
+                });
+
+                while (inFlightCount != 0) {
+                    if (ring.submit_and_wait(1) < 0) {
+                        // The kernel may still write into these buffers, so they are leaked rather than freed
+                        for (std::size_t slot = 0; slot < slotCount; ++slot) {
+                            if (inFlight[slot]) slots[slot]->buffer.release();
+                        }
+
+                        break;
+                    }
+
+                    ring.drain_completions([&](std::uint64_t _slot, int _result) {
+                        auto& file = *slots[_slot];
+
+                        // A completed openat still has to be closed
+                        if (file.fd < 0 && _result >= 0) file.fd = _result;
+
+                        inFlight[_slot] = false;
+                        --inFlightCount;
+                    });
+                }
+
+                for (std::size_t slot = 0; slot < slotCount; ++slot) {
+                    if (not slots[slot]) continue;
+
+                    if (slots[slot]->fd >= 0) ::close(slots[slot]->fd);
+                    fall_back(slot);
+                }
+
+                for (auto index = _nextFile; index < _paths.size(); ++index) read_with_fallback(index);
+            };
+
+            std::size_t nextFile = 0;
+
+            while (nextFile < _paths.size() || freeSlots.size() != slotCount) {
+                while (nextFile < _paths.size() && not freeSlots.empty()) {
+                    auto const slot = freeSlots.back();
+                    freeSlots.pop_back();
+
+                    auto const capacity = initial_capacity(_sizeHints[nextFile]);
+                    slots[slot] = pending_file{nextFile, -1, std::make_unique<char[]>(capacity), capacity, 0, 0, clock::now()};
+                    ring.prepare_openat(_paths[nextFile].c_str(), slot);
+
+                    ++nextFile;
+                }
+
+                if (ring.submit_and_wait(1) < 0) {
+                    abandon_ring(nextFile);
+                    break;
+                }
+
+                ring.drain_completions([&](std::uint64_t _slot, int _result) {
+                    auto& file = *slots[_slot];
+
+                    if (file.fd < 0) {
+                        // Kernels that predate IORING_OP_OPENAT reject it with EINVAL
+                        if (_result == -EINVAL) return fall_back(_slot);
+                        if (_result < 0) return finish(_slot, -_result);
+
+                        file.fd = _result;
+                        return prepare_read(_slot);
+                    }
+
+                    if (_result < 0) return finish(_slot, -_result);
+
+                    auto const amountRead = static_cast<std::size_t>(_result);
+                    file.size += amountRead;
+
+                    // A short read on a regular file means that its end has been reached
+                    if (amountRead < file.requested) return finish(_slot, 0);
+
+                    prepare_read(_slot);
+                });
+            }
+
+            return true;
+        }
+#endif
+    }    // namespace ingestion_detail
+
+    // Reads every file in _paths and calls _onComplete(index, ingested_file&&) or _onError(index, std::exception_ptr) for it.
+    // _sizeHints (either empty or one per path) only size the initial buffers; files are always read to the end.
+    // With io_uring, callbacks run on the calling thread (as do the pread reads of the files left over if the ring fails midway).
+    // With the thread pool fallback, they run concurrently on pool threads.
+    // Callbacks must not throw.
+    template<typename OnComplete, typename OnError>
+    ingestion_backend ingest_files(std::vector<std::string> const& _paths,
+                                   std::vector<std::uintmax_t> _sizeHints,
+                                   OnComplete&& _onComplete,
+                                   OnError&& _onError,
+                                   ingestion_options const& _options = {}) {
+        if (_sizeHints.empty()) {
+            _sizeHints.reserve(_paths.size());
+            for (auto const& path : _paths) _sizeHints.push_back(ingestion_detail::file_size_or_zero(path));
+        }
+
+#if RANDOMCAT_PARSER_HAS_IO_URING
+        if (_options.allow_io_uring && ingestion_detail::ingest_with_io_uring(_paths, _sizeHints, _onComplete, _onError, _options))
+            return ingestion_backend::io_uring;
+#endif
+
+        ingestion_detail::ingest_with_pool(_paths, _sizeHints, _onComplete, _onError, _options);
+        return ingestion_backend::thread_pool;
+    }
+}    // namespace randomcat::parser
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace randomcat::parser {
+    // An error policy decides what a failed tokenizer or grammar test reports. A tokenizer is given one with with_error_policy, and
+    // the token streams reading from it and every grammar tested on those streams use the same policy.
+    //
+    // Policies provide:
+    //   aggregates                     whether errors are built from the errors of every part that failed
+    //   error_type<Aggregate>          the error reported instead of Aggregate, the aggregate error a test would build
+    //   failure(position)              the error for a failure the given amount (chars or tokens) after the start of the test,
+    //                                  only for policies that do not aggregate
+
+    // Reports everything: simple_tokenizer every descriptor's error, selection_grammar every alternative's error and sequence_grammar
+    // which element failed and how
+    struct aggregate_errors {
+        static constexpr bool aggregates = true;
+
+        template<typename Aggregate>
+        using error_type = Aggregate;
+    };
+
+    struct fast_fail_error {};
+
+    // Only reports that there was no match, so failing costs nothing beyond the test itself
+    struct fast_fail_errors {
+        static constexpr bool aggregates = false;
+
+        template<typename Aggregate>
+        using error_type = fast_fail_error;
+
+        static constexpr fast_fail_error failure(std::size_t) noexcept { return {}; }
+    };
+
+    struct farthest_failure {
+        // Relative to the start of the failed test: tokens for grammars, chars for tokenizers
+        std::size_t position = 0;
+    };
+
+    // Only reports how far the farthest failing part of a test got, which is usually where the input is wrong
+    struct farthest_failure_errors {
+        static constexpr bool aggregates = false;
+
+        template<typename Aggregate>
+        using error_type = farthest_failure;
+
+        static constexpr farthest_failure failure(std::size_t _position) noexcept { return {_position}; }
+    };
+
+    namespace error_policy_detail {
+        template<typename T, typename = void>
+        struct error_policy {
+            using type = aggregate_errors;
+        };
+
+        template<typename T>
+        struct error_policy<T, std::void_t<typename T::error_policy>> {
+            using type = typename T::error_policy;
+        };
+
+        // The error policy of a tokenizer or token stream, aggregate_errors if it does not name one
+        template<typename T>
+        using error_policy_t = typename error_policy<T>::type;
+
+        // Where a part's error says the part failed, relative to the start of the part
+        template<typename Error>
+        constexpr std::size_t failure_position(Error const& _error) noexcept {
+            if constexpr (std::is_same_v<Error, farthest_failure>) {
+                return _error.position;
+            } else {
+                return 0;
+            }
+        }
+    }    // namespace error_policy_detail
+}    // namespace randomcat::parser
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <optional>
 #include <tuple>
 #include <variant>
@@ -8,8 +9,17 @@
 #include <randomcat/type_container/type_list.hpp>
 
 #include "randomcat/parser/detail/util.hpp"
+#include "randomcat/parser/error_policy.hpp"
 #include "randomcat/parser/tokens/token_stream/token_stream.hpp"
 
+#if defined(RANDOMCAT_PARSER_GRAMMAR_PROFILING) || defined(RANDOMCAT_PARSER_TRACING)
+#    include "randomcat/parser/diagnostics/grammar_profiler.hpp"
+#endif
+
+#ifdef RANDOMCAT_PARSER_TRACING
+#    include "randomcat/parser/diagnostics/trace.hpp"
+#endif
+
 namespace randomcat::parser {
     struct grammar_base {};
     
@@ -31,6 +41,23 @@ namespace randomcat::parser {
         
         template<typename T, typename Default>
         using context_type_t = typename context_type<T, Default>::type;
+
+        // Combinators report errors as the error policy of the token stream they are tested on says (see error_policy.hpp)
+        template<typename TokenStream>
+        using error_policy_t = typename token_stream_traits<TokenStream>::error_policy;
+
+#ifdef RANDOMCAT_PARSER_TRACING
+        // Names grammars in traces: tagged grammars by their rule name, others by their type if the recorder asks for them
+        template<typename Grammar>
+        struct grammar_trace_name {
+            static char const* get() {
+                if (not trace_recorder::active()->options().untagged_grammars) return nullptr;
+
+                static std::string const name = grammar_profiler_detail::tag_name<Grammar>();
+                return name.c_str();
+            }
+        };
+#endif
     }
     
     template<typename Grammar, typename TokenStream>
@@ -53,7 +80,13 @@ namespace randomcat::parser {
         }
 
         template<bool Enable = not has_context_type, typename = std::enable_if_t<Enable>>
-        constexpr static result_type test(Grammar const& _grammar, TokenStream const& _tokenStream) { return _grammar.test(_tokenStream); }
+        constexpr static result_type test(Grammar const& _grammar, TokenStream const& _tokenStream) {
+#ifdef RANDOMCAT_PARSER_TRACING
+            trace_span span(trace_category::grammar, &grammar_detail::grammar_trace_name<Grammar>::get);
+#endif
+
+            return _grammar.test(_tokenStream);
+        }
 
         template<bool Enable = has_context_type>
         constexpr static result_type advance_if_matches(Grammar const& _grammar, TokenStream& _tokenStream, std::enable_if_t<Enable, context_type>& _context) {
@@ -64,6 +97,10 @@ namespace randomcat::parser {
 
         template<bool Enable = has_context_type>
         constexpr static result_type test(Grammar const& _grammar, TokenStream const& _tokenStream, std::enable_if_t<Enable, context_type>& _context) {
+#ifdef RANDOMCAT_PARSER_TRACING
+            trace_span span(trace_category::grammar, &grammar_detail::grammar_trace_name<Grammar>::get);
+#endif
+
             return _grammar.test(_tokenStream, _context);
         }
     };
@@ -113,7 +150,7 @@ namespace randomcat::parser {
         template<typename TokenStream>
         struct traits_for {
             using value_type = typename token_stream_traits<TokenStream>::token_type;
-            using error_type = grammar_non_match_t;
+            using error_type = typename grammar_detail::error_policy_t<TokenStream>::template error_type<grammar_non_match_t>;
             using result_type = parse_result<value_type, error_type>;
         };
 
@@ -121,10 +158,18 @@ namespace randomcat::parser {
 
         template<typename TokenStream>
         constexpr typename traits_for<TokenStream>::result_type test(TokenStream const& _stream) const {
-            auto token = token_stream_traits<TokenStream>::peek(_stream);
-            if (m_matches(token)) return {token, 1};
+            // A token that cannot be fetched (e.g. at the end or in a region that does not lex) does not match; try_peek reports it
+            // without throwing, since grammars test many alternatives at the same position
+            auto token = token_stream_traits<TokenStream>::try_peek(_stream);
+            if (token.is_value() && m_matches(token.value())) return {std::move(token).value(), 1};
+
+            using error_policy = grammar_detail::error_policy_t<TokenStream>;
 
-            return grammar_non_match;
+            if constexpr (error_policy::aggregates) {
+                return grammar_non_match;
+            } else {
+                return error_policy::failure(0);
+            }
         }
 
     private:
@@ -243,8 +288,8 @@ namespace randomcat::parser {
         struct traits_for {
             using value_type =
                 grammar_tuple_detail::grammar_tuple<type_container::type_list<SubGrammars...>, type_container::type_list<grammar_value_type_t<SubGrammars, TokenStream>...>>;
-            using error_type =
-                grammar_variant_detail::grammar_variant<type_container::type_list<SubGrammars...>, type_container::type_list<grammar_error_type_t<SubGrammars, TokenStream>...>>;
+            using error_type = typename grammar_detail::error_policy_t<TokenStream>::template error_type<
+                grammar_variant_detail::grammar_variant<type_container::type_list<SubGrammars...>, type_container::type_list<grammar_error_type_t<SubGrammars, TokenStream>...>>>;
 
             using result_type = parse_result<value_type, error_type>;
         };
@@ -262,6 +307,8 @@ namespace randomcat::parser {
             auto optTuple = std::tuple<std::optional<grammar_value_type_t<SubGrammars, TokenStream>>...>();
             std::optional<typename traits_for<TokenStream>::error_type> error = std::nullopt;
 
+            using error_policy = grammar_detail::error_policy_t<TokenStream>;
+
             typename token_stream_traits<TokenStream>::access_wrapper accessWrapper(_tokenStream);
             typename traits_for<TokenStream>::result_type::size_type amountParsed = 0;
 
@@ -277,8 +324,10 @@ namespace randomcat::parser {
                          accessWrapper.advance(thisParse);
 
                          std::get<Is>(optTuple) = std::move(result).value();
-                     } else {
+                     } else if constexpr (error_policy::aggregates) {
                          error = typename traits_for<TokenStream>::error_type(std::in_place_index<Is>, std::move(result).error());
+                     } else {
+                         error = error_policy::failure(amountParsed + error_policy_detail::failure_position(result.error()));
                      }
                  }(std::get<Is>(m_subGrammars)),
                  void()),
@@ -334,8 +383,8 @@ namespace randomcat::parser {
         struct traits_for {
             using value_type =
                 grammar_variant_detail::grammar_variant<type_container::type_list<SubGrammars...>, type_container::type_list<grammar_value_type_t<SubGrammars, TokenStream>...>>;
-            using error_type =
-                grammar_tuple_detail::grammar_tuple<type_container::type_list<SubGrammars...>, type_container::type_list<grammar_error_type_t<SubGrammars, TokenStream>...>>;
+            using error_type = typename grammar_detail::error_policy_t<TokenStream>::template error_type<
+                grammar_tuple_detail::grammar_tuple<type_container::type_list<SubGrammars...>, type_container::type_list<grammar_error_type_t<SubGrammars, TokenStream>...>>>;
 
             using result_type = parse_result<value_type, error_type>;
         };
@@ -349,7 +398,13 @@ namespace randomcat::parser {
         template<typename TokenStream, std::size_t... Is>
         constexpr typename traits_for<TokenStream>::result_type test_helper(std::index_sequence<Is...>, TokenStream const& _tokenStream) const {
             std::optional<typename traits_for<TokenStream>::result_type> result = std::nullopt;
-            std::tuple<std::optional<grammar_error_type_t<SubGrammars, TokenStream>>...> error;
+
+            using error_policy = grammar_detail::error_policy_t<TokenStream>;
+
+            // Every alternative's error if the error policy aggregates, otherwise how far the farthest alternative got
+            using errors_type = std::tuple<std::optional<grammar_error_type_t<SubGrammars, TokenStream>>...>;
+            [[maybe_unused]] std::conditional_t<error_policy::aggregates, errors_type, std::tuple<>> error;
+            [[maybe_unused]] std::size_t farthestFailure = 0;
 
             ((
                  [&](auto const& subGrammar) {
@@ -362,20 +417,29 @@ namespace randomcat::parser {
                                                                                                                              std::move(parseResult)
                                                                                                                                  .value()},
                                                                                 std::move(amountParsed));
-                     } else {
+                     } else if constexpr (error_policy::aggregates) {
                          std::get<Is>(error) = std::move(parseResult).error();
+                     } else {
+                         farthestFailure = std::max(farthestFailure, error_policy_detail::failure_position(parseResult.error()));
                      }
                  }(std::get<Is>(m_subGrammars)),
                  void()),
              ...);
 
             if (result) return *std::move(result);
-            return typename traits_for<TokenStream>::error_type{std::get<Is>(std::move(error)).value()...};
+
+            if constexpr (error_policy::aggregates) {
+                return typename traits_for<TokenStream>::error_type{std::get<Is>(std::move(error)).value()...};
+            } else {
+                return error_policy::failure(farthestFailure);
+            }
         }
 
         std::tuple<SubGrammars...> m_subGrammars;
     };
 
+    // Tags have no effect on parsing. When RANDOMCAT_PARSER_GRAMMAR_PROFILING is defined, they name the rule in the
+    // grammar_profiler installed on the current thread, if any.
     template<typename Base, typename... Tags>
     class tag_grammar_t : grammar_base {
     public:
@@ -391,16 +455,44 @@ namespace randomcat::parser {
             using result_type = grammar_result_type_t<Base, TokenStream>;
         };
 
+#ifdef RANDOMCAT_PARSER_GRAMMAR_PROFILING
+        template<typename TokenStream>
+        typename traits_for<TokenStream>::result_type test(TokenStream const& _tokenStream) const {
+            auto* const profiler = grammar_profiler::current();
+            if (sizeof...(Tags) == 0 || not profiler) return grammar_test(m_subGrammar, _tokenStream);
+
+            grammar_profiler::rule_call call(*profiler, grammar_profiler_detail::rule_name<Tags...>());
+
+            auto result = grammar_test(m_subGrammar, _tokenStream);
+            call.finish(result.is_value(), result.is_value() ? result.amount_parsed() : 0);
+
+            return result;
+        }
+#else
         template<typename TokenStream>
         constexpr typename traits_for<TokenStream>::result_type test(TokenStream const& _tokenStream) const
             noexcept(noexcept(grammar_test(m_subGrammar, _tokenStream))) {
             return grammar_test(m_subGrammar, _tokenStream);
         }
+#endif
 
     private:
         Base m_subGrammar;
     };
 
+#ifdef RANDOMCAT_PARSER_TRACING
+    template<typename Base, typename... Tags>
+    struct grammar_detail::grammar_trace_name<tag_grammar_t<Base, Tags...>> {
+        static char const* get() {
+            if constexpr (sizeof...(Tags) == 0) {
+                return nullptr;
+            } else {
+                return grammar_profiler_detail::rule_name<Tags...>().c_str();
+            }
+        }
+    };
+#endif
+
     template<typename... Tags, typename Base>
     constexpr inline tag_grammar_t<Base, Tags...> tag_grammar(Base _baseGrammar) {
         return tag_grammar_t<Base, Tags...>(std::move(_baseGrammar));
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <limits>
+#include <new>
 #include <optional>
 #include <tuple>
 #include <type_traits>
@@ -10,7 +12,118 @@
 #include <randomcat/parser/detail/util.hpp>
 
 namespace randomcat::parser {
-    template<typename ValueType, typename ErrorType>
+    namespace parse_result_detail {
+        using size_type = std::size_t;
+
+        // Stored as the amount parsed of a result that is an error, in results that do not need to store their error
+        inline constexpr auto error_amount = std::numeric_limits<size_type>::max();
+
+        // Errors that carry no information (void and empty types) are not stored; results with them are compact
+        template<typename ErrorType>
+        inline constexpr auto is_compact_error_v = std::is_void_v<ErrorType> || (std::is_empty_v<ErrorType> && std::is_default_constructible_v<ErrorType>);
+
+        // Unlike std::pair, trivially copyable when ValueType is
+        template<typename ValueType>
+        struct value_and_amount {
+            // Moves the value straight into place; values may be expensive to move (or only copyable)
+            constexpr value_and_amount(ValueType&& _value, size_type _amount) noexcept(std::is_nothrow_move_constructible_v<ValueType>)
+            : value(std::move(_value)), amount(_amount) {}
+
+            ValueType value;
+            size_type amount;
+        };
+
+        // A value and the amount parsed, or nothing if the amount is error_amount.
+        // Trivially copyable and destructible when ValueType is.
+        template<typename ValueType, bool Trivial = std::is_trivially_copyable_v<ValueType>&& std::is_trivially_destructible_v<ValueType>>
+        class compact_value {
+        public:
+            constexpr compact_value() noexcept : m_none(), m_amount(error_amount) {}
+
+            constexpr compact_value(ValueType&& _value, size_type _amount) noexcept(std::is_nothrow_move_constructible_v<ValueType>)
+            : m_value(std::move(_value)), m_amount(_amount) {}
+
+            constexpr bool has_value() const noexcept { return m_amount != error_amount; }
+
+            constexpr ValueType const& value() const& noexcept { return m_value; }
+            constexpr ValueType&& value() && noexcept { return std::move(m_value); }
+
+            constexpr size_type amount() const noexcept { return m_amount; }
+
+        private:
+            struct none_t {};
+
+            union {
+                none_t m_none;
+                ValueType m_value;
+            };
+
+            size_type m_amount;
+        };
+
+        template<typename ValueType>
+        class compact_value<ValueType, false> {
+        public:
+            compact_value() noexcept : m_none(), m_amount(error_amount) {}
+
+            compact_value(ValueType&& _value, size_type _amount) noexcept(std::is_nothrow_move_constructible_v<ValueType>)
+            : m_value(std::move(_value)), m_amount(_amount) {}
+
+            compact_value(compact_value const& _other) : m_none(), m_amount(error_amount) { assign(_other); }
+
+            compact_value(compact_value&& _other) noexcept(std::is_nothrow_move_constructible_v<ValueType>) : m_none(), m_amount(error_amount) {
+                assign(std::move(_other));
+            }
+
+            compact_value& operator=(compact_value const& _other) {
+                if (this != &_other) assign(_other);
+                return *this;
+            }
+
+            compact_value& operator=(compact_value&& _other) noexcept(std::is_nothrow_move_constructible_v<ValueType>) {
+                if (this != &_other) assign(std::move(_other));
+                return *this;
+            }
+
+            ~compact_value() noexcept { reset(); }
+
+            bool has_value() const noexcept { return m_amount != error_amount; }
+
+            ValueType const& value() const& noexcept { return m_value; }
+            ValueType&& value() && noexcept { return std::move(m_value); }
+
+            size_type amount() const noexcept { return m_amount; }
+
+        private:
+            void reset() noexcept {
+                if (has_value()) m_value.~ValueType();
+                m_amount = error_amount;
+            }
+
+            // If constructing the value throws, this is left empty
+            template<typename Other>
+            void assign(Other&& _other) {
+                reset();
+                if (not _other.has_value()) return;
+
+                ::new (static_cast<void*>(std::addressof(m_value))) ValueType(std::forward<Other>(_other).m_value);
+                m_amount = _other.m_amount;
+            }
+
+            struct none_t {};
+
+            union {
+                none_t m_none;
+                ValueType m_value;
+            };
+
+            size_type m_amount;
+        };
+    }    // namespace parse_result_detail
+
+    // Errors that carry no information are not stored (see parse_result_detail::is_compact_error_v); such results only hold the value
+    // and the amount parsed, with a sentinel amount for errors.
+    template<typename ValueType, typename ErrorType, typename = void>
     class parse_result {
     public:
         using value_type = ValueType;
@@ -36,20 +149,20 @@ namespace randomcat::parser {
 
         [[nodiscard]] constexpr explicit operator bool() const noexcept { return is_value(); }
 
-        [[nodiscard]] constexpr value_type const& value() const& noexcept { return std::get<0>(m_value).first; }
-        [[nodiscard]] constexpr value_type&& value() && noexcept { return std::get<0>(std::move(m_value)).first; }
+        [[nodiscard]] constexpr value_type const& value() const& noexcept { return std::get<0>(m_value).value; }
+        [[nodiscard]] constexpr value_type&& value() && noexcept { return std::get<0>(std::move(m_value)).value; }
 
         [[nodiscard]] constexpr error_type const& error() const& noexcept { return std::get<1>(m_value); }
         [[nodiscard]] constexpr error_type&& error() && noexcept { return std::get<1>(std::move(m_value)); }
 
-        [[nodiscard]] constexpr size_type amount_parsed() const noexcept { return std::get<0>(m_value).second; }
+        [[nodiscard]] constexpr size_type amount_parsed() const noexcept { return std::get<0>(m_value).amount; }
 
     private:
-        std::variant<std::pair<ValueType, size_type>, ErrorType> m_value;
+        std::variant<parse_result_detail::value_and_amount<ValueType>, ErrorType> m_value;
     };
 
     template<typename ErrorType>
-    class parse_result<void, ErrorType> {
+    class parse_result<void, ErrorType, std::enable_if_t<not parse_result_detail::is_compact_error_v<ErrorType>>> {
     public:
         using value_type = void;
         using error_type = ErrorType;
@@ -78,31 +191,80 @@ namespace randomcat::parser {
         std::variant<size_type, ErrorType> m_value;
     };
 
-    template<typename ValueType>
-    class parse_result<ValueType, void> {
+    // A value and an error without information (or none at all, if ErrorType is void). Empty errors are returned by value.
+    template<typename ValueType, typename ErrorType>
+    class parse_result<ValueType,
+                       ErrorType,
+                       std::enable_if_t<not std::is_void_v<ValueType> && parse_result_detail::is_compact_error_v<ErrorType>>> {
+    private:
+        // Stands in for the error constructor and error() when ErrorType is void
+        struct no_error_t {};
+        using error_or_none = std::conditional_t<std::is_void_v<ErrorType>, no_error_t, ErrorType>;
+
     public:
         using value_type = ValueType;
-        using error_type = void;
+        using error_type = ErrorType;
         using size_type = std::size_t;
 
         static_assert(util_detail::is_simple_type_v<ValueType>);
+        static_assert(not std::is_same_v<value_type, error_type>);
+
+        /* implicit */ constexpr parse_result(value_type _value, size_type _amountParsed) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+        : m_value(std::move(_value), std::move(_amountParsed)) {}
 
-        /* implicit */ constexpr parse_result(value_type _value, size_type _amountParsed)
-        : m_value({std::move(_value), std::move(_amountParsed)}) {}
+        /* implicit */ constexpr parse_result(error_or_none) noexcept {}
 
-        /* implicit */ constexpr parse_result() : m_value(std::nullopt) {}
+        /* implicit */ constexpr parse_result() noexcept = default;
 
         [[nodiscard]] constexpr bool is_value() const noexcept { return m_value.has_value(); }
+
+        [[nodiscard]] constexpr bool is_error() const noexcept { return not is_value(); }
+
+        [[nodiscard]] constexpr explicit operator bool() const noexcept { return is_value(); }
+
+        [[nodiscard]] constexpr value_type const& value() const& noexcept { return m_value.value(); }
+        [[nodiscard]] constexpr value_type&& value() && noexcept { return std::move(m_value).value(); }
+
+        template<typename ErrorType_ = ErrorType, typename = std::enable_if_t<not std::is_void_v<ErrorType_>>>
+        [[nodiscard]] constexpr ErrorType_ error() const noexcept {
+            return ErrorType_();
+        }
+
+        [[nodiscard]] constexpr size_type amount_parsed() const noexcept { return m_value.amount(); }
+
+    private:
+        parse_result_detail::compact_value<ValueType> m_value;
+    };
+
+    template<typename ErrorType>
+    class parse_result<void, ErrorType, std::enable_if_t<parse_result_detail::is_compact_error_v<ErrorType>>> {
+    private:
+        struct no_error_t {};
+        using error_or_none = std::conditional_t<std::is_void_v<ErrorType>, no_error_t, ErrorType>;
+
+    public:
+        using value_type = void;
+        using error_type = ErrorType;
+        using size_type = std::size_t;
+
+        /* implicit */ constexpr parse_result(size_type _amountParsed) noexcept : m_amountParsed(_amountParsed) {}
+
+        /* implicit */ constexpr parse_result(error_or_none) noexcept {}
+
+        [[nodiscard]] constexpr bool is_value() const noexcept { return m_amountParsed != parse_result_detail::error_amount; }
+
         [[nodiscard]] constexpr bool is_error() const noexcept { return not is_value(); }
 
         [[nodiscard]] constexpr explicit operator bool() const noexcept { return is_value(); }
 
-        [[nodiscard]] constexpr value_type const& value() const& noexcept { return std::get<0>(m_value.value()); }
-        [[nodiscard]] constexpr value_type&& value() && noexcept { return std::get<0>(std::move(m_value).value()); }
+        template<typename ErrorType_ = ErrorType, typename = std::enable_if_t<not std::is_void_v<ErrorType_>>>
+        [[nodiscard]] constexpr ErrorType_ error() const noexcept {
+            return ErrorType_();
+        }
 
-        [[nodiscard]] constexpr size_type amount_parsed() const noexcept { return std::get<1>(m_value.value()); }
+        [[nodiscard]] constexpr size_type amount_parsed() const noexcept { return m_amountParsed; }
 
     private:
-        std::optional<std::pair<value_type, size_type>> m_value;
+        size_type m_amountParsed = parse_result_detail::error_amount;
     };
-}    // namespace randomcat::parser
\ No newline at end of file
+}    // namespace randomcat::parser
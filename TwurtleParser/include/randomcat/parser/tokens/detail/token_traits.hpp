@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <utility>
 
 #include "randomcat/parser/detail/defaults.hpp"
 
@@ -23,4 +24,29 @@ namespace randomcat::parser::token_traits_detail {
 
     template<typename T, typename Default = default_size_type>
     using size_type_t = typename size_type<T, Default>::type;
+
+    template<typename T, typename Default, typename = void>
+    struct error_type {
+        using type = Default;
+    };
+
+    template<typename T, typename Default>
+    struct error_type<T, Default, std::void_t<typename T::error_type>> {
+        using type = typename T::error_type;
+    };
+
+    template<typename T, typename Default = void>
+    using error_type_t = typename error_type<T, Default>::type;
+
+    template<typename T, typename = void>
+    struct has_try_read : std::false_type {};
+
+    template<typename T>
+    struct has_try_read<T, std::void_t<decltype(std::declval<T&>().try_read())>> : std::true_type {};
+
+    template<typename T, typename = void>
+    struct has_try_peek : std::false_type {};
+
+    template<typename T>
+    struct has_try_peek<T, std::void_t<decltype(std::declval<T const&>().try_peek())>> : std::true_type {};
 }    // namespace randomcat::parser::token_traits_detail
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <vector>
+
+#include "randomcat/parser/driver/detail/work_stealing_pool.hpp"
+
+namespace randomcat::parser {
+    // What a state_filter does with one element: the state it moves to, and whether the element is kept
+    struct state_filter_step {
+        std::size_t next;
+        bool keep;
+    };
+
+    struct parallel_filter_options {
+        // 0 means one per hardware thread
+        std::size_t thread_count = 0;
+
+        // Inputs shorter than this are filtered on the calling thread; spreading them over threads costs more than it saves
+        std::size_t min_block_size = 16 * 1024;
+
+        // Blocks per thread, so that threads that finish early can steal the rest
+        std::size_t blocks_per_thread = 4;
+    };
+
+    namespace parallel_filter_detail {
+        // How a block moves every possible start state, and how many of its elements each start keeps
+        template<std::size_t StateCount>
+        struct block_summary {
+            std::array<std::size_t, StateCount> end_state;
+            std::array<std::size_t, StateCount> kept;
+        };
+
+        // The number of elements kept from _state on, which is left as the state after the last one
+        template<typename T, typename Step>
+        std::size_t count_kept(T const* _begin, T const* _end, std::size_t& _state, Step const& _step) {
+            std::size_t kept = 0;
+
+            for (auto it = _begin; it != _end; ++it) {
+                auto const step = _step(_state, *it);
+                _state = step.next;
+                kept += step.keep;
+            }
+
+            return kept;
+        }
+
+        template<std::size_t StateCount, typename T, typename Step>
+        block_summary<StateCount> summarize(T const* _begin, T const* _end, Step const& _step) {
+            block_summary<StateCount> summary;
+
+            for (std::size_t start = 0; start < StateCount; ++start) {
+                auto state = start;
+                summary.kept[start] = count_kept(_begin, _end, state, _step);
+                summary.end_state[start] = state;
+            }
+
+            return summary;
+        }
+
+        template<typename T, typename Step>
+        void filter_into(T const* _begin, T const* _end, std::size_t _state, Step const& _step, std::vector<T>& _out) {
+            for (auto it = _begin; it != _end; ++it) {
+                auto const step = _step(_state, *it);
+                _state = step.next;
+                if (step.keep) _out.push_back(*it);
+            }
+        }
+
+        // Runs _f(block) for every block in _pool, rethrowing the first exception any of them threw
+        template<typename F>
+        void for_each_block(driver_detail::work_stealing_pool& _pool, std::size_t _blockCount, F const& _f) {
+            std::vector<std::exception_ptr> errors(_blockCount);
+
+            for (std::size_t block = 0; block < _blockCount; ++block) {
+                _pool.submit([&, block](std::size_t) {
+                    try {
+                        _f(block);
+                    } catch (...) {
+                        errors[block] = std::current_exception();
+                    }
+                });
+            }
+
+            _pool.wait();
+
+            for (auto const& error : errors) {
+                if (error) std::rethrow_exception(error);
+            }
+        }
+    }    // namespace parallel_filter_detail
+
+    // The elements of _values a state machine keeps, in order, where _step(state, element) returns a state_filter_step and states
+    // are 0 to StateCount - 1, starting from _initialState. The result is exactly what running the machine over _values in order
+    // would keep, but huge inputs are split into blocks that are filtered on separate threads:
+    //   1. Every block is summarized, in parallel, as the state it ends in and the number of elements it keeps from each possible
+    //      start state. StateCount is small, so this is a handful of passes over the block.
+    //   2. The summaries are composed in order to find the state each block really starts in, and where its elements go. There
+    //      are only a few blocks per thread, so this runs on the calling thread.
+    //   3. Every block is filtered again from its real start state, in parallel.
+    template<std::size_t StateCount, typename T, typename Step>
+    std::vector<T> parallel_state_filter(std::vector<T> const& _values,
+                                         Step const& _step,
+                                         std::size_t _initialState = 0,
+                                         parallel_filter_options const& _options = {}) {
+        static_assert(StateCount > 0);
+
+        namespace detail = parallel_filter_detail;
+
+        auto const threadCount = driver_detail::resolve_thread_count(_options.thread_count);
+        auto const blockCount = std::min(threadCount * std::max<std::size_t>(_options.blocks_per_thread, 1),
+                                         _values.size() / std::max<std::size_t>(_options.min_block_size, 1));
+
+        std::vector<T> result;
+
+        if (threadCount == 1 || blockCount <= 1) {
+            // Counting first is a pass over the elements without copying them, which is cheaper than growing the result
+            auto endState = _initialState;
+            auto const kept = detail::count_kept(_values.data(), _values.data() + _values.size(), endState, _step);
+
+            result.reserve(kept);
+            detail::filter_into(_values.data(), _values.data() + _values.size(), _initialState, _step, result);
+            return result;
+        }
+
+        auto const blockBegin = [&](std::size_t _block) { return _values.data() + _values.size() * _block / blockCount; };
+
+        driver_detail::work_stealing_pool pool(std::min(threadCount, blockCount));
+
+        std::vector<detail::block_summary<StateCount>> summaries(blockCount);
+        detail::for_each_block(pool, blockCount, [&](std::size_t _block) {
+            summaries[_block] = detail::summarize<StateCount>(blockBegin(_block), blockBegin(_block + 1), _step);
+        });
+
+        std::vector<std::size_t> startStates(blockCount);
+        std::size_t keptCount = 0;
+
+        for (std::size_t block = 0, state = _initialState; block < blockCount; ++block) {
+            startStates[block] = state;
+            keptCount += summaries[block].kept[state];
+            state = summaries[block].end_state[state];
+        }
+
+        std::vector<std::vector<T>> blockResults(blockCount);
+        detail::for_each_block(pool, blockCount, [&](std::size_t _block) {
+            blockResults[_block].reserve(summaries[_block].kept[startStates[_block]]);
+            detail::filter_into(blockBegin(_block), blockBegin(_block + 1), startStates[_block], _step, blockResults[_block]);
+        });
+
+        // Only moves elements that were already copied on the workers
+        result.reserve(keptCount);
+        for (auto& blockResult : blockResults) std::move(blockResult.begin(), blockResult.end(), std::back_inserter(result));
+
+        return result;
+    }
+}    // namespace randomcat::parser
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/chars/tokenizer.hpp"
+#include "randomcat/parser/detail/swar.hpp"
+#include "randomcat/parser/parse_result.hpp"
+
+namespace randomcat::parser {
+    // Codec kinds (see token_cache.hpp) that token_buffer operations select. Small and fixed, like scan_set, so that a whole block
+    // of kinds is compared against all of them at once.
+    class token_kind_set {
+    public:
+        static constexpr std::size_t max_kinds = 8;
+
+        // token_buffer stores kinds as bytes
+        static constexpr std::uint32_t max_kind = 0xFF;
+
+        // Throws std::invalid_argument unless _kinds has 1 to max_kinds kinds, each at most max_kind
+        constexpr token_kind_set(std::initializer_list<std::uint32_t> _kinds) {
+            if (_kinds.size() == 0 || _kinds.size() > max_kinds) {
+                throw std::invalid_argument("A token_kind_set needs 1 to " + std::to_string(max_kinds) + " kinds");
+            }
+
+            std::size_t i = 0;
+
+            for (auto const kind : _kinds) {
+                if (kind > max_kind) throw std::invalid_argument("A token_kind_set can only hold kinds up to " + std::to_string(max_kind));
+                m_kinds[i++] = static_cast<std::uint8_t>(kind);
+            }
+
+            // Repeating the first kind makes every comparison use exactly max_kinds kinds
+            for (; i < max_kinds; ++i) m_kinds[i] = m_kinds[0];
+        }
+
+        constexpr bool contains(std::uint8_t _kind) const noexcept {
+            for (auto const kind : m_kinds) {
+                if (kind == _kind) return true;
+            }
+
+            return false;
+        }
+
+        constexpr std::uint8_t at(std::size_t _index) const noexcept { return m_kinds[_index]; }
+
+    private:
+        std::uint8_t m_kinds[max_kinds] = {};
+    };
+
+    namespace token_buffer_detail {
+#if defined(__SSE2__)
+        inline constexpr std::size_t block_size = 16;
+
+        // Bit i is set if and only if _kinds[i] is in _set, for the block_size kinds at _kinds
+        inline unsigned block_matches(std::uint8_t const* _kinds, token_kind_set const& _set) noexcept {
+            auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(_kinds));
+            auto matches = _mm_setzero_si128();
+
+            for (std::size_t i = 0; i < token_kind_set::max_kinds; ++i) {
+                matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(_set.at(i)))));
+            }
+
+            return static_cast<unsigned>(_mm_movemask_epi8(matches));
+        }
+#else
+        inline constexpr std::size_t block_size = 8;
+
+        inline unsigned block_matches(std::uint8_t const* _kinds, token_kind_set const& _set) noexcept {
+            using namespace swar_detail;
+
+            auto const word = load_eight(reinterpret_cast<char const*>(_kinds));
+            std::uint64_t marks = 0;
+
+            for (std::size_t i = 0; i < token_kind_set::max_kinds; ++i) marks |= bytes_equal_exact(word, _set.at(i));
+
+            return marked_bytes_mask(marks);
+        }
+#endif
+
+        inline constexpr unsigned full_block = (1u << block_size) - 1;
+
+        // Like block_matches, for the _count < block_size kinds left at the end
+        inline unsigned tail_matches(std::uint8_t const* _kinds, std::size_t _count, token_kind_set const& _set) noexcept {
+            unsigned matches = 0;
+
+            for (std::size_t i = 0; i < _count; ++i) {
+                if (_set.contains(_kinds[i])) matches |= 1u << i;
+            }
+
+            return matches;
+        }
+
+        // Calls _f(firstIndex, mask) for every block of _kinds, where bit i of mask is set if and only if kind firstIndex + i is in
+        // _set; the last block may be short
+        template<typename F>
+        void for_each_block(std::vector<std::uint8_t> const& _kinds, token_kind_set const& _set, F&& _f) {
+            auto const size = _kinds.size();
+            std::size_t position = 0;
+
+            for (; position + block_size <= size; position += block_size) _f(position, block_matches(_kinds.data() + position, _set));
+            if (position < size) _f(position, tail_matches(_kinds.data() + position, size - position, _set));
+        }
+    }    // namespace token_buffer_detail
+
+    // The offsets of a token's text in the source
+    struct token_span {
+        std::uint64_t offset;
+        std::uint64_t length;
+    };
+
+    // The tokens of one source stored column by column: a byte per token for its codec kind, its span in the source, and the
+    // index of its payload, if any, in a side table. Most tokens have none, so operations that only look at kinds (filtering,
+    // compaction and counting) compare a whole block of kinds at a time and never touch a token object.
+    // Codec is the same as token_cache's, except that payloads are kept as the tokens carrying them, so that nothing is converted
+    // when they are read back, and that a codec may provide has_payload(token_type const&) to avoid building payloads at all.
+    template<typename Codec>
+    class token_buffer {
+    public:
+        static constexpr std::uint32_t no_payload = 0xFFFFFFFF;
+
+        using codec_type = Codec;
+        using token_type = typename codec_type::token_type;
+        using size_type = std::size_t;
+        using kind_type = std::uint8_t;
+        using histogram_type = std::array<size_type, token_kind_set::max_kind + 1>;
+
+        explicit token_buffer(codec_type _codec = codec_type()) : m_codec(std::move(_codec)) {}
+
+        codec_type const& codec() const noexcept { return m_codec; }
+
+        size_type size() const noexcept { return m_kinds.size(); }
+        bool empty() const noexcept { return m_kinds.empty(); }
+
+        void reserve(size_type _count) {
+            m_kinds.reserve(_count);
+            m_spans.reserve(_count);
+            m_payloadIndices.reserve(_count);
+        }
+
+        // Throws std::out_of_range if the codec's kind for _token does not fit in a byte
+        void push_back(token_type _token, token_span _span) {
+            auto const kind = m_codec.kind(_token);
+            if (kind > token_kind_set::max_kind) {
+                throw std::out_of_range("A token_buffer can only hold kinds up to " + std::to_string(token_kind_set::max_kind));
+            }
+
+            m_kinds.push_back(static_cast<kind_type>(kind));
+            m_spans.push_back(_span);
+
+            if (carries_payload(_token)) {
+                m_payloadIndices.push_back(static_cast<std::uint32_t>(m_payloads.size()));
+                m_payloads.push_back(std::move(_token));
+            } else {
+                m_payloadIndices.push_back(no_payload);
+            }
+        }
+
+        kind_type kind(size_type _index) const noexcept { return m_kinds[_index]; }
+        kind_type const* kinds() const noexcept { return m_kinds.data(); }
+
+        token_span span(size_type _index) const noexcept { return m_spans[_index]; }
+
+        bool has_payload(size_type _index) const noexcept { return m_payloadIndices[_index] != no_payload; }
+
+        token_type token(size_type _index) const {
+            if (has_payload(_index)) return m_payloads[m_payloadIndices[_index]];
+            return m_codec.make(kind(_index), std::nullopt);
+        }
+
+        // Rebuilds every token
+        std::vector<token_type> decode() const {
+            std::vector<token_type> tokens;
+            tokens.reserve(size());
+
+            for (size_type i = 0; i < size(); ++i) tokens.push_back(token(i));
+
+            return tokens;
+        }
+
+        size_type count(token_kind_set const& _set) const noexcept {
+            size_type result = 0;
+            token_buffer_detail::for_each_block(m_kinds, _set, [&](size_type, unsigned _matches) { result += __builtin_popcount(_matches); });
+            return result;
+        }
+
+        // The number of tokens of every kind. Counts go to four tables in turn, so that runs of one kind do not wait on each
+        // other's increments.
+        histogram_type histogram() const noexcept {
+            histogram_type counts[4] = {};
+
+            size_type i = 0;
+
+            for (; i + 4 <= size(); i += 4) {
+                ++counts[0][m_kinds[i]];
+                ++counts[1][m_kinds[i + 1]];
+                ++counts[2][m_kinds[i + 2]];
+                ++counts[3][m_kinds[i + 3]];
+            }
+
+            for (; i < size(); ++i) ++counts[0][m_kinds[i]];
+
+            for (size_type kind = 0; kind < counts[0].size(); ++kind) counts[0][kind] += counts[1][kind] + counts[2][kind] + counts[3][kind];
+
+            return counts[0];
+        }
+
+        // Removes every token of a kind in _set in one pass, keeping the rest in order; returns the number removed
+        size_type erase(token_kind_set const& _set) {
+            auto const oldSize = size();
+
+            size_type kept = 0;
+            std::uint32_t payloadsKept = 0;
+
+            token_buffer_detail::for_each_block(m_kinds, _set, [&](size_type _first, unsigned _matches) {
+                auto const blockSize = std::min(token_buffer_detail::block_size, oldSize - _first);
+                auto keep = ~_matches & ((1u << blockSize) - 1);
+
+                // Until the first removal, every token is already where it belongs
+                if (kept == _first && keep == token_buffer_detail::full_block) {
+                    for (size_type i = _first; i < _first + blockSize; ++i) payloadsKept += has_payload(i);
+                    kept += blockSize;
+                    return;
+                }
+
+                for (; keep != 0; keep &= keep - 1) {
+                    auto const from = _first + static_cast<size_type>(__builtin_ctz(keep));
+
+                    m_kinds[kept] = m_kinds[from];
+                    m_spans[kept] = m_spans[from];
+                    m_payloadIndices[kept] = move_payload(from, payloadsKept);
+
+                    ++kept;
+                }
+            });
+
+            m_kinds.resize(kept);
+            m_spans.resize(kept);
+            m_payloadIndices.resize(kept);
+            m_payloads.erase(m_payloads.begin() + payloadsKept, m_payloads.end());
+
+            return oldSize - kept;
+        }
+
+        // A buffer of only the tokens of a kind in _set, in order
+        token_buffer select(token_kind_set const& _set) const {
+            token_buffer result(m_codec);
+            result.reserve(count(_set));
+
+            token_buffer_detail::for_each_block(m_kinds, _set, [&](size_type _first, unsigned _matches) {
+                for (; _matches != 0; _matches &= _matches - 1) {
+                    auto const from = _first + static_cast<size_type>(__builtin_ctz(_matches));
+
+                    result.m_kinds.push_back(m_kinds[from]);
+                    result.m_spans.push_back(m_spans[from]);
+
+                    if (has_payload(from)) {
+                        result.m_payloadIndices.push_back(static_cast<std::uint32_t>(result.m_payloads.size()));
+                        result.m_payloads.push_back(m_payloads[m_payloadIndices[from]]);
+                    } else {
+                        result.m_payloadIndices.push_back(no_payload);
+                    }
+                }
+            });
+
+            return result;
+        }
+
+    private:
+        template<typename Codec_, typename = void>
+        struct codec_has_payload : std::false_type {};
+
+        template<typename Codec_>
+        struct codec_has_payload<Codec_, std::void_t<decltype(std::declval<Codec_ const&>().has_payload(std::declval<token_type const&>()))>> :
+        std::true_type {};
+
+        bool carries_payload(token_type const& _token) const {
+            if constexpr (codec_has_payload<codec_type>::value) {
+                return m_codec.has_payload(_token);
+            } else {
+                return m_codec.payload(_token).has_value();
+            }
+        }
+
+        // Payloads are in token order, so kept ones only ever move towards the front of the side table
+        std::uint32_t move_payload(size_type _from, std::uint32_t& _payloadsKept) {
+            auto const index = m_payloadIndices[_from];
+            if (index == no_payload) return no_payload;
+
+            if (index != _payloadsKept) m_payloads[_payloadsKept] = std::move(m_payloads[index]);
+            return _payloadsKept++;
+        }
+
+        codec_type m_codec;
+
+        std::vector<kind_type> m_kinds;
+        std::vector<token_span> m_spans;
+        std::vector<std::uint32_t> m_payloadIndices;
+        std::vector<token_type> m_payloads;
+    };
+
+    // Like tokenize, but into a token_buffer, recording where each token is in the input
+    template<typename Codec, typename Tokenizer, typename CharSource>
+    parse_result<token_buffer<Codec>, typename tokenizer_traits<Tokenizer>::error_type> tokenize_to_buffer(Tokenizer const& _tokenizer,
+                                                                                                            CharSource const& _chars,
+                                                                                                            Codec _codec = Codec()) {
+        typename char_source_traits<CharSource>::access_wrapper accessWrapper(_chars);
+
+        token_buffer<Codec> tokens(std::move(_codec));
+
+        while (not accessWrapper.at_end()) {
+            auto tokenResult = accessWrapper.sub_parse([&](CharSource const& source) -> decltype(auto) {
+                return tokenizer_traits<Tokenizer>::parse_first_token(_tokenizer, source);
+            });
+
+            if (tokenResult) {
+                auto const offset = accessWrapper.chars_parsed();
+                auto const length = tokenResult.amount_parsed();
+
+                tokens.push_back(std::move(tokenResult).value(), token_span{offset, length});
+                accessWrapper.advance_head(length);
+            } else {
+                auto error = std::move(tokenResult).error();
+
+                // Relative to the start of the whole input rather than the failed token
+                if constexpr (std::is_same_v<decltype(error), farthest_failure>) error.position += accessWrapper.chars_parsed();
+
+                return error;
+            }
+        }
+
+        return {std::move(tokens), accessWrapper.chars_parsed()};
+    }
+}    // namespace randomcat::parser
@@ -0,0 +1,416 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/chars/tokenizer.hpp"
+#include "randomcat/parser/detail/hash.hpp"
+#include "randomcat/parser/detail/mapped_file.hpp"
+#include "randomcat/parser/detail/util.hpp"
+#include "randomcat/parser/parse_result.hpp"
+
+// A token cache file is a header followed by 8-byte aligned sections, all in native byte order:
+//   kinds            token_count x uint32    the codec's kind of every token
+//   begins           token_count+1 x uint64  the offset of every token in the source, followed by the end of the last one
+//   payload_indices  token_count x uint32    index into the payload table, or no_payload
+//   payload_offsets  payload_count+1 x uint64
+//   payload_bytes    payload_bytes x char    every distinct payload, stored once
+// so that a mapped file can be read in place.
+
+namespace randomcat::parser {
+    namespace token_cache_detail {
+        inline constexpr char magic[8] = {'R', 'C', 'T', 'O', 'K', 'C', '0', '1'};
+        inline constexpr std::uint32_t format_version = 1;
+        inline constexpr std::uint32_t byte_order_mark = 0x01020304;
+        inline constexpr std::uint32_t no_payload = 0xFFFFFFFF;
+
+        struct header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+
+            std::uint64_t fingerprint;
+            std::uint64_t content_hash;
+            std::uint64_t content_size;
+            std::uint64_t amount_parsed;
+
+            std::uint64_t token_count;
+            std::uint64_t payload_count;
+            std::uint64_t payload_bytes;
+
+            std::uint64_t kinds_offset;
+            std::uint64_t begins_offset;
+            std::uint64_t payload_indices_offset;
+            std::uint64_t payload_offsets_offset;
+            std::uint64_t payload_bytes_offset;
+            std::uint64_t file_size;
+        };
+
+        static_assert(std::is_trivially_copyable_v<header>);
+        static_assert(sizeof(header) % 8 == 0);
+
+        constexpr inline std::uint64_t align(std::uint64_t _offset) noexcept { return (_offset + 7) & ~std::uint64_t(7); }
+
+        // Fills in the section offsets and the file size from the counts
+        constexpr inline void lay_out(header& _header) noexcept {
+            _header.kinds_offset = sizeof(header);
+            _header.begins_offset = align(_header.kinds_offset + _header.token_count * sizeof(std::uint32_t));
+            _header.payload_indices_offset = align(_header.begins_offset + (_header.token_count + 1) * sizeof(std::uint64_t));
+            _header.payload_offsets_offset = align(_header.payload_indices_offset + _header.token_count * sizeof(std::uint32_t));
+            _header.payload_bytes_offset = align(_header.payload_offsets_offset + (_header.payload_count + 1) * sizeof(std::uint64_t));
+            _header.file_size = align(_header.payload_bytes_offset + _header.payload_bytes);
+        }
+
+        // Whether offsets[0] through offsets[_count] run from 0 up to _end without ever decreasing
+        inline bool offsets_are_valid(std::uint64_t const* _offsets, std::uint64_t _count, std::uint64_t _end) noexcept {
+            if (_offsets[0] != 0 || _offsets[_count] != _end) return false;
+
+            for (std::uint64_t i = 0; i < _count; ++i) {
+                if (_offsets[i] > _offsets[i + 1]) return false;
+            }
+
+            return true;
+        }
+
+        // Checks the contents of the sections that cached_tokens indexes with, so that a corrupt file cannot make it read out of bounds
+        inline bool sections_are_valid(header const& _header, std::byte const* _data) noexcept {
+            auto const begins = reinterpret_cast<std::uint64_t const*>(_data + _header.begins_offset);
+            if (_header.amount_parsed > _header.content_size || not offsets_are_valid(begins, _header.token_count, _header.amount_parsed)) return false;
+
+            auto const payloadOffsets = reinterpret_cast<std::uint64_t const*>(_data + _header.payload_offsets_offset);
+            if (not offsets_are_valid(payloadOffsets, _header.payload_count, _header.payload_bytes)) return false;
+
+            auto const payloadIndices = reinterpret_cast<std::uint32_t const*>(_data + _header.payload_indices_offset);
+
+            for (std::uint64_t i = 0; i < _header.token_count; ++i) {
+                if (payloadIndices[i] != no_payload && payloadIndices[i] >= _header.payload_count) return false;
+            }
+
+            return true;
+        }
+
+        inline bool is_valid(header const& _header,
+                             std::byte const* _data,
+                             std::size_t _fileSize,
+                             std::uint64_t _fingerprint,
+                             std::uint64_t _contentHash,
+                             std::uint64_t _contentSize) noexcept {
+            if (std::memcmp(_header.magic, magic, sizeof(magic)) != 0) return false;
+            if (_header.version != format_version || _header.byte_order != byte_order_mark) return false;
+            if (_header.fingerprint != _fingerprint || _header.content_hash != _contentHash || _header.content_size != _contentSize) return false;
+
+            // Bounds every count, so that the layout below cannot overflow
+            if (_header.token_count > _fileSize || _header.payload_count > _fileSize || _header.payload_bytes > _fileSize) return false;
+
+            auto expected = _header;
+            lay_out(expected);
+
+            if (std::memcmp(&expected, &_header, sizeof(header)) != 0 || _header.file_size != _fileSize) return false;
+
+            return sections_are_valid(_header, _data);
+        }
+
+        inline std::string hex(std::uint64_t _value) {
+            char buffer[17];
+            std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(_value));
+            return buffer;
+        }
+
+        // Feeds fingerprint() calls into a running hash, encoding tokens through a codec
+        template<typename Codec>
+        class fingerprint_hasher {
+        public:
+            explicit fingerprint_hasher(Codec const& _codec, std::uint64_t _seed) noexcept : m_codec(_codec), m_hash(_seed) {}
+
+            template<typename T>
+            void operator()(T const& _value) {
+                if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+                    m_hash = hash_detail::combine(m_hash, static_cast<std::uint64_t>(_value));
+                } else if constexpr (std::is_same_v<T, typename Codec::token_type>) {
+                    m_hash = hash_detail::combine(m_hash, m_codec.kind(_value));
+
+                    auto const payload = m_codec.payload(_value);
+                    m_hash = hash_detail::combine(m_hash, payload.has_value());
+                    if (payload) (*this)(std::string_view(*payload));
+                } else if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+                    m_hash = hash_detail::hash_string(_value, m_hash);
+                } else {
+                    static_assert(util_detail::invalid_v<T>, "Unable to fingerprint this type");
+                }
+            }
+
+            std::uint64_t value() const noexcept { return m_hash; }
+
+        private:
+            Codec const& m_codec;
+            std::uint64_t m_hash;
+        };
+    }    // namespace token_cache_detail
+
+    // The tokens of one source, either read in place from a cache file or built in memory
+    class cached_tokens {
+    public:
+        static constexpr std::uint32_t no_payload = token_cache_detail::no_payload;
+
+        using size_type = std::size_t;
+
+        explicit cached_tokens(file_detail::mapped_file _file) noexcept
+        : m_file(std::move(_file)), m_base(m_file.data()), m_wasCached(true) {}
+
+        explicit cached_tokens(std::unique_ptr<std::uint64_t[]> _image) noexcept
+        : m_image(std::move(_image)), m_base(reinterpret_cast<std::byte const*>(m_image.get())), m_wasCached(false) {}
+
+        // Whether the tokens were loaded from an existing cache file instead of being tokenized
+        bool was_cached() const noexcept { return m_wasCached; }
+
+        size_type size() const noexcept { return header().token_count; }
+
+        std::uint32_t kind(size_type _index) const noexcept { return section<std::uint32_t>(header().kinds_offset)[_index]; }
+
+        // The offsets of a token's text in the source
+        std::uint64_t begin_offset(size_type _index) const noexcept { return section<std::uint64_t>(header().begins_offset)[_index]; }
+        std::uint64_t end_offset(size_type _index) const noexcept { return section<std::uint64_t>(header().begins_offset)[_index + 1]; }
+
+        bool has_payload(size_type _index) const noexcept { return payload_index(_index) != no_payload; }
+
+        std::string_view payload(size_type _index) const noexcept {
+            auto const payloadIndex = payload_index(_index);
+            if (payloadIndex == no_payload) return {};
+
+            auto const offsets = section<std::uint64_t>(header().payload_offsets_offset);
+            auto const bytes = reinterpret_cast<char const*>(m_base + header().payload_bytes_offset);
+            return std::string_view(bytes + offsets[payloadIndex], offsets[payloadIndex + 1] - offsets[payloadIndex]);
+        }
+
+        size_type amount_parsed() const noexcept { return header().amount_parsed; }
+
+        // Rebuilds the tokens that were cached
+        template<typename Codec>
+        std::vector<typename Codec::token_type> decode(Codec const& _codec) const {
+            std::vector<typename Codec::token_type> tokens;
+            tokens.reserve(size());
+
+            for (size_type i = 0; i < size(); ++i) {
+                tokens.push_back(has_payload(i) ? _codec.make(kind(i), std::optional<std::string_view>(payload(i)))
+                                                : _codec.make(kind(i), std::optional<std::string_view>()));
+            }
+
+            return tokens;
+        }
+
+    private:
+        token_cache_detail::header const& header() const noexcept { return *reinterpret_cast<token_cache_detail::header const*>(m_base); }
+
+        std::uint32_t payload_index(size_type _index) const noexcept {
+            return section<std::uint32_t>(header().payload_indices_offset)[_index];
+        }
+
+        template<typename T>
+        T const* section(std::uint64_t _offset) const noexcept {
+            return reinterpret_cast<T const*>(m_base + _offset);
+        }
+
+        file_detail::mapped_file m_file;
+        std::unique_ptr<std::uint64_t[]> m_image;
+        std::byte const* m_base;
+        bool m_wasCached;
+    };
+
+    // Caches tokenized sources in _directory, keyed by a hash of their contents and a fingerprint of the tokenizer.
+    // Codec maps tokens to and from a kind and an optional payload:
+    //     using token_type = ...;
+    //     std::uint32_t kind(token_type const&) const;
+    //     std::optional<std::string> payload(token_type const&) const;
+    //     token_type make(std::uint32_t kind, std::optional<std::string_view> payload) const;
+    // The fingerprint covers the tokenizer's type and every descriptor that provides fingerprint(hasher), so cache files
+    // are ignored as soon as the descriptor set changes. Descriptors without it only contribute their type; bump _salt
+    // when their behaviour changes.
+    template<typename Codec>
+    class token_cache {
+    public:
+        using codec_type = Codec;
+
+        explicit token_cache(std::filesystem::path _directory, codec_type _codec = codec_type(), std::uint64_t _salt = 0)
+        : m_directory(std::move(_directory)), m_codec(std::move(_codec)), m_salt(_salt) {}
+
+        codec_type const& codec() const noexcept { return m_codec; }
+
+        std::filesystem::path const& directory() const noexcept { return m_directory; }
+
+        template<typename Tokenizer>
+        std::uint64_t fingerprint(Tokenizer const& _tokenizer) const {
+            token_cache_detail::fingerprint_hasher<codec_type> hasher(m_codec, hash_detail::combine(m_salt, token_cache_detail::format_version));
+            hasher(std::string_view(typeid(Tokenizer).name()));
+            hasher(std::string_view(typeid(codec_type).name()));
+            tokenizer_traits<Tokenizer>::fingerprint(_tokenizer, hasher);
+
+            return hasher.value();
+        }
+
+        std::filesystem::path path_for(std::uint64_t _contentHash, std::uint64_t _fingerprint) const {
+            return m_directory / (token_cache_detail::hex(_contentHash) + "-" + token_cache_detail::hex(_fingerprint) + ".rctok");
+        }
+
+        // Maps the cache file for _contents if there is a valid one. Otherwise, tokenizes _contents and writes a cache file,
+        // returning the tokens from memory if that fails. Tokenizer errors are never cached.
+        template<typename Tokenizer>
+        parse_result<cached_tokens, typename tokenizer_traits<Tokenizer>::error_type> tokenize(Tokenizer const& _tokenizer,
+                                                                                              std::string_view _contents) const {
+            auto const fingerprintValue = fingerprint(_tokenizer);
+            auto const contentHash = hash_detail::hash_string(_contents);
+            auto const path = path_for(contentHash, fingerprintValue);
+
+            if (auto file = file_detail::mapped_file::open(path.string())) {
+                if (file.size() >= sizeof(token_cache_detail::header)) {
+                    token_cache_detail::header header;
+                    std::memcpy(&header, file.data(), sizeof(header));
+
+                    if (token_cache_detail::is_valid(header, file.data(), file.size(), fingerprintValue, contentHash, _contents.size())) {
+                        auto const amountParsed = header.amount_parsed;
+                        return {cached_tokens(std::move(file)), amountParsed};
+                    }
+                }
+            }
+
+            auto tokensResult = tokenize_to_image(_tokenizer, _contents, fingerprintValue, contentHash);
+            if (tokensResult.is_error()) return std::move(tokensResult).error();
+
+            auto const amountParsed = tokensResult.amount_parsed();
+            auto image = std::move(tokensResult).value();
+
+            write_atomically(path, image);
+            return {cached_tokens(std::move(image.data)), amountParsed};
+        }
+
+    private:
+        struct image {
+            std::unique_ptr<std::uint64_t[]> data;
+            std::size_t size;
+        };
+
+        template<typename Tokenizer>
+        parse_result<image, typename tokenizer_traits<Tokenizer>::error_type> tokenize_to_image(Tokenizer const& _tokenizer,
+                                                                                               std::string_view _contents,
+                                                                                               std::uint64_t _fingerprint,
+                                                                                               std::uint64_t _contentHash) const {
+            std::vector<std::uint32_t> kinds;
+            std::vector<std::uint64_t> begins;
+            std::vector<std::uint32_t> payloadIndices;
+
+            std::unordered_map<std::string, std::uint32_t> payloadTable;
+            std::vector<std::uint64_t> payloadOffsets{0};
+            std::string payloadBytes;
+
+            auto source = string_view_char_source(_contents);
+
+            while (not source.at_end()) {
+                auto tokenResult = tokenizer_traits<Tokenizer>::parse_first_token(_tokenizer, source);
+                if (tokenResult.is_error()) return std::move(tokenResult).error();
+
+                auto const& token = tokenResult.value();
+                kinds.push_back(m_codec.kind(token));
+                begins.push_back(source.head());
+
+                if (auto payload = m_codec.payload(token)) {
+                    auto const [it, inserted] = payloadTable.emplace(std::move(*payload), static_cast<std::uint32_t>(payloadTable.size()));
+
+                    if (inserted) {
+                        payloadBytes += it->first;
+                        payloadOffsets.push_back(payloadBytes.size());
+                    }
+
+                    payloadIndices.push_back(it->second);
+                } else {
+                    payloadIndices.push_back(cached_tokens::no_payload);
+                }
+
+                source.advance_head(tokenResult.amount_parsed());
+            }
+
+            begins.push_back(source.head());
+
+            token_cache_detail::header header{};
+            std::memcpy(header.magic, token_cache_detail::magic, sizeof(header.magic));
+            header.version = token_cache_detail::format_version;
+            header.byte_order = token_cache_detail::byte_order_mark;
+            header.fingerprint = _fingerprint;
+            header.content_hash = _contentHash;
+            header.content_size = _contents.size();
+            header.amount_parsed = source.head();
+            header.token_count = kinds.size();
+            header.payload_count = payloadTable.size();
+            header.payload_bytes = payloadBytes.size();
+            token_cache_detail::lay_out(header);
+
+            // Zero-initialized, so that padding is written deterministically
+            auto data = std::make_unique<std::uint64_t[]>(header.file_size / sizeof(std::uint64_t));
+            auto const base = reinterpret_cast<char*>(data.get());
+
+            auto const copy_section = [&](std::uint64_t _offset, auto const& _values) {
+                if (not _values.empty()) std::memcpy(base + _offset, _values.data(), _values.size() * sizeof(_values[0]));
+            };
+
+            std::memcpy(base, &header, sizeof(header));
+            copy_section(header.kinds_offset, kinds);
+            copy_section(header.begins_offset, begins);
+            copy_section(header.payload_indices_offset, payloadIndices);
+            copy_section(header.payload_offsets_offset, payloadOffsets);
+            copy_section(header.payload_bytes_offset, payloadBytes);
+
+            return {image{std::move(data), static_cast<std::size_t>(header.file_size)}, static_cast<std::size_t>(header.amount_parsed)};
+        }
+
+        // Readers never see a partially written file, since it only appears under its final name once complete.
+        // Failing to write is not an error; the source is simply tokenized again next time.
+        void write_atomically(std::filesystem::path const& _path, image const& _image) const noexcept {
+            static std::atomic<std::uint64_t> nextTemporary{0};
+
+            try {
+                std::error_code ec;
+                std::filesystem::create_directories(m_directory, ec);
+                if (ec) return;
+
+                auto temporaryPath = _path;
+                temporaryPath += "." + std::to_string(::getpid()) + "." + std::to_string(nextTemporary++) + ".tmp";
+
+                {
+                    std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+                    if (not stream) return;
+
+                    stream.write(reinterpret_cast<char const*>(_image.data.get()), static_cast<std::streamsize>(_image.size));
+                    stream.close();
+
+                    if (not stream) {
+                        std::filesystem::remove(temporaryPath, ec);
+                        return;
+                    }
+                }
+
+                std::filesystem::rename(temporaryPath, _path, ec);
+                if (ec) std::filesystem::remove(temporaryPath, ec);
+            } catch (...) {}
+        }
+
+        std::filesystem::path m_directory;
+        codec_type m_codec;
+        std::uint64_t m_salt;
+    };
+}    // namespace randomcat::parser
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "randomcat/parser/detail/spsc_ring.hpp"
+#include "randomcat/parser/tokens/token_stream/token_stream.hpp"
+
+namespace randomcat::parser {
+    namespace pipeline_detail {
+        template<typename FromSource>
+        class state {
+        public:
+            using from_traits = token_stream_traits<FromSource>;
+            using token_type = typename from_traits::token_type;
+            using size_type = default_size_type;
+            using try_result_type = typename from_traits::try_result_type;
+
+            state(state const&) = delete;
+            state(state&&) = delete;
+            state& operator=(state const&) = delete;
+            state& operator=(state&&) = delete;
+
+            explicit state(FromSource _fromSource, size_type _batchSize, size_type _batchCount, size_type _retainedCount)
+            : m_fromSource(std::move(_fromSource)), m_batchSize(_batchSize), m_ring(_batchCount), m_retainedCount(_retainedCount) {
+                if (m_batchSize == 0) throw std::invalid_argument("pipeline_token_stream batch size must be positive");
+
+                m_producer = std::thread([this] { produce(); });
+            }
+
+            ~state() noexcept {
+                m_stop.store(true, std::memory_order_relaxed);
+                m_ring.wake_producer();
+
+                if (m_producer.joinable()) m_producer.join();
+            }
+
+            // Pulls batches until the token at _head has been received or the stream has ended; returns whether it was received.
+            // Anything other than a missing token that FromSource threw is rethrown in place of the token it failed to read.
+            bool ensure_received(size_type _head) {
+                if (_head < window_end()) return true;
+
+                discard_unretained(_head);
+                while (_head >= window_end() && not m_receivedLast) pull_batch();
+
+                if (_head < window_end()) return true;
+                if (m_exception) std::rethrow_exception(m_exception);
+                return false;
+            }
+
+            token_type const& token(size_type _index) const noexcept { return m_tokens[_index - m_windowBegin]; }
+
+            size_type window_begin() const noexcept { return m_windowBegin; }
+            size_type window_end() const noexcept { return m_windowBegin + m_tokens.size(); }
+
+            // The failure that ended the stream, if any, once every token before it has been received
+            std::optional<try_result_type> const& error() const noexcept { return m_error; }
+
+        private:
+            struct batch {
+                std::vector<token_type> tokens;
+                std::optional<try_result_type> error;
+                std::exception_ptr exception;
+                bool last = false;
+            };
+
+            void produce() {
+                batch next;
+                next.tokens.reserve(m_batchSize);
+
+                try {
+                    while (not m_stop.load(std::memory_order_relaxed) && not from_traits::at_end(m_fromSource)) {
+                        auto result = from_traits::try_read(m_fromSource);
+
+                        if (result.is_error()) {
+                            next.error = std::move(result);
+                            break;
+                        }
+
+                        next.tokens.push_back(std::move(result).value());
+
+                        if (next.tokens.size() == m_batchSize) {
+                            if (not m_ring.push(std::move(next), m_stop)) return;
+
+                            next = batch();
+                            next.tokens.reserve(m_batchSize);
+                        }
+                    }
+                } catch (token_stream_no_token<typename from_traits::error_type> const& _exception) {
+                    // Streams without try_read report failures by throwing from read
+                    next.error = token_stream_detail::no_token_result<token_type>(_exception);
+                } catch (...) {
+                    next.exception = std::current_exception();
+                }
+
+                next.last = true;
+                m_ring.push(std::move(next), m_stop);
+            }
+
+            void pull_batch() {
+                auto received = m_ring.pop();
+
+                if (m_tokens.empty()) {
+                    m_tokens = std::move(received.tokens);
+                } else {
+                    m_tokens.insert(m_tokens.end(), std::make_move_iterator(received.tokens.begin()), std::make_move_iterator(received.tokens.end()));
+                }
+
+                m_error = std::move(received.error);
+                m_exception = std::move(received.exception);
+                m_receivedLast = received.last;
+            }
+
+            void discard_unretained(size_type _head) {
+                // Only discard once twice the retained count has built up, so that the erase is amortized
+                auto const behindHead = _head - m_windowBegin;
+                if (behindHead <= 2 * m_retainedCount) return;
+
+                auto const toDiscard = behindHead - m_retainedCount;
+                m_tokens.erase(m_tokens.begin(), m_tokens.begin() + toDiscard);
+                m_windowBegin += toDiscard;
+            }
+
+            // Producer side
+            FromSource m_fromSource;
+            size_type m_batchSize;
+            std::atomic<bool> m_stop = false;
+
+            spsc_detail::spsc_ring<batch> m_ring;
+
+            // Consumer side
+            size_type m_retainedCount;
+            std::vector<token_type> m_tokens;
+            size_type m_windowBegin = 0;
+            std::optional<try_result_type> m_error;
+            std::exception_ptr m_exception;
+            bool m_receivedLast = false;
+
+            std::thread m_producer;
+        };
+    }    // namespace pipeline_detail
+
+    // Reads FromSource to its end on a background thread, in batches of tokens that are handed over through a lock-free ring at
+    // most _batchCount batches ahead of the reader. Every stage wrapped in one runs on its own thread, so, for example,
+    //     pipeline_token_stream(strip_whitespace_token_stream(pipeline_token_stream(char_source_token_stream(...))))
+    // lexes on one thread, strips whitespace on another, and leaves only the grammar on the calling thread.
+    // At least _retainedCount tokens before the head are kept, and set_head may move anywhere inside that window, like
+    // readahead_char_source's retained chars; a grammar that backtracks further than that gets std::out_of_range. A failure to
+    // fetch a token from FromSource is reported after the tokens before it, as by transform_token_stream.
+    template<typename FromSource>
+    class pipeline_token_stream {
+    private:
+        using state_type = pipeline_detail::state<FromSource>;
+
+    public:
+        using token_type = typename token_stream_traits<FromSource>::token_type;
+        using size_type = default_size_type;
+        using location_type = size_type;
+        using error_type = typename token_stream_traits<FromSource>::error_type;
+        using try_result_type = parse_result<token_type, error_type>;
+        using error_policy = typename token_stream_traits<FromSource>::error_policy;
+
+        static_assert(util_detail::is_simple_type_v<FromSource>);
+
+        static inline constexpr size_type default_batch_size = 1024;
+        static inline constexpr size_type default_batch_count = 8;
+        static inline constexpr size_type default_retained_count = 64 * 1024;
+
+        explicit pipeline_token_stream(FromSource _fromSource,
+                                       size_type _batchSize = default_batch_size,
+                                       size_type _batchCount = default_batch_count,
+                                       size_type _retainedCount = default_retained_count)
+        : m_state(std::make_unique<state_type>(std::move(_fromSource), _batchSize, _batchCount, _retainedCount)) {}
+
+        token_type read() { return token_stream_detail::value_or_throw(try_read()); }
+
+        token_type peek() const { return token_stream_detail::value_or_throw(try_peek()); }
+
+        try_result_type try_read() {
+            auto result = try_peek();
+            if (result.is_value()) ++m_head;
+            return result;
+        }
+
+        try_result_type try_peek() const {
+            if (m_state->ensure_received(m_head)) return {m_state->token(m_head), 1};
+            if (m_state->error()) return *m_state->error();
+
+            // At the end
+            return try_result_type();
+        }
+
+        bool at_end() const { return not m_state->ensure_received(m_head) && not m_state->error(); }
+
+        location_type head() const noexcept { return m_head; }
+
+        // _head must have been the head before
+        void set_head(location_type _head) {
+            if (_head < m_state->window_begin() || _head > m_state->window_end())
+                throw std::out_of_range("pipeline_token_stream head moved outside of the retained window");
+
+            m_head = _head;
+        }
+
+    private:
+        std::unique_ptr<state_type> m_state;
+        size_type m_head = 0;
+    };
+}    // namespace randomcat::parser
@@ -1,10 +1,18 @@
 #pragma once
 
 #include "randomcat/parser/chars/char_source.hpp"
+#include "randomcat/parser/chars/tokenizer.hpp"
 #include "randomcat/parser/detail/util.hpp"
+#include "randomcat/parser/diagnostics/stats.hpp"
+#include "randomcat/parser/error_policy.hpp"
+#include "randomcat/parser/parse_result.hpp"
 #include "randomcat/parser/tokens/detail/token_traits.hpp"
 //#include "randomcat/parser/chars/"
 
+#ifdef RANDOMCAT_PARSER_TRACING
+#    include "randomcat/parser/diagnostics/trace.hpp"
+#endif
+
 namespace randomcat::parser {
     template<typename TokenStream>
     class token_stream_traits {
@@ -16,10 +24,37 @@ namespace randomcat::parser {
         using location_type = token_traits_detail::location_type_t<TokenStream>;
         using size_type = token_traits_detail::size_type_t<TokenStream>;
 
+        // void if the stream does not say how fetching a token can fail
+        using error_type = token_traits_detail::error_type_t<TokenStream>;
+
+        // The result of try_read and try_peek; a value has an amount_parsed of 1 (token)
+        using try_result_type = parse_result<token_type, error_type>;
+
+        // The error policy grammars tested on the stream use, see error_policy.hpp
+        using error_policy = error_policy_detail::error_policy_t<TokenStream>;
+
         static token_type read(TokenStream& _stream) noexcept(noexcept(_stream.read())) { return _stream.read(); }
 
         static token_type peek(TokenStream const& _stream) noexcept(noexcept(_stream.peek())) { return _stream.peek(); }
 
+        // Like read and peek, but report a token that cannot be fetched as an error instead of throwing token_stream_no_token.
+        // Streams without try_read and try_peek are read with read and peek, so they still throw.
+        static try_result_type try_read(TokenStream& _stream) {
+            if constexpr (token_traits_detail::has_try_read<TokenStream>::value) {
+                return _stream.try_read();
+            } else {
+                return {read(_stream), 1};
+            }
+        }
+
+        static try_result_type try_peek(TokenStream const& _stream) {
+            if constexpr (token_traits_detail::has_try_peek<TokenStream>::value) {
+                return _stream.try_peek();
+            } else {
+                return {peek(_stream), 1};
+            }
+        }
+
         static location_type head(TokenStream const& _stream) noexcept(noexcept(_stream.head())) { return _stream.head(); }
 
         static void set_head(TokenStream& _stream, location_type _head) noexcept(noexcept(_stream.set_head(std::move(_head)))) {
@@ -47,6 +82,8 @@ namespace randomcat::parser {
 
             token_type peek() const { return token_stream_traits::peek(source()); }
 
+            try_result_type try_peek() const { return token_stream_traits::try_peek(source()); }
+
             token_type read() {
                 ++m_amountParsed;
                 return token_stream_traits::read(source());
@@ -94,7 +131,35 @@ namespace randomcat::parser {
         virtual char const* what() const noexcept override { return token_stream_no_token_message.c_str(); }
     };
 
-    template<typename CharSource, typename Tokenizer>
+    namespace token_stream_detail {
+        template<typename Token, typename Error>
+        [[noreturn]] void throw_no_token(parse_result<Token, Error> _result) {
+            if constexpr (std::is_void_v<Error>) {
+                throw token_stream_no_token<void>();
+            } else {
+                throw token_stream_no_token<Error>(std::move(_result).error());
+            }
+        }
+
+        // For implementing read and peek on top of try_read and try_peek
+        template<typename Token, typename Error>
+        Token value_or_throw(parse_result<Token, Error> _result) {
+            if (_result.is_error()) throw_no_token(std::move(_result));
+            return std::move(_result).value();
+        }
+
+        template<typename Token, typename Error>
+        parse_result<Token, Error> no_token_result(token_stream_no_token<Error> const& _exception) {
+            if constexpr (std::is_void_v<Error>) {
+                return {};
+            } else {
+                return _exception.error();
+            }
+        }
+    }    // namespace token_stream_detail
+
+    // Stats is a stats policy (see diagnostics/stats.hpp) told about every lex, and whether it lexes a position that was already lexed
+    template<typename CharSource, typename Tokenizer, typename Stats = no_stats>
     class char_source_token_stream {
     public:
         static_assert(util_detail::is_simple_type_v<CharSource>);
@@ -103,47 +168,86 @@ namespace randomcat::parser {
         explicit char_source_token_stream(CharSource _charSource, Tokenizer _tokenizer)
         : m_charSource(std::move(_charSource)), m_tokenizer(std::move(_tokenizer)) {}
 
+        explicit char_source_token_stream(CharSource _charSource, Tokenizer _tokenizer, Stats _stats)
+        : m_charSource(std::move(_charSource)), m_tokenizer(std::move(_tokenizer)), m_stats(std::move(_stats)) {}
+
         using token_type = typename tokenizer_traits<Tokenizer>::token_type;
         using location_type = typename char_source_traits<CharSource>::location_type;
+        using error_type = typename tokenizer_traits<Tokenizer>::error_type;
+        using try_result_type = parse_result<token_type, error_type>;
+        using error_policy = typename tokenizer_traits<Tokenizer>::error_policy;
+
+        token_type read() { return token_stream_detail::value_or_throw(try_read()); }
+
+        token_type peek() const { return token_stream_detail::value_or_throw(try_peek()); }
+
+        try_result_type try_read() {
+#ifdef RANDOMCAT_PARSER_TRACING
+            trace_span span(trace_category::lex, "read");
+#endif
 
-        token_type read() {
             auto parseResult = do_parse();
-            throw_if_empty(parseResult);
+            if (parseResult.is_error()) return std::move(parseResult).error();
 
             char_source_traits<CharSource>::advance_head(m_charSource, parseResult.amount_parsed());
-            return std::move(parseResult).value();
+            return {std::move(parseResult).value(), 1};
         }
 
-        token_type peek() const {
+        try_result_type try_peek() const {
             auto parseResult = do_parse();
-            throw_if_empty(parseResult);
+            if (parseResult.is_error()) return std::move(parseResult).error();
 
-            return std::move(parseResult).value();
+            return {std::move(parseResult).value(), 1};
         }
 
-        bool at_end() const noexcept { return char_source_traits<CharSource>::at_end(m_charSource); }
+        bool at_end() const noexcept(noexcept(char_source_traits<CharSource>::at_end(std::declval<CharSource const&>()))) {
+            return char_source_traits<CharSource>::at_end(m_charSource);
+        }
 
-        location_type head() const noexcept { return char_source_traits<CharSource>::head(m_charSource); }
+        location_type head() const noexcept(noexcept(char_source_traits<CharSource>::head(std::declval<CharSource const&>()))) {
+            return char_source_traits<CharSource>::head(m_charSource);
+        }
 
-        void set_head(location_type _head) noexcept { char_source_traits<CharSource>::set_head(m_charSource, std::move(_head)); }
+        void set_head(location_type _head) noexcept(noexcept(char_source_traits<CharSource>::set_head(std::declval<CharSource&>(), std::move(_head)))) {
+            char_source_traits<CharSource>::set_head(m_charSource, std::move(_head));
+        }
 
     private:
-        using tokenizer_error_type = typename tokenizer_traits<Tokenizer>::error_type;
         using tokenizer_parse_result_type = typename tokenizer_traits<Tokenizer>::parse_result_type;
 
         tokenizer_parse_result_type do_parse() const noexcept {
+            if constexpr (Stats::enabled) record_lex();
             return tokenizer_traits<Tokenizer>::parse_first_token(m_tokenizer, m_charSource);
         }
 
-        static void throw_if_empty(tokenizer_parse_result_type const& _result) {
-            if (_result.is_error()) throw token_stream_no_token<tokenizer_error_type>(_result.error());
+        // A lex is a relex if it is not past the furthest position lexed so far (e.g. read() after peek(), or lexing again after a rewind)
+        void record_lex() const noexcept {
+            auto currentHead = head();
+
+            bool relex = false;
+            if (m_furthestLexHead) {
+                auto const distance = stats_detail::location_distance(*m_furthestLexHead, currentHead);
+                relex = distance ? *distance <= 0 : *m_furthestLexHead == currentHead;
+                if (not relex) m_furthestLexHead = std::move(currentHead);
+            } else {
+                m_furthestLexHead = std::move(currentHead);
+            }
+
+            m_stats.token_lexed(relex);
         }
 
         CharSource m_charSource;
         Tokenizer m_tokenizer;
+        Stats m_stats;
+
+        // Only tracked if stats are enabled
+        mutable std::optional<location_type> m_furthestLexHead;
     };
 
-    template<typename FromSource, typename Transform>
+    // Stats is a stats policy (see diagnostics/stats.hpp) told about every run of the transform, and whether set_head caused it.
+    // If FromSource fails to fetch a token while the transform runs, the tokens emitted before that can still be read, after which
+    // try_read and try_peek report the failure (and read and peek throw it) until set_head.
+    template<typename FromSource, typename Transform, typename Stats = no_stats>
     class transform_token_stream {
     private:
         using derived_location_type = typename token_stream_traits<FromSource>::location_type;
@@ -151,6 +255,9 @@ namespace randomcat::parser {
     public:
         using token_type = typename token_stream_traits<FromSource>::token_type;
         using size_type = default_size_type;
+        using error_type = typename token_stream_traits<FromSource>::error_type;
+        using try_result_type = parse_result<token_type, error_type>;
+        using error_policy = typename token_stream_traits<FromSource>::error_policy;
 
         static_assert(util_detail::is_simple_type_v<FromSource>);
         static_assert(std::is_same_v<typename token_stream_traits<FromSource>::size_type, size_type>);
@@ -160,6 +267,14 @@ namespace randomcat::parser {
             fetch_tokens_if_needed();
         }
 
+        explicit transform_token_stream(FromSource _fromSource, Transform _transform, Stats _stats)
+        : m_transform(std::move(_transform)),
+          m_fromSource(std::move(_fromSource)),
+          m_location{token_stream_traits<FromSource>::head(_fromSource), 0},
+          m_stats(std::move(_stats)) {
+            fetch_tokens_if_needed();
+        }
+
         struct location_type {
             derived_location_type fromSourceLocation;
             size_type subTokenIndex;
@@ -171,21 +286,33 @@ namespace randomcat::parser {
             m_location = std::move(_location);
             token_stream_traits<FromSource>::set_head(m_fromSource, m_location.fromSourceLocation);
             m_pendingTokens.clear();
+            m_fetchError.reset();
 
             // We assume that going back to a previous head will yield the same token sequence.
             // Thus, for any pending token index that we get, it must have been valid before.
-            fetch_tokens_once();
+            fetch_tokens_once(true);
         }
 
-        token_type peek() const { return m_pendingTokens[m_location.subTokenIndex]; }
+        token_type peek() const { return token_stream_detail::value_or_throw(try_peek()); }
+
+        token_type read() { return token_stream_detail::value_or_throw(try_read()); }
+
+        try_result_type try_peek() const {
+            if (m_location.subTokenIndex < size(m_pendingTokens)) return {m_pendingTokens[m_location.subTokenIndex], 1};
+            if (m_fetchError) return *m_fetchError;
+
+            // At the end
+            return try_result_type();
+        }
 
-        token_type read() {
-            token_type token = peek();
+        try_result_type try_read() {
+            auto result = try_peek();
+            if (result.is_error()) return result;
 
             ++(m_location.subTokenIndex);
             fetch_tokens_if_needed();
 
-            return token;
+            return result;
         }
 
         bool at_end() const noexcept {
@@ -193,12 +320,25 @@ namespace randomcat::parser {
         }
 
     private:
-        void fetch_tokens_once() {
-            if (not token_stream_traits<FromSource>::at_end(m_fromSource))
+        void fetch_tokens_once(bool _rerun) {
+            if (token_stream_traits<FromSource>::at_end(m_fromSource)) return;
+
+            m_stats.transform_ran(_rerun);
+
+#ifdef RANDOMCAT_PARSER_TRACING
+            trace_span span(trace_category::transform, _rerun ? "transform (rerun)" : "transform");
+#endif
+
+            // Transforms read through read and peek, so a failure still unwinds out of the transform once; it is kept, so that
+            // grammars testing alternatives at the failing position see it through try_peek without unwinding again
+            try {
                 m_transform([this] { return token_stream_traits<FromSource>::read(m_fromSource); },
                             [this] { return token_stream_traits<FromSource>::peek(m_fromSource); },
                             [this] { return token_stream_traits<FromSource>::at_end(m_fromSource); },
                             [this](token_type token) { m_pendingTokens.push_back(token); });
+            } catch (token_stream_no_token<error_type> const& _exception) {
+                m_fetchError = token_stream_detail::no_token_result<token_type>(_exception);
+            }
         }
 
         void fetch_tokens_if_needed() {
@@ -209,15 +349,17 @@ namespace randomcat::parser {
                 m_location = {token_stream_traits<FromSource>::head(m_fromSource), 0};
                 m_pendingTokens.clear();
 
-                if (token_stream_traits<FromSource>::at_end(m_fromSource)) return;
+                if (m_fetchError || token_stream_traits<FromSource>::at_end(m_fromSource)) return;
 
-                fetch_tokens_once();
+                fetch_tokens_once(false);
             }
         }
 
         Transform m_transform;
         std::vector<token_type> m_pendingTokens;
+        std::optional<try_result_type> m_fetchError;
         location_type m_location;
         FromSource m_fromSource;
+        Stats m_stats;
     };
 }    // namespace randomcat::parser
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace randomcat::parser_benchmarks {
+    // Parses sizes such as "4096", "64K", "16M" or "2G" (binary multiples)
+    inline std::uint64_t parse_size(std::string_view _text) {
+        if (_text.empty()) throw std::invalid_argument("Empty size");
+
+        std::uint64_t multiplier = 1;
+
+        switch (_text.back()) {
+            case 'K':
+            case 'k': multiplier = std::uint64_t(1) << 10; break;
+            case 'M':
+            case 'm': multiplier = std::uint64_t(1) << 20; break;
+            case 'G':
+            case 'g': multiplier = std::uint64_t(1) << 30; break;
+            default: break;
+        }
+
+        if (multiplier != 1) _text.remove_suffix(1);
+
+        std::size_t parsed = 0;
+        auto const value = std::stoull(std::string(_text), &parsed);
+        if (parsed != _text.size()) throw std::invalid_argument("Invalid size: " + std::string(_text));
+
+        return value * multiplier;
+    }
+
+    // Parses comma separated sizes, e.g. "64K,1M,16M"
+    inline std::vector<std::uint64_t> parse_size_list(std::string_view _text) {
+        std::vector<std::uint64_t> result;
+
+        while (true) {
+            auto const comma = _text.find(',');
+            result.push_back(parse_size(_text.substr(0, comma)));
+
+            if (comma == std::string_view::npos) return result;
+            _text.remove_prefix(comma + 1);
+        }
+    }
+
+    inline std::string format_size(std::uint64_t _size) {
+        static constexpr char const* suffixes[] = {"", "K", "M", "G"};
+
+        std::size_t suffix = 0;
+        while (suffix + 1 < std::size(suffixes) && _size >= 1024 && _size % 1024 == 0) {
+            _size /= 1024;
+            ++suffix;
+        }
+
+        return std::to_string(_size) + suffixes[suffix];
+    }
+}    // namespace randomcat::parser_benchmarks
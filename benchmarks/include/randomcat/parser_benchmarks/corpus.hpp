@@ -0,0 +1,462 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace randomcat::parser_benchmarks {
+    // SplitMix64, so that a seed produces the same corpus on every platform (the standard distributions do not guarantee that)
+    class corpus_random {
+    public:
+        explicit corpus_random(std::uint64_t _seed) noexcept : m_state(_seed) {}
+
+        std::uint64_t next() noexcept {
+            auto value = (m_state += 0x9e3779b97f4a7c15ULL);
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+            return value ^ (value >> 31);
+        }
+
+        // Slightly biased for bounds that are not powers of two, which does not matter here
+        std::size_t below(std::size_t _bound) noexcept { return static_cast<std::size_t>(next() % _bound); }
+
+        bool chance(std::size_t _percent) noexcept { return below(100) < _percent; }
+
+        template<typename T, std::size_t N>
+        T const& pick(T const (&_values)[N]) noexcept {
+            return _values[below(N)];
+        }
+
+    private:
+        std::uint64_t m_state;
+    };
+
+    namespace corpus_detail {
+        // Output is handed to the sink in chunks of roughly this size
+        inline constexpr std::size_t chunk_size = 64 * 1024;
+
+        inline constexpr char const* keywords[] = {
+            "asm", "auto", "bool", "break", "case", "catch", "char", "char8_t", "char16_t", "class", "const", "const_cast", "continue",
+            "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "extern", "false", "float", "for", "friend",
+            "goto", "if", "inline", "int", "long", "mutable", "new", "noexcept", "nullptr", "operator", "private", "protected", "public",
+            "register", "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+            "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union", "unsigned",
+            "using", "virtual", "void", "volatile", "wchar_t", "while",
+        };
+
+        // Every punctuator ComplexParser's tokenizer recognises, apart from the comment delimiters. Punctuators that only have a
+        // token kind, such as "," or "{", would lex as invalid tokens and so are only used where the generated structure needs them.
+        inline constexpr char const* punctuators[] = {
+            ".", "(", ")", ";", ":", "::", "+", "++", "-", "--", "*", "/", "&", "&&", "|", "||", "^", "~", "%", "?",
+        };
+
+        inline constexpr char const* escapes[] = {"\\'", "\\\"", "\\?", "\\\\", "\\a", "\\b", "\\f", "\\n", "\\r", "\\t", "\\v"};
+
+        inline constexpr char identifier_start[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+        inline constexpr char identifier_part[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+        inline constexpr char decimal_digits[] = "0123456789";
+        inline constexpr char text[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789 .,;:!?()[]{}<>+-*/=&|^~%#@$'";
+
+        // Comments are still tokenized, so they must neither end early ('*') nor start a literal that runs past them ('"')
+        inline constexpr char comment_text[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789 .,;:!?()[]{}<>+-/=&|^~%#@$'";
+
+        template<std::size_t N>
+        inline void append_chars(std::string& _out, corpus_random& _random, char const (&_alphabet)[N], std::size_t _count) {
+            // N includes the terminating null
+            for (std::size_t i = 0; i < _count; ++i) _out += _alphabet[_random.below(N - 1)];
+        }
+
+        inline void append_identifier(std::string& _out, corpus_random& _random) {
+            // Mostly short names, with the occasional very long one
+            auto const length = _random.chance(5) ? 32 + _random.below(96) : 1 + _random.below(12);
+
+            append_chars(_out, _random, identifier_start, 1);
+            append_chars(_out, _random, identifier_part, length - 1);
+        }
+
+        inline void append_string_literal(std::string& _out, corpus_random& _random) {
+            _out += '"';
+
+            auto const parts = _random.below(8);
+            for (std::size_t i = 0; i < parts; ++i) {
+                if (_random.chance(25)) {
+                    _out += _random.pick(escapes);
+                } else {
+                    append_chars(_out, _random, identifier_part, 1 + _random.below(10));
+                    _out += ' ';
+                }
+            }
+
+            _out += '"';
+        }
+
+        inline void append_raw_string_literal(std::string& _out, corpus_random& _random) {
+            std::string delimiter;
+            if (_random.chance(50)) append_chars(delimiter, _random, identifier_part, 1 + _random.below(6));
+
+            _out += "R\"" + delimiter + "(";
+
+            // Raw strings may contain anything but their own terminator, including quotes, backslashes, newlines and a bare )"
+            auto const lines = 1 + _random.below(4);
+            for (std::size_t i = 0; i < lines; ++i) {
+                append_chars(_out, _random, text, _random.below(40));
+                if (not delimiter.empty() && _random.chance(30)) _out += ")\"";
+                if (_random.chance(30)) _out += "\\\" // /* ";
+                if (i + 1 != lines) _out += '\n';
+            }
+
+            _out += ")" + delimiter + "\"";
+        }
+
+        inline void append_line_comment(std::string& _out, corpus_random& _random) {
+            _out += "//";
+            append_chars(_out, _random, comment_text, _random.below(60));
+
+            // Comment delimiters inside comments must not start or end anything
+            if (_random.chance(30)) _out += " /* not a block // still the same comment";
+            _out += '\n';
+        }
+
+        inline void append_block_comment(std::string& _out, corpus_random& _random) {
+            _out += "/*";
+
+            auto const lines = 1 + _random.below(5);
+            for (std::size_t i = 0; i < lines; ++i) {
+                append_chars(_out, _random, comment_text, _random.below(60));
+                if (_random.chance(30)) _out += " /* nested opener // line comment inside ";
+                if (i + 1 != lines) _out += "\n   ";
+            }
+
+            _out += "*/";
+        }
+
+        inline void append_expression(std::string& _out, corpus_random& _random, std::size_t _depth) {
+            auto const operands = 1 + _random.below(4);
+
+            for (std::size_t i = 0; i < operands; ++i) {
+                if (i != 0) {
+                    _out += ' ';
+                    _out += _random.pick(punctuators);
+                    _out += ' ';
+                }
+
+                // No numbers, since ComplexParser has no token kind for them and would lex every digit as an invalid token
+                switch (_depth == 0 ? _random.below(3) : _random.below(6)) {
+                    case 0: append_identifier(_out, _random); break;
+                    case 1: append_string_literal(_out, _random); break;
+                    case 2: _out += _random.pick(keywords); break;
+                    case 3:
+                        _out += '(';
+                        append_expression(_out, _random, _depth - 1);
+                        _out += ')';
+                        break;
+                    case 4:
+                        append_identifier(_out, _random);
+                        _out += '(';
+                        append_expression(_out, _random, _depth - 1);
+                        _out += ", ";
+                        append_expression(_out, _random, _depth - 1);
+                        _out += ')';
+                        break;
+                    default: append_raw_string_literal(_out, _random); break;
+                }
+            }
+        }
+
+        inline void append_statement(std::string& _out, corpus_random& _random, std::size_t _indent) {
+            _out.append(_indent * 4, ' ');
+
+            switch (_random.below(10)) {
+                case 0: append_line_comment(_out, _random); return;
+                case 1: append_block_comment(_out, _random); break;
+                case 2:
+                    _out += "if (";
+                    append_expression(_out, _random, 2);
+                    _out += ") return ";
+                    append_expression(_out, _random, 1);
+                    _out += ';';
+                    break;
+                case 3:
+                    _out += "auto ";
+                    append_identifier(_out, _random);
+                    _out += " = ";
+                    append_expression(_out, _random, 3);
+                    _out += ';';
+                    break;
+                default:
+                    append_expression(_out, _random, 3);
+                    _out += ';';
+                    break;
+            }
+
+            _out += _random.chance(10) ? " // trailing\n" : (_random.chance(10) ? "\t\r\n" : "\n");
+        }
+
+        inline void append_keyword_region(std::string& _out, corpus_random& _random) {
+            auto const count = 8 + _random.below(32);
+
+            for (std::size_t i = 0; i < count; ++i) {
+                _out += _random.pick(keywords);
+                _out += (i % 8 == 7) ? '\n' : ' ';
+            }
+
+            _out += '\n';
+        }
+
+        inline void append_complex_unit(std::string& _out, corpus_random& _random) {
+            switch (_random.below(8)) {
+                case 0: append_keyword_region(_out, _random); return;
+                case 1: append_block_comment(_out, _random); _out += '\n'; return;
+                default: break;
+            }
+
+            _out += _random.pick(keywords);
+            _out += ' ';
+            append_identifier(_out, _random);
+            _out += "(const ";
+            append_identifier(_out, _random);
+            _out += "& value) -> bool {\n";
+
+            auto const statements = 1 + _random.below(12);
+            for (std::size_t i = 0; i < statements; ++i) append_statement(_out, _random, 1 + _random.below(3));
+
+            _out += "}\n\n";
+        }
+
+        inline void append_simple_term(std::string& _out, corpus_random& _random, std::size_t _depth) {
+            static constexpr char const* atoms[] = {"theta", "omega", "pi", "e"};
+            static constexpr char const* functions[] = {"sin(", "cos(", "tan("};
+            static constexpr char const* operators[] = {" + ", " - ", " * ", " / "};
+
+            if (_depth == 0) {
+                if (_random.chance(60)) {
+                    _out += std::to_string(_random.below(10000));
+                } else {
+                    _out += _random.pick(atoms);
+                }
+
+                return;
+            }
+
+            switch (_random.below(3)) {
+                case 0: _out += '('; break;
+                case 1: _out += _random.pick(functions); break;
+                default: _out += "-("; break;
+            }
+
+            auto const operands = 1 + _random.below(3);
+            for (std::size_t i = 0; i < operands; ++i) {
+                if (i != 0) _out += _random.pick(operators);
+
+                // Keep one operand at full depth, so that nesting actually reaches _depth
+                append_simple_term(_out, _random, i == 0 ? _depth - 1 : _random.below(_depth));
+            }
+
+            _out += ')';
+        }
+
+        inline void append_digits(std::string& _out, corpus_random& _random, std::size_t _count, bool _separators) {
+            _out += static_cast<char>('1' + _random.below(9));
+
+            for (std::size_t i = 1; i < _count; ++i) {
+                if (_separators && (_count - i) % 3 == 0) _out += '\'';
+                _out += static_cast<char>('0' + _random.below(10));
+            }
+        }
+
+        // Integers up to 2^64 - 1 (some with digit separators), hexadecimal integers, decimal fractions and scientific notation
+        // spanning the whole range of double
+        inline void append_numeric_literal(std::string& _out, corpus_random& _random, bool _separators) {
+            static constexpr char hex_digits[] = "0123456789abcdefABCDEF";
+
+            switch (_random.below(10)) {
+                case 0:
+                case 1:
+                case 2: {
+                    append_digits(_out, _random, 1 + _random.below(19), _separators && _random.chance(30));
+                    break;
+                }
+
+                case 3: {
+                    _out += "0x";
+                    append_chars(_out, _random, hex_digits, 1 + _random.below(16));
+                    break;
+                }
+
+                case 4:
+                case 5:
+                case 6:
+                case 7: {
+                    append_digits(_out, _random, 1 + _random.below(8), false);
+                    _out += '.';
+                    append_chars(_out, _random, decimal_digits, 1 + _random.below(17));
+                    break;
+                }
+
+                default: {
+                    append_digits(_out, _random, 1, false);
+                    _out += '.';
+                    append_chars(_out, _random, decimal_digits, 16);
+                    _out += _random.chance(50) ? "e-" : "e+";
+                    _out += std::to_string(_random.below(308));
+                    break;
+                }
+            }
+        }
+
+        // A string literal of a few hundred to a few thousand chars with the occasional escape, or a raw string literal of as many
+        // chars over several lines
+        inline void append_long_literal(std::string& _out, corpus_random& _random) {
+            auto const runs = 1 + _random.below(8);
+
+            if (_random.chance(50)) {
+                _out += '"';
+
+                for (std::size_t i = 0; i < runs; ++i) {
+                    if (i != 0) _out += _random.pick(escapes);
+                    append_chars(_out, _random, text, 100 + _random.below(400));
+                }
+
+                _out += '"';
+            } else {
+                _out += "R\"long(";
+
+                for (std::size_t i = 0; i < runs; ++i) {
+                    if (i != 0) _out += '\n';
+                    append_chars(_out, _random, text, 100 + _random.below(400));
+                }
+
+                _out += ")long\"";
+            }
+        }
+
+        template<typename Sink>
+        void flush(std::string& _buffer, std::uint64_t& _written, Sink& _sink, bool _force) {
+            if (_buffer.empty() || (not _force && _buffer.size() < chunk_size)) return;
+
+            _written += _buffer.size();
+            _sink(std::string_view(_buffer));
+            _buffer.clear();
+        }
+    }    // namespace corpus_detail
+
+    // Generates C++-like source covering every token kind ComplexParser's tokenizer recognises, apart from a stray \ or */: nested
+    // comment delimiters, raw strings with custom delimiters, very long identifiers and keyword-dense regions. Kinds it has no
+    // descriptor for only appear as structure needs them, as invalid tokens. Calls _sink(std::string_view) with consecutive chunks
+    // until at least _size bytes were produced, so arbitrarily large corpora never have to be held in memory.
+    template<typename Sink>
+    void generate_complex_source(std::uint64_t _seed, std::uint64_t _size, Sink&& _sink) {
+        corpus_random random(_seed);
+
+        std::string buffer;
+        std::uint64_t written = 0;
+
+        while (written + buffer.size() < _size) {
+            corpus_detail::append_complex_unit(buffer, random);
+            corpus_detail::flush(buffer, written, _sink, false);
+        }
+
+        corpus_detail::flush(buffer, written, _sink, true);
+    }
+
+    // Generates a single SimpleParser expression of at least _size bytes: a sum of terms that are each nested up to _maxDepth
+    // levels deep in parentheses, unary minus and function calls.
+    template<typename Sink>
+    void generate_simple_expression(std::uint64_t _seed, std::uint64_t _size, std::size_t _maxDepth, Sink&& _sink) {
+        static constexpr char const* operators[] = {" + ", " - ", " * ", " / "};
+
+        corpus_random random(_seed);
+
+        std::string buffer;
+        std::uint64_t written = 0;
+
+        corpus_detail::append_simple_term(buffer, random, random.below(_maxDepth + 1));
+
+        while (written + buffer.size() < _size) {
+            buffer += random.pick(operators);
+            corpus_detail::append_simple_term(buffer, random, random.below(_maxDepth + 1));
+            corpus_detail::flush(buffer, written, _sink, false);
+        }
+
+        buffer += '\n';
+        corpus_detail::flush(buffer, written, _sink, true);
+    }
+
+    // Generates a single SimpleParser expression of at least _size bytes that is a sum of numeric literals of every form
+    // SimpleParser accepts, for benchmarking number-heavy input
+    template<typename Sink>
+    void generate_numeric_expression(std::uint64_t _seed, std::uint64_t _size, Sink&& _sink) {
+        static constexpr char const* operators[] = {" + ", " - ", " * ", " / "};
+
+        corpus_random random(_seed);
+
+        std::string buffer;
+        std::uint64_t written = 0;
+
+        corpus_detail::append_numeric_literal(buffer, random, true);
+
+        while (written + buffer.size() < _size) {
+            buffer += random.pick(operators);
+            corpus_detail::append_numeric_literal(buffer, random, true);
+            corpus_detail::flush(buffer, written, _sink, false);
+        }
+
+        buffer += '\n';
+        corpus_detail::flush(buffer, written, _sink, true);
+    }
+
+    // Generates ComplexParser input of at least _size bytes made of long string and raw string literals, one per line
+    template<typename Sink>
+    void generate_long_literals(std::uint64_t _seed, std::uint64_t _size, Sink&& _sink) {
+        corpus_random random(_seed);
+
+        std::string buffer;
+        std::uint64_t written = 0;
+
+        while (written + buffer.size() < _size) {
+            corpus_detail::append_long_literal(buffer, random);
+            buffer += '\n';
+            corpus_detail::flush(buffer, written, _sink, false);
+        }
+
+        corpus_detail::flush(buffer, written, _sink, true);
+    }
+
+    inline std::string complex_source(std::uint64_t _seed, std::uint64_t _size) {
+        std::string result;
+        generate_complex_source(_seed, _size, [&](std::string_view _chunk) { result += _chunk; });
+        return result;
+    }
+
+    inline std::string simple_expression(std::uint64_t _seed, std::uint64_t _size, std::size_t _maxDepth) {
+        std::string result;
+        generate_simple_expression(_seed, _size, _maxDepth, [&](std::string_view _chunk) { result += _chunk; });
+        return result;
+    }
+
+    inline std::string long_literals(std::uint64_t _seed, std::uint64_t _size) {
+        std::string result;
+        generate_long_literals(_seed, _size, [&](std::string_view _chunk) { result += _chunk; });
+        return result;
+    }
+
+    inline std::string numeric_expression(std::uint64_t _seed, std::uint64_t _size) {
+        std::string result;
+        generate_numeric_expression(_seed, _size, [&](std::string_view _chunk) { result += _chunk; });
+        return result;
+    }
+
+    // _count numeric literals without digit separators, one per line, so that they can also be read with strtod and strtoull
+    inline std::string numeric_literal_lines(std::uint64_t _seed, std::size_t _count) {
+        corpus_random random(_seed);
+        std::string result;
+
+        for (std::size_t i = 0; i < _count; ++i) {
+            corpus_detail::append_numeric_literal(result, random, false);
+            result += '\n';
+        }
+
+        return result;
+    }
+}    // namespace randomcat::parser_benchmarks
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <randomcat/parser/diagnostics/allocation_tracking.hpp>
+#include <randomcat/parser/diagnostics/hardware_counters.hpp>
+
+namespace randomcat::parser_benchmarks {
+    template<typename T>
+    inline void do_not_optimize(T const& _value) {
+        asm volatile("" : : "r,m"(_value) : "memory");
+    }
+
+    struct benchmark_options {
+        // Only benchmarks whose name contains this are run
+        std::string filter;
+
+        // Every benchmark repeats until it has run for at least this long and at least min_iterations times
+        std::chrono::nanoseconds min_time = std::chrono::milliseconds(250);
+        std::size_t min_iterations = 3;
+
+        // Whether one extra iteration of every benchmark is measured with hardware counters
+        bool hardware_counters = false;
+    };
+
+    struct benchmark_result {
+        std::string name;
+
+        std::size_t iterations = 0;
+        std::chrono::nanoseconds total_time = std::chrono::nanoseconds::zero();
+
+        std::uint64_t bytes_per_iteration = 0;
+        std::uint64_t items_per_iteration = 0;
+        std::string item_unit;
+
+        // Extra named measurements reported alongside the timings
+        std::vector<std::pair<std::string, double>> counters = {};
+
+        // Allocations made by one iteration; only reported if allocation counting is installed
+        parser::allocation_counts allocations = {};
+
+        double seconds_per_iteration() const noexcept { return std::chrono::duration<double>(total_time).count() / static_cast<double>(iterations); }
+
+        double megabytes_per_second() const noexcept { return static_cast<double>(bytes_per_iteration) / seconds_per_iteration() / 1e6; }
+
+        double items_per_second() const noexcept { return static_cast<double>(items_per_iteration) / seconds_per_iteration(); }
+
+        double nanoseconds_per_item() const noexcept {
+            return items_per_iteration == 0 ? 0 : seconds_per_iteration() * 1e9 / static_cast<double>(items_per_iteration);
+        }
+    };
+
+    // Upper bounds for the allocations of one iteration of the benchmark called name, relative to its size so that inputs can
+    // change without touching the budgets. A benchmark that exceeds its budget is reported as a failure.
+    struct allocation_budget {
+        std::string name;
+        double allocations_per_item;
+        double allocated_bytes_per_byte;
+        double peak_live_bytes_per_byte;
+    };
+
+    class benchmark_suite {
+    public:
+        explicit benchmark_suite(benchmark_options _options, std::vector<allocation_budget> _budgets = {})
+        : m_options(std::move(_options)), m_budgets(std::move(_budgets)) {}
+
+        bool selected(std::string_view _name) const noexcept { return _name.find(m_options.filter) != std::string_view::npos; }
+
+        // _body() runs one iteration over _bytes bytes of input and returns the number of items (tokens, expressions, ...) it processed.
+        // Returns the recorded result, which stays valid for the life of the suite, or nullptr if the benchmark was filtered out.
+        template<typename Body>
+        benchmark_result* run(std::string _name, std::uint64_t _bytes, std::string _itemUnit, Body&& _body) {
+            if (not selected(_name)) return nullptr;
+
+            using clock = std::chrono::steady_clock;
+
+            // Warm up caches and lazily initialized state, and find out how many items an iteration processes
+            auto const items = static_cast<std::uint64_t>(_body());
+
+            benchmark_result result;
+            result.name = std::move(_name);
+            result.bytes_per_iteration = _bytes;
+            result.items_per_iteration = items;
+            result.item_unit = std::move(_itemUnit);
+
+            auto const start = clock::now();
+
+            do {
+                do_not_optimize(_body());
+                ++result.iterations;
+                result.total_time = clock::now() - start;
+            } while (result.total_time < m_options.min_time || result.iterations < m_options.min_iterations);
+
+            {
+                parser::allocation_scope allocations;
+                do_not_optimize(_body());
+                result.allocations = allocations.counts();
+            }
+
+            if (m_options.hardware_counters) add_hardware_counters(result, _body);
+
+            check_budget(result);
+
+            std::fprintf(stderr,
+                         "%-48s %10.1f us/iter %10.2f MB/s %12.0f %s/s\n",
+                         result.name.c_str(),
+                         result.seconds_per_iteration() * 1e6,
+                         result.megabytes_per_second(),
+                         result.items_per_second(),
+                         result.item_unit.c_str());
+
+            m_results.push_back(std::move(result));
+            return &m_results.back();
+        }
+
+        std::deque<benchmark_result> const& results() const noexcept { return m_results; }
+
+        // Descriptions of every exceeded allocation budget
+        std::vector<std::string> const& budget_failures() const noexcept { return m_budgetFailures; }
+
+        void write_json(std::ostream& _out) const {
+            _out << "{\n  \"benchmarks\": [";
+
+            for (std::size_t i = 0; i < m_results.size(); ++i) {
+                auto const& result = m_results[i];
+
+                _out << (i == 0 ? "\n" : ",\n") << "    {";
+                _out << "\"name\": " << quote(result.name);
+                _out << ", \"iterations\": " << result.iterations;
+                _out << ", \"ns_per_iteration\": " << number(result.seconds_per_iteration() * 1e9);
+                _out << ", \"bytes_per_iteration\": " << result.bytes_per_iteration;
+                _out << ", \"mb_per_second\": " << number(result.megabytes_per_second());
+                _out << ", \"item_unit\": " << quote(result.item_unit);
+                _out << ", \"items_per_iteration\": " << result.items_per_iteration;
+                _out << ", \"items_per_second\": " << number(result.items_per_second());
+                _out << ", \"ns_per_item\": " << number(result.nanoseconds_per_item());
+
+                if (parser::allocation_counting_installed()) {
+                    _out << ", \"allocations\": " << result.allocations.allocations;
+                    _out << ", \"allocated_bytes\": " << result.allocations.bytes_allocated;
+                    _out << ", \"peak_live_bytes\": " << result.allocations.peak_live_bytes;
+                }
+
+                for (auto const& [counterName, value] : result.counters) _out << ", " << quote(counterName) << ": " << number(value);
+
+                _out << "}";
+            }
+
+            _out << "\n  ]\n}\n";
+        }
+
+    private:
+        // Adds the counters of one iteration per byte and per item, e.g. "cycles_per_byte" and "branch_misses_per_token"
+        template<typename Body>
+        static void add_hardware_counters(benchmark_result& _result, Body& _body) {
+            parser::hardware_counter_scope scope;
+            do_not_optimize(_body());
+            auto const counts = scope.stop();
+
+            for (std::size_t i = 0; i < parser::hardware_counter_count; ++i) {
+                auto const counter = static_cast<parser::hardware_counter>(i);
+                auto const name = std::string(parser::hardware_counter_name(counter));
+                auto const itemName = name + "_per_" + singular(_result.item_unit);
+
+                if (auto const perByte = counts.per(counter, _result.bytes_per_iteration)) _result.counters.emplace_back(name + "_per_byte", *perByte);
+                if (auto const perItem = counts.per(counter, _result.items_per_iteration)) _result.counters.emplace_back(itemName, *perItem);
+            }
+
+            if (auto const ipc = counts.instructions_per_cycle()) _result.counters.emplace_back("instructions_per_cycle", *ipc);
+        }
+
+        // "tokens" -> "token"
+        static std::string singular(std::string_view _unit) {
+            if (not _unit.empty() && _unit.back() == 's') _unit.remove_suffix(1);
+            return std::string(_unit);
+        }
+
+        void check_budget(benchmark_result const& _result) {
+            if (not parser::allocation_counting_installed()) return;
+
+            for (auto const& budget : m_budgets) {
+                if (budget.name != _result.name) continue;
+
+                auto const items = static_cast<double>(std::max<std::uint64_t>(_result.items_per_iteration, 1));
+                auto const bytes = static_cast<double>(std::max<std::uint64_t>(_result.bytes_per_iteration, 1));
+
+                auto const check = [&](char const* _what, double _value, double _limit) {
+                    if (_value <= _limit) return;
+
+                    char buffer[256];
+                    std::snprintf(buffer, sizeof(buffer), "%s: %.3f %s exceeds the budget of %.3f", _result.name.c_str(), _value, _what, _limit);
+                    m_budgetFailures.push_back(buffer);
+                };
+
+                check("allocations per item", static_cast<double>(_result.allocations.allocations) / items, budget.allocations_per_item);
+                check("allocated bytes per byte", static_cast<double>(_result.allocations.bytes_allocated) / bytes, budget.allocated_bytes_per_byte);
+                check("peak live bytes per byte", static_cast<double>(_result.allocations.peak_live_bytes) / bytes, budget.peak_live_bytes_per_byte);
+            }
+        }
+
+        static std::string quote(std::string_view _value) {
+            std::string result = "\"";
+
+            for (auto const c : _value) {
+                if (c == '"' || c == '\\') {
+                    result += '\\';
+                    result += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                    result += buffer;
+                } else {
+                    result += c;
+                }
+            }
+
+            return result + "\"";
+        }
+
+        static std::string number(double _value) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.6g", _value);
+            return buffer;
+        }
+
+        benchmark_options m_options;
+        std::vector<allocation_budget> m_budgets;
+        // A deque, so that the results handed out by run stay where they are as later runs are recorded
+        std::deque<benchmark_result> m_results;
+        std::vector<std::string> m_budgetFailures;
+    };
+}    // namespace randomcat::parser_benchmarks
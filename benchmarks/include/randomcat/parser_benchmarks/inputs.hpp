@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace randomcat::parser_benchmarks {
+    // A flat SimpleParser expression with _terms operands, e.g. "1 + 23 * theta - 4 / 5 ..."
+    inline std::string wide_expression(std::size_t _terms) {
+        static constexpr char const* operands[] = {"1", "23", "456", "theta", "pi", "7890", "omega"};
+        static constexpr char const* operators[] = {" + ", " * ", " - ", " / "};
+
+        std::string result;
+
+        for (std::size_t i = 0; i < _terms; ++i) {
+            if (i != 0) result += operators[i % 4];
+            result += operands[i % 7];
+        }
+
+        // Descriptors that scan ahead never hit the end of the input
+        return result + "\n";
+    }
+
+    // A SimpleParser expression nested _depth levels deep, alternating parentheses, unary minus and functions
+    inline std::string deep_expression(std::size_t _depth) {
+        static constexpr char const* openers[] = {"(", "sin(", "-(", "cos(1 + "};
+
+        std::string result;
+        for (std::size_t i = 0; i < _depth; ++i) result += openers[i % 4];
+
+        result += "theta";
+
+        for (std::size_t i = _depth; i-- > 0;) result += (i % 2 == 0 ? " * 2)" : ")");
+
+        return result + "\n";
+    }
+}    // namespace randomcat::parser_benchmarks
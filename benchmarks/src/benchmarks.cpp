@@ -0,0 +1,420 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <randomcat/parser/chars/char_source.hpp>
+#include <randomcat/parser/chars/numeric_literal.hpp>
+#include <randomcat/parser/chars/readahead_char_source.hpp>
+#include <randomcat/parser/chars/shared_char_source.hpp>
+#include <randomcat/parser/chars/tokenizer.hpp>
+#include <randomcat/parser/diagnostics/counting_operator_new.hpp>
+#include <randomcat/parser/diagnostics/grammar_profiler.hpp>
+#include <randomcat/parser/diagnostics/hardware_counters.hpp>
+#include <randomcat/parser/diagnostics/instrumentation.hpp>
+#include <randomcat/parser/diagnostics/stats.hpp>
+#include <randomcat/parser/grammar/grammar_terms.hpp>
+#include <randomcat/parser/tokens/token_buffer.hpp>
+#include <randomcat/parser/tokens/token_stream/pipeline_token_stream.hpp>
+#include <randomcat/parser/tokens/token_stream/token_stream.hpp>
+
+#include "randomcat/complex_parsing/token_codec.hpp"
+#include "randomcat/complex_parsing/token_manipulation.hpp"
+#include "randomcat/complex_parsing/token_streams.hpp"
+#include "randomcat/complex_parsing/tokenizer.hpp"
+#include "randomcat/parser_benchmarks/corpus.hpp"
+#include "randomcat/parser_benchmarks/harness.hpp"
+#include "randomcat/parser_benchmarks/inputs.hpp"
+#include "randomcat/simple_parsing/expression_grammar.hpp"
+#include "randomcat/simple_parsing/token_streams.hpp"
+#include "randomcat/simple_parsing/tokenizer.hpp"
+
+namespace p = randomcat::parser;
+namespace b = randomcat::parser_benchmarks;
+
+namespace {
+    template<typename Tokenizer, typename CharSource>
+    std::size_t tokenize_count(Tokenizer const& _tokenizer, CharSource _source) {
+        auto result = p::tokenize(_tokenizer, _source);
+        if (result.is_error()) throw std::runtime_error("Benchmark input failed to tokenize");
+
+        return result.value().size();
+    }
+
+    template<typename TokenStream>
+    std::size_t drain(TokenStream _stream) {
+        std::size_t count = 0;
+
+        while (not _stream.at_end()) {
+            b::do_not_optimize(_stream.read());
+            ++count;
+        }
+
+        return count;
+    }
+
+    // Attaches the hot path counters of one instrumented iteration, so the JSON shows how much work was wasted
+    void add_stats_counters(b::benchmark_result* _result, p::parser_stats const& _stats) {
+        if (not _result) return;
+
+        auto const snapshot = _stats.snapshot();
+
+        _result->counters.insert(_result->counters.end(),
+                                 {{"descriptor_attempts", static_cast<double>(snapshot.descriptor_attempts())},
+                                  {"descriptor_rejections", static_cast<double>(snapshot.descriptor_rejections())},
+                                  {"chars_peeked", static_cast<double>(snapshot.chars_peeked)},
+                                  {"chars_consumed", static_cast<double>(snapshot.chars_consumed)},
+                                  {"rewinds", static_cast<double>(snapshot.rewinds)},
+                                  {"rewind_distance", static_cast<double>(snapshot.rewind_distance)},
+                                  {"lexes", static_cast<double>(snapshot.lexes)},
+                                  {"relexes", static_cast<double>(snapshot.relexes)},
+                                  {"transform_runs", static_cast<double>(snapshot.transform_runs)},
+                                  {"transform_reruns", static_cast<double>(snapshot.transform_reruns)}});
+    }
+
+    template<typename Tokenizer>
+    void tokenize_benchmarks(b::benchmark_suite& _suite, std::string const& _prefix, Tokenizer const& _tokenizer, std::string const& _input) {
+        auto const bytes = _input.size();
+
+        _suite.run(_prefix + "/string", bytes, "tokens", [&] { return tokenize_count(_tokenizer, p::string_char_source(_input)); });
+
+        _suite.run(_prefix + "/string_view", bytes, "tokens", [&] {
+            return tokenize_count(_tokenizer, p::string_view_char_source(std::string_view(_input)));
+        });
+
+        // Shared once up front, so each run only copies the source's reference to the chars, as string_view does
+        auto const sharedSource = p::shared_char_source(_input);
+        _suite.run(_prefix + "/shared", bytes, "tokens", [&] { return tokenize_count(_tokenizer, sharedSource); });
+
+        _suite.run(_prefix + "/istream_inplace", bytes, "tokens", [&] {
+            return tokenize_count(_tokenizer, p::istream_inplace_char_source(std::istringstream(_input)));
+        });
+
+        // tokenize() rewinds to the start when it is done, so the whole input has to stay retained
+        _suite.run(_prefix + "/readahead", bytes, "tokens", [&] {
+            using source_type = p::readahead_char_source<std::istringstream>;
+            return tokenize_count(_tokenizer, source_type(std::istringstream(_input), source_type::default_block_size, source_type::default_block_count, bytes));
+        });
+    }
+
+    // Reads the literals of _input, one per line, with parse_numeric_literal, and with strtod as a baseline
+    void numeric_literal_benchmarks(b::benchmark_suite& _suite, std::string const& _input) {
+        auto const bytes = _input.size();
+
+        _suite.run("numeric_literal/parse", bytes, "literals", [&] {
+            auto rest = std::string_view(_input);
+            std::size_t count = 0;
+
+            while (not rest.empty()) {
+                auto const result = p::parse_numeric_literal(rest);
+                if (not result) throw std::runtime_error("Benchmark input failed to parse as numeric literals");
+
+                b::do_not_optimize(result.value());
+                rest.remove_prefix(result.amount_parsed() + 1);
+                ++count;
+            }
+
+            return count;
+        });
+
+        _suite.run("numeric_literal/strtod", bytes, "literals", [&] {
+            char const* position = _input.c_str();
+            char const* const end = position + _input.size();
+            std::size_t count = 0;
+
+            while (position != end) {
+                char* literalEnd;
+                b::do_not_optimize(std::strtod(position, &literalEnd));
+
+                position = literalEnd + 1;
+                ++count;
+            }
+
+            return count;
+        });
+    }
+
+    void token_stream_benchmarks(b::benchmark_suite& _suite, std::string const& _input) {
+        namespace cp = randomcat::complex_parsing;
+
+        auto const tokenizer = cp::make_tokenizer();
+        auto const bytes = _input.size();
+        auto const source = [&] { return p::string_view_char_source(std::string_view(_input)); };
+
+        auto* const result = _suite.run("token_stream/char_source", bytes, "tokens", [&] { return drain(p::char_source_token_stream(source(), tokenizer)); });
+
+        if (result) {
+            p::parser_stats stats(tokenizer.token_parser_count);
+            drain(p::make_instrumented_token_stream(source(), tokenizer, stats));
+            add_stats_counters(result, stats);
+        }
+
+        _suite.run("token_stream/strip_whitespace", bytes, "tokens", [&] {
+            return drain(cp::strip_whitespace_token_stream(p::char_source_token_stream(source(), tokenizer)));
+        });
+
+        _suite.run("token_stream/strip_comments_and_whitespace", bytes, "tokens", [&] {
+            return drain(cp::strip_whitespace_token_stream(cp::strip_comments_token_stream(p::char_source_token_stream(source(), tokenizer))));
+        });
+
+        // The same stages, lexing on one thread and stripping on another while the calling thread drains
+        _suite.run("token_stream/strip_comments_and_whitespace/pipeline", bytes, "tokens", [&] {
+            return drain(p::pipeline_token_stream(
+                cp::strip_whitespace_token_stream(cp::strip_comments_token_stream(p::pipeline_token_stream(p::char_source_token_stream(source(), tokenizer))))));
+        });
+    }
+
+    // Stripping comments and whitespace from tokens that are already in memory, from a vector of tokens and from a token_buffer.
+    // Each run strips a fresh copy, so both include copying their tokens.
+    void token_buffer_benchmarks(b::benchmark_suite& _suite, std::string const& _input) {
+        namespace cp = randomcat::complex_parsing;
+
+        auto const tokenizer = cp::make_tokenizer();
+        auto const bytes = _input.size();
+        auto const source = p::string_view_char_source(std::string_view(_input));
+
+        auto const tokens = p::tokenize(tokenizer, source).value();
+        auto const buffer = p::tokenize_to_buffer<cp::token_codec>(tokenizer, source).value();
+
+        _suite.run("token_vector/strip_comments_and_whitespace", bytes, "tokens", [&] {
+            auto copy = tokens;
+            copy.erase(cp::strip_comments_and_whitespace(copy.begin(), copy.end()), copy.end());
+            return tokens.size();
+        });
+
+        _suite.run("token_buffer/strip_comments_and_whitespace", bytes, "tokens", [&] {
+            auto copy = buffer;
+            cp::strip_comments_and_whitespace(copy);
+            return buffer.size();
+        });
+
+        _suite.run("token_buffer/count", bytes, "tokens", [&] {
+            b::do_not_optimize(buffer.count(cp::comment_and_whitespace_kinds));
+            return buffer.size();
+        });
+
+        _suite.run("token_buffer/histogram", bytes, "tokens", [&] {
+            b::do_not_optimize(buffer.histogram());
+            return buffer.size();
+        });
+    }
+
+    // Stripping comments from tokens that are already in memory, serially and on every hardware thread. Both build a new vector
+    // of the kept tokens.
+    void parallel_filter_benchmarks(b::benchmark_suite& _suite, std::string const& _input) {
+        namespace cp = randomcat::complex_parsing;
+
+        auto const tokenizer = cp::make_tokenizer();
+        auto const bytes = _input.size();
+        auto const tokens = p::tokenize(tokenizer, p::string_view_char_source(std::string_view(_input))).value();
+
+        _suite.run("token_vector/strip_comments/serial", bytes, "tokens", [&] {
+            auto copy = tokens;
+            copy.erase(cp::strip_comments(copy.begin(), copy.end()), copy.end());
+            return tokens.size();
+        });
+
+        _suite.run("token_vector/strip_comments/parallel", bytes, "tokens", [&] {
+            b::do_not_optimize(cp::parallel_strip_comments(tokens));
+            return tokens.size();
+        });
+    }
+
+    // Combining the literals of _input, which follow each other with only whitespace between them, into one. Each run combines a
+    // fresh copy of the tokens.
+    void combine_benchmarks(b::benchmark_suite& _suite, std::string const& _input) {
+        namespace cp = randomcat::complex_parsing;
+
+        auto const tokenizer = cp::make_tokenizer();
+
+        auto tokens = p::tokenize(tokenizer, p::string_view_char_source(std::string_view(_input))).value();
+        tokens.erase(cp::strip_comments_and_whitespace(tokens.begin(), tokens.end()), tokens.end());
+
+        _suite.run("token_vector/combine_string_literals", _input.size(), "tokens", [&] {
+            auto copy = tokens;
+            copy.erase(cp::combine_string_literals(copy.begin(), copy.end()), copy.end());
+            return tokens.size();
+        });
+    }
+
+    void grammar_benchmarks(b::benchmark_suite& _suite, std::string const& _name, std::string const& _input) {
+        namespace sp = randomcat::simple_parsing;
+
+        auto const tokenizer = sp::make_tokenizer();
+        auto const tokenCount = tokenize_count(tokenizer, p::string_view_char_source(std::string_view(_input)));
+
+        auto const parse = [&](auto _stream) {
+            auto const result = p::grammar_advance_if_matches(sp::expression_grammar(), _stream);
+            if (not result || not _stream.at_end()) throw std::runtime_error("Benchmark input failed to parse: " + _name);
+
+            return tokenCount;
+        };
+
+        auto* const result = _suite.run(_name, _input.size(), "tokens", [&] {
+            return parse(sp::strip_whitespace_token_stream(p::char_source_token_stream(p::string_view_char_source(std::string_view(_input)), tokenizer)));
+        });
+
+        if (result) {
+            p::parser_stats stats(tokenizer.token_parser_count);
+            parse(sp::strip_whitespace_token_stream(p::make_instrumented_token_stream(p::string_view_char_source(std::string_view(_input)), tokenizer, stats),
+                                                    p::counting_stats(stats)));
+            add_stats_counters(result, stats);
+        }
+
+#ifdef RANDOMCAT_PARSER_GRAMMAR_PROFILING
+        if (result) {
+            p::grammar_profiler profiler;
+
+            {
+                p::grammar_profiling_scope profilingScope(profiler);
+                parse(sp::strip_whitespace_token_stream(p::char_source_token_stream(p::string_view_char_source(std::string_view(_input)), tokenizer)));
+            }
+
+            std::cerr << "Grammar profile for " << _name << ":\n";
+            profiler.write_report(std::cerr);
+        }
+#endif
+
+        // The same parse without building error aggregates for failed alternatives
+        auto const fastFailTokenizer = tokenizer.with_error_policy<p::fast_fail_errors>();
+
+        _suite.run(_name + "/fast_fail", _input.size(), "tokens", [&] {
+            auto source = p::string_view_char_source(std::string_view(_input));
+            return parse(sp::strip_whitespace_token_stream(p::char_source_token_stream(std::move(source), fastFailTokenizer)));
+        });
+
+        // Lexing on another thread, overlapped with parsing
+        _suite.run(_name + "/pipeline", _input.size(), "tokens", [&] {
+            return parse(p::pipeline_token_stream(
+                sp::strip_whitespace_token_stream(p::char_source_token_stream(p::string_view_char_source(std::string_view(_input)), tokenizer))));
+        });
+    }
+
+    // About a quarter above what the benchmarks allocate at the time of writing; grammar parsing allocates superlinearly, so each
+    // input size has its own budget
+    std::vector<b::allocation_budget> allocation_budgets() {
+        return {
+            {"tokenize/simple/string", 0.05, 55, 40},
+            {"tokenize/simple/string_view", 0.05, 55, 40},
+            {"tokenize/simple/shared", 0.05, 55, 40},
+            {"tokenize/simple/istream_inplace", 17, 76, 40},
+            {"tokenize/simple/readahead", 0.05, 58, 42},
+            {"tokenize/complex/string", 1.4, 47, 26},
+            {"tokenize/complex/string_view", 1.4, 46, 25},
+            {"tokenize/complex/shared", 0.39, 32, 24},
+            {"tokenize/complex/istream_inplace", 4.1, 38, 26},
+            {"tokenize/complex/readahead", 1.4, 53, 29},
+            {"tokenize/literals/string", 3.3, 5, 2.6},
+            {"tokenize/literals/string_view", 3.3, 3.8, 1.4},
+            {"tokenize/literals/shared", 1.3, 0.2, 0.11},
+            {"tokenize/literals/istream_inplace", 13, 7.5, 2.6},
+            {"tokenize/literals/readahead", 5, 12, 7.5},
+            {"tokenize/numeric/string", 0.05, 17, 13},
+            {"tokenize/numeric/string_view", 0.05, 15, 12},
+            {"tokenize/numeric/shared", 0.05, 15, 12},
+            {"tokenize/numeric/istream_inplace", 17, 26, 13},
+            {"tokenize/numeric/readahead", 0.15, 24, 15},
+            {"numeric_literal/parse", 0.001, 0.01, 0.01},
+            {"token_stream/char_source", 1.15, 13, 0.01},
+            {"token_stream/strip_whitespace", 3.5, 24, 0.01},
+            {"token_stream/strip_comments_and_whitespace", 4, 21, 0.01},
+            // The input is shorter than the retained window, so every token is kept for grammars to rewind over
+            {"token_stream/strip_comments_and_whitespace/pipeline", 0.5, 16.5, 7.5},
+            {"token_vector/strip_comments_and_whitespace", 0.25, 9.5, 9.5},
+            {"token_buffer/strip_comments_and_whitespace", 0.25, 9.3, 9.3},
+            {"token_buffer/count", 0.001, 0.01, 0.01},
+            {"token_buffer/histogram", 0.001, 0.01, 0.01},
+            {"token_vector/combine_string_literals", 2.5, 2.5, 2.5},
+            {"token_vector/strip_comments/serial", 0.25, 9.6, 9.6},
+            // Also counts the per-block results that are moved into the final one when there is more than one hardware thread
+            {"token_vector/strip_comments/parallel", 0.25, 19, 19},
+            {"grammar/simple/wide_64", 32, 615, 49},
+            {"grammar/simple/wide_512", 172, 3220, 49},
+            {"grammar/simple/deep_8", 106, 2250, 51},
+            {"grammar/simple/deep_32", 358, 7400, 51},
+            {"grammar/simple/numeric", 165, 1030, 17},
+            {"grammar/simple/wide_64/pipeline", 32, 620, 57},
+            {"grammar/simple/wide_512/pipeline", 172, 3220, 50},
+            {"grammar/simple/deep_8/pipeline", 106, 2300, 104},
+            {"grammar/simple/deep_32/pipeline", 358, 7420, 65},
+            {"grammar/simple/numeric/pipeline", 165, 1030, 17},
+        };
+    }
+
+    [[noreturn]] void usage(char const* _program) {
+        std::cerr << "Usage: " << _program
+                  << " [--filter <substring>] [--min-time-ms <milliseconds>] [--output <file.json>] [--hardware-counters]\n";
+        std::exit(2);
+    }
+}    // namespace
+
+int main(int argc, char** argv) {
+    b::benchmark_options options;
+    std::string outputPath;
+
+    for (int i = 1; i < argc; ++i) {
+        auto const argument = std::string_view(argv[i]);
+
+        if (argument == "--hardware-counters") {
+            options.hardware_counters = true;
+            continue;
+        }
+
+        if (i + 1 == argc) usage(argv[0]);
+
+        if (argument == "--filter") {
+            options.filter = argv[++i];
+        } else if (argument == "--min-time-ms") {
+            options.min_time = std::chrono::milliseconds(std::atoll(argv[++i]));
+        } else if (argument == "--output") {
+            outputPath = argv[++i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (options.hardware_counters && not p::hardware_counter_scope().counters_available()) {
+        std::cerr << "Hardware counters are unavailable (see /proc/sys/kernel/perf_event_paranoid), reporting timings only\n";
+    }
+
+    b::benchmark_suite suite(options, allocation_budgets());
+
+    constexpr std::uint64_t corpusSeed = 1;
+
+    tokenize_benchmarks(suite, "tokenize/simple", randomcat::simple_parsing::make_tokenizer(), b::wide_expression(100'000));
+    tokenize_benchmarks(suite, "tokenize/complex", randomcat::complex_parsing::make_tokenizer(), b::complex_source(corpusSeed, 256 * 1024));
+    tokenize_benchmarks(suite, "tokenize/literals", randomcat::complex_parsing::make_tokenizer(), b::long_literals(corpusSeed, 256 * 1024));
+    tokenize_benchmarks(suite, "tokenize/numeric", randomcat::simple_parsing::make_tokenizer(), b::numeric_expression(corpusSeed, 256 * 1024));
+
+    numeric_literal_benchmarks(suite, b::numeric_literal_lines(corpusSeed, 100'000));
+
+    token_stream_benchmarks(suite, b::complex_source(corpusSeed, 256 * 1024));
+    token_buffer_benchmarks(suite, b::complex_source(corpusSeed, 256 * 1024));
+    combine_benchmarks(suite, b::long_literals(corpusSeed, 256 * 1024));
+    parallel_filter_benchmarks(suite, b::complex_source(corpusSeed, 4 * 1024 * 1024));
+
+    grammar_benchmarks(suite, "grammar/simple/wide_64", b::wide_expression(64));
+    grammar_benchmarks(suite, "grammar/simple/wide_512", b::wide_expression(512));
+    grammar_benchmarks(suite, "grammar/simple/deep_8", b::deep_expression(8));
+    grammar_benchmarks(suite, "grammar/simple/deep_32", b::deep_expression(32));
+    grammar_benchmarks(suite, "grammar/simple/numeric", b::numeric_expression(corpusSeed, 8 * 1024));
+
+    if (outputPath.empty()) {
+        suite.write_json(std::cout);
+    } else {
+        std::ofstream output(outputPath);
+        suite.write_json(output);
+
+        if (not output) {
+            std::cerr << "Unable to write " << outputPath << '\n';
+            return 1;
+        }
+    }
+
+    for (auto const& failure : suite.budget_failures()) std::cerr << "Allocation budget exceeded: " << failure << '\n';
+    if (not suite.budget_failures().empty()) return 1;
+}
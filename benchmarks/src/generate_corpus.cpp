@@ -0,0 +1,67 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "randomcat/parser_benchmarks/command_line.hpp"
+#include "randomcat/parser_benchmarks/corpus.hpp"
+
+namespace b = randomcat::parser_benchmarks;
+
+namespace {
+    [[noreturn]] void usage(char const* _program) {
+        std::cerr << "Usage: " << _program << " (complex|simple|numeric|literals) <size> <output file> [--seed <n>] [--max-depth <n>]\n"
+                  << "Sizes may use K, M and G suffixes. The same seed always produces the same corpus.\n";
+        std::exit(2);
+    }
+}    // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) usage(argv[0]);
+
+    auto const kind = std::string_view(argv[1]);
+    std::uint64_t seed = 1;
+    std::size_t maxDepth = 12;
+
+    for (int i = 4; i < argc; i += 2) {
+        auto const argument = std::string_view(argv[i]);
+        if (i + 1 == argc) usage(argv[0]);
+
+        if (argument == "--seed") {
+            seed = std::stoull(argv[i + 1]);
+        } else if (argument == "--max-depth") {
+            maxDepth = std::stoull(argv[i + 1]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    auto const size = b::parse_size(argv[2]);
+
+    std::ofstream output(argv[3], std::ios::binary);
+    if (not output) {
+        std::cerr << "Unable to open " << argv[3] << '\n';
+        return 1;
+    }
+
+    auto const sink = [&](std::string_view _chunk) { output.write(_chunk.data(), static_cast<std::streamsize>(_chunk.size())); };
+
+    if (kind == "complex") {
+        b::generate_complex_source(seed, size, sink);
+    } else if (kind == "simple") {
+        b::generate_simple_expression(seed, size, maxDepth, sink);
+    } else if (kind == "numeric") {
+        b::generate_numeric_expression(seed, size, sink);
+    } else if (kind == "literals") {
+        b::generate_long_literals(seed, size, sink);
+    } else {
+        usage(argv[0]);
+    }
+
+    output.close();
+    if (not output) {
+        std::cerr << "Unable to write " << argv[3] << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <randomcat/parser/diagnostics/trace.hpp>
+#include <randomcat/parser/driver/batch_driver.hpp>
+
+#include "randomcat/complex_parsing/tokenizer.hpp"
+#include "randomcat/parser_benchmarks/command_line.hpp"
+#include "randomcat/parser_benchmarks/corpus.hpp"
+#include "randomcat/simple_parsing/expression_grammar.hpp"
+#include "randomcat/simple_parsing/token_streams.hpp"
+#include "randomcat/simple_parsing/tokenizer.hpp"
+
+namespace p = randomcat::parser;
+namespace b = randomcat::parser_benchmarks;
+
+namespace {
+    struct scaling_options {
+        std::vector<std::uint64_t> sizes = {256 * 1024, 4 * 1024 * 1024, 32 * 1024 * 1024};
+
+        // Parsing is far slower than tokenizing, so it is swept over smaller corpora
+        std::vector<std::uint64_t> parse_sizes = {16 * 1024, 128 * 1024, 1024 * 1024};
+        std::vector<std::uint64_t> thread_counts = {};
+
+        // Corpora are split into files of these sizes, which are the unit of parallelism
+        std::uint64_t source_file_size = 256 * 1024;
+        std::uint64_t expression_file_size = 2 * 1024;
+        std::size_t max_depth = 12;
+
+        std::uint64_t seed = 1;
+        std::size_t repetitions = 3;
+
+        bool tokenize = true;
+        bool parse = true;
+
+        std::filesystem::path corpus_directory = {};
+        std::string output_path = {};
+
+        // Only has an effect if the library is built with RANDOMCAT_PARSER_TRACING
+        std::string trace_path = {};
+        std::uint32_t trace_sample_period = 1;
+    };
+
+    struct scaling_point {
+        std::string workload;
+        std::uint64_t size;
+        std::size_t files;
+        std::size_t threads;
+        double seconds;
+        std::uint64_t items;
+        std::string item_unit;
+
+        double megabytes_per_second() const noexcept { return static_cast<double>(size) / seconds / 1e6; }
+    };
+
+    // Writes a corpus of at least _size bytes as files of about _fileSize bytes each, the last one taking the remainder, every file
+    // with its own seed
+    template<typename Generate>
+    std::vector<std::string> write_corpus(std::filesystem::path const& _directory,
+                                          std::string const& _extension,
+                                          std::uint64_t _size,
+                                          std::uint64_t _fileSize,
+                                          std::uint64_t _seed,
+                                          Generate const& _generate) {
+        std::filesystem::create_directories(_directory);
+
+        auto const fileCount = std::max<std::uint64_t>(1, (_size + _fileSize - 1) / _fileSize);
+
+        std::vector<std::string> paths;
+
+        for (std::uint64_t i = 0; i < fileCount; ++i) {
+            auto const path = (_directory / ("corpus_" + std::to_string(i) + _extension)).string();
+
+            auto const fileSize = i + 1 == fileCount ? _size - i * _fileSize : _fileSize;
+
+            std::ofstream output(path, std::ios::binary);
+            _generate(_seed + i, fileSize, [&](std::string_view _chunk) { output.write(_chunk.data(), static_cast<std::streamsize>(_chunk.size())); });
+
+            if (not output) throw std::runtime_error("Unable to write corpus file: " + path);
+            paths.push_back(path);
+        }
+
+        return paths;
+    }
+
+    std::uint64_t total_size(std::vector<std::string> const& _paths) {
+        std::uint64_t result = 0;
+        for (auto const& path : _paths) result += std::filesystem::file_size(path);
+        return result;
+    }
+
+    // Runs _run() _repetitions times and keeps the fastest, which is the least disturbed by the rest of the system
+    template<typename Run>
+    double best_time(std::size_t _repetitions, Run const& _run) {
+        auto best = std::numeric_limits<double>::infinity();
+
+        for (std::size_t i = 0; i < std::max<std::size_t>(_repetitions, 1); ++i) {
+            auto const start = std::chrono::steady_clock::now();
+            _run();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        return best;
+    }
+
+    template<typename Results>
+    void check_results(Results const& _results, std::string const& _workload) {
+        for (auto const& result : _results) {
+            if (result.error) std::rethrow_exception(result.error);
+            if (not result.result) throw std::runtime_error(_workload + " failed for " + result.path);
+        }
+    }
+
+    std::vector<scaling_point> sweep_tokenize(scaling_options const& _options, std::uint64_t _size, std::filesystem::path const& _directory) {
+        namespace cp = randomcat::complex_parsing;
+
+        auto const paths = write_corpus(_directory, ".cpp", _size, _options.source_file_size, _options.seed, [](auto... _args) {
+            b::generate_complex_source(_args...);
+        });
+
+        auto const actualSize = total_size(paths);
+        std::vector<scaling_point> points;
+
+        for (auto const threads : _options.thread_counts) {
+            std::uint64_t tokens = 0;
+
+            auto const seconds = best_time(_options.repetitions, [&] {
+                auto const results = p::batch_tokenize(paths, [] { return cp::make_tokenizer(); }, p::batch_options{threads});
+                check_results(results, "Tokenizing");
+
+                tokens = 0;
+                for (auto const& result : results) tokens += result.result->value().size();
+            });
+
+            points.push_back(scaling_point{"tokenize", actualSize, paths.size(), threads, seconds, tokens, "tokens"});
+        }
+
+        return points;
+    }
+
+    std::vector<scaling_point> sweep_parse(scaling_options const& _options, std::uint64_t _size, std::filesystem::path const& _directory) {
+        namespace sp = randomcat::simple_parsing;
+
+        auto const paths = write_corpus(_directory, ".txt", _size, _options.expression_file_size, _options.seed, [&](auto _seed, auto _fileSize, auto&& _sink) {
+            b::generate_simple_expression(_seed, _fileSize, _options.max_depth, _sink);
+        });
+
+        auto const actualSize = total_size(paths);
+        std::vector<scaling_point> points;
+
+        for (auto const threads : _options.thread_counts) {
+            auto const seconds = best_time(_options.repetitions, [&] {
+                auto const results = p::batch_parse(
+                    paths,
+                    [] { return sp::make_tokenizer(); },
+                    [] { return sp::expression_grammar(); },
+                    p::batch_options{threads},
+                    [](auto _stream) { return sp::strip_whitespace_token_stream(std::move(_stream)); });
+
+                check_results(results, "Parsing");
+
+                for (auto const& result : results) {
+                    if (not result.result->complete) throw std::runtime_error("Generated expression did not parse: " + result.path);
+                }
+            });
+
+            points.push_back(scaling_point{"parse", actualSize, paths.size(), threads, seconds, paths.size(), "expressions"});
+        }
+
+        return points;
+    }
+
+    // Reports each point relative to the same workload with one thread at the same size (speedup and efficiency), and with
+    // the same thread count at the smallest size (size_efficiency), so that both kinds of non-linear scaling stand out.
+    void write_json(std::ostream& _out, scaling_options const& _options, std::vector<scaling_point> const& _points) {
+        _out << "{\n  \"seed\": " << _options.seed << ",\n  \"results\": [";
+
+        for (std::size_t i = 0; i < _points.size(); ++i) {
+            auto const& point = _points[i];
+
+            scaling_point const* singleThread = nullptr;
+            scaling_point const* smallest = nullptr;
+
+            for (auto const& other : _points) {
+                if (other.workload != point.workload) continue;
+
+                if (other.size == point.size && other.threads == 1) singleThread = &other;
+                if (other.threads == point.threads && (smallest == nullptr || other.size < smallest->size)) smallest = &other;
+            }
+
+            char buffer[512];
+            std::snprintf(buffer,
+                          sizeof(buffer),
+                          "%s    {\"workload\": \"%s\", \"size\": %llu, \"files\": %zu, \"threads\": %zu, \"seconds\": %.6g, "
+                          "\"mb_per_second\": %.6g, \"%s_per_second\": %.6g",
+                          i == 0 ? "\n" : ",\n",
+                          point.workload.c_str(),
+                          static_cast<unsigned long long>(point.size),
+                          point.files,
+                          point.threads,
+                          point.seconds,
+                          point.megabytes_per_second(),
+                          point.item_unit.c_str(),
+                          static_cast<double>(point.items) / point.seconds);
+            _out << buffer;
+
+            if (singleThread) {
+                auto const speedup = singleThread->seconds / point.seconds;
+                std::snprintf(buffer, sizeof(buffer), ", \"speedup\": %.4g, \"efficiency\": %.4g", speedup, speedup / static_cast<double>(point.threads));
+                _out << buffer;
+            }
+
+            if (smallest) {
+                std::snprintf(buffer, sizeof(buffer), ", \"size_efficiency\": %.4g", point.megabytes_per_second() / smallest->megabytes_per_second());
+                _out << buffer;
+            }
+
+            _out << "}";
+        }
+
+        _out << "\n  ]\n}\n";
+    }
+
+    [[noreturn]] void usage(char const* _program) {
+        std::cerr << "Usage: " << _program << " [options]\n"
+                  << "  --sizes <list>             source corpus sizes to tokenize, e.g. 64K,1M,1G (default 256K,4M,32M)\n"
+                  << "  --parse-sizes <list>       expression corpus sizes to parse (default 16K,128K,1M)\n"
+                  << "  --threads <list>           thread counts to sweep (default 1, 2, 4, ... up to the hardware thread count)\n"
+                  << "  --workloads <list>         tokenize, parse or both (default tokenize,parse)\n"
+                  << "  --source-file-size <size>  size of each generated source file (default 256K)\n"
+                  << "  --expression-size <size>   size of each generated expression file (default 2K)\n"
+                  << "  --max-depth <n>            maximum expression nesting (default 12)\n"
+                  << "  --seed <n>                 corpus seed (default 1)\n"
+                  << "  --repetitions <n>          runs per point, the fastest is reported (default 3)\n"
+                  << "  --corpus-dir <path>        where to write the corpus (default: a temporary directory)\n"
+                  << "  --output <file.json>       where to write the results (default: stdout)\n"
+                  << "  --trace <file.json>        write a Chrome trace of the sweep (needs RANDOMCAT_PARSER_TRACING)\n"
+                  << "  --trace-sample-period <n>  record every n-th lex, transform and grammar span (default 1)\n";
+        std::exit(2);
+    }
+
+    scaling_options parse_options(int argc, char** argv) {
+        scaling_options options;
+
+        for (int i = 1; i < argc; i += 2) {
+            auto const argument = std::string_view(argv[i]);
+            if (i + 1 == argc) usage(argv[0]);
+
+            auto const value = std::string_view(argv[i + 1]);
+
+            if (argument == "--sizes") {
+                options.sizes = b::parse_size_list(value);
+            } else if (argument == "--parse-sizes") {
+                options.parse_sizes = b::parse_size_list(value);
+            } else if (argument == "--threads") {
+                options.thread_counts = b::parse_size_list(value);
+            } else if (argument == "--workloads") {
+                options.tokenize = value.find("tokenize") != std::string_view::npos;
+                options.parse = value.find("parse") != std::string_view::npos;
+            } else if (argument == "--source-file-size") {
+                options.source_file_size = b::parse_size(value);
+            } else if (argument == "--expression-size") {
+                options.expression_file_size = b::parse_size(value);
+            } else if (argument == "--max-depth") {
+                options.max_depth = b::parse_size(value);
+            } else if (argument == "--seed") {
+                options.seed = b::parse_size(value);
+            } else if (argument == "--repetitions") {
+                options.repetitions = b::parse_size(value);
+            } else if (argument == "--corpus-dir") {
+                options.corpus_directory = value;
+            } else if (argument == "--output") {
+                options.output_path = value;
+            } else if (argument == "--trace") {
+                options.trace_path = value;
+            } else if (argument == "--trace-sample-period") {
+                options.trace_sample_period = static_cast<std::uint32_t>(b::parse_size(value));
+            } else {
+                usage(argv[0]);
+            }
+        }
+
+        if (options.thread_counts.empty()) {
+            auto const hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+            for (std::uint64_t threads = 1; threads < hardwareThreads; threads *= 2) options.thread_counts.push_back(threads);
+            options.thread_counts.push_back(hardwareThreads);
+        }
+
+        return options;
+    }
+}    // namespace
+
+int main(int argc, char** argv) {
+    auto options = parse_options(argc, argv);
+
+    bool const ownsDirectory = options.corpus_directory.empty();
+    if (ownsDirectory) {
+        options.corpus_directory = std::filesystem::temp_directory_path() / ("randomcat_parser_scaling_" + std::to_string(::getpid()));
+    }
+
+    std::vector<scaling_point> points;
+
+#ifndef RANDOMCAT_PARSER_TRACING
+    if (not options.trace_path.empty()) std::cerr << "Warning: built without RANDOMCAT_PARSER_TRACING, the trace will be empty\n";
+#endif
+
+    p::trace_options traceOptions;
+    traceOptions.sample_period = options.trace_sample_period;
+
+    p::trace_recorder recorder(std::move(traceOptions));
+    if (not options.trace_path.empty()) recorder.start();
+
+    // Only one corpus is on disk at a time, so that large sweeps need as little space as possible
+    auto const sweep = [&](std::vector<std::uint64_t> const& _sizes, std::string const& _kind, auto const& _sweepOne) {
+        for (auto const size : _sizes) {
+            auto const directory = options.corpus_directory / (_kind + "_" + b::format_size(size));
+
+            for (auto const& point : _sweepOne(options, size, directory)) {
+                std::fprintf(stderr,
+                             "%-10s %8s %6zu files %3zu threads %10.3f s %10.2f MB/s\n",
+                             point.workload.c_str(),
+                             b::format_size(size).c_str(),
+                             point.files,
+                             point.threads,
+                             point.seconds,
+                             point.megabytes_per_second());
+
+                points.push_back(point);
+            }
+
+            if (ownsDirectory) std::filesystem::remove_all(directory);
+        }
+    };
+
+    try {
+        if (options.tokenize) sweep(options.sizes, "complex", sweep_tokenize);
+        if (options.parse) sweep(options.parse_sizes, "simple", sweep_parse);
+    } catch (std::exception const& _error) {
+        std::cerr << "Error: " << _error.what() << '\n';
+        if (ownsDirectory) std::filesystem::remove_all(options.corpus_directory);
+        return 1;
+    }
+
+    if (ownsDirectory) std::filesystem::remove_all(options.corpus_directory);
+
+    if (not options.trace_path.empty()) {
+        recorder.stop();
+
+        std::ofstream trace(options.trace_path);
+        recorder.write_json(trace);
+
+        if (not trace) {
+            std::cerr << "Unable to write " << options.trace_path << '\n';
+            return 1;
+        }
+
+        if (auto const overwritten = recorder.overwritten_events()) std::cerr << "Trace buffers overwrote " << overwritten << " events\n";
+    }
+
+    if (options.output_path.empty()) {
+        write_json(std::cout, options, points);
+    } else {
+        std::ofstream output(options.output_path);
+        write_json(output, options, points);
+
+        if (not output) {
+            std::cerr << "Unable to write " << options.output_path << '\n';
+            return 1;
+        }
+    }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+
+#include "randomcat/complex_parsing/token.hpp"
+
+namespace randomcat::complex_parsing {
+    struct keyword {
+        std::string_view spelling;
+        token_kind kind;
+    };
+
+    // Every kw_ token kind
+    inline constexpr keyword keywords[] = {
+        {"asm", token_kind::kw_asm},
+        {"auto", token_kind::kw_auto},
+        {"bool", token_kind::kw_bool},
+        {"break", token_kind::kw_break},
+        {"case", token_kind::kw_case},
+        {"catch", token_kind::kw_catch},
+        {"char", token_kind::kw_char},
+        {"char8_t", token_kind::kw_char8_t},
+        {"char16_t", token_kind::kw_char16_t},
+        {"class", token_kind::kw_class},
+        {"const", token_kind::kw_const},
+        {"const_cast", token_kind::kw_const_cast},
+        {"continue", token_kind::kw_continue},
+        {"default", token_kind::kw_default},
+        {"delete", token_kind::kw_delete},
+        {"do", token_kind::kw_do},
+        {"double", token_kind::kw_double},
+        {"dynamic_cast", token_kind::kw_dynamic_cast},
+        {"else", token_kind::kw_else},
+        {"enum", token_kind::kw_enum},
+        {"explicit", token_kind::kw_explicit},
+        {"extern", token_kind::kw_extern},
+        {"false", token_kind::kw_false},
+        {"float", token_kind::kw_float},
+        {"for", token_kind::kw_for},
+        {"friend", token_kind::kw_friend},
+        {"goto", token_kind::kw_goto},
+        {"if", token_kind::kw_if},
+        {"inline", token_kind::kw_inline},
+        {"int", token_kind::kw_int},
+        {"long", token_kind::kw_long},
+        {"mutable", token_kind::kw_mutable},
+        {"new", token_kind::kw_new},
+        {"noexcept", token_kind::kw_noexcept},
+        {"nullptr", token_kind::kw_nullptr},
+        {"operator", token_kind::kw_operator},
+        {"private", token_kind::kw_private},
+        {"protected", token_kind::kw_protected},
+        {"public", token_kind::kw_public},
+        {"register", token_kind::kw_register},
+        {"reinterpret_cast", token_kind::kw_reinterpret_cast},
+        {"return", token_kind::kw_return},
+        {"short", token_kind::kw_short},
+        {"signed", token_kind::kw_signed},
+        {"sizeof", token_kind::kw_sizeof},
+        {"static", token_kind::kw_static},
+        {"static_assert", token_kind::kw_static_assert},
+        {"static_cast", token_kind::kw_static_cast},
+        {"struct", token_kind::kw_struct},
+        {"switch", token_kind::kw_switch},
+        {"template", token_kind::kw_template},
+        {"this", token_kind::kw_this},
+        {"thread_local", token_kind::kw_thread_local},
+        {"throw", token_kind::kw_throw},
+        {"true", token_kind::kw_true},
+        {"try", token_kind::kw_try},
+        {"typedef", token_kind::kw_typedef},
+        {"typeid", token_kind::kw_typeid},
+        {"typename", token_kind::kw_typename},
+        {"union", token_kind::kw_union},
+        {"unsigned", token_kind::kw_unsigned},
+        {"using", token_kind::kw_using},
+        {"virtual", token_kind::kw_virtual},
+        {"void", token_kind::kw_void},
+        {"volatile", token_kind::kw_volatile},
+        {"wchar_t", token_kind::kw_wchar_t},
+        {"while", token_kind::kw_while},
+    };
+
+    inline constexpr std::size_t keyword_count = std::size(keywords);
+
+    namespace keyword_detail {
+        // A power of two, large enough that a collision-free seed turns up within a few hundred tries
+        inline constexpr std::size_t table_size = 512;
+
+        inline constexpr std::uint8_t no_keyword = 0xFF;
+        static_assert(keyword_count < no_keyword);
+
+        // Seeded FNV-1a
+        constexpr std::size_t hash(std::string_view _str, std::uint32_t _seed) noexcept {
+            std::uint32_t result = 2166136261u ^ _seed;
+
+            for (auto const c : _str) {
+                result ^= static_cast<unsigned char>(c);
+                result *= 16777619u;
+            }
+
+            result ^= result >> 16;
+            return result & (table_size - 1);
+        }
+
+        struct perfect_hash_table {
+            std::uint32_t seed;
+
+            // Indices into keywords, or no_keyword
+            std::array<std::uint8_t, table_size> slots;
+        };
+
+        constexpr std::optional<perfect_hash_table> try_seed(std::uint32_t _seed) noexcept {
+            perfect_hash_table table = {_seed, {}};
+            for (auto& slot : table.slots) slot = no_keyword;
+
+            for (std::size_t i = 0; i < keyword_count; ++i) {
+                auto& slot = table.slots[hash(keywords[i].spelling, _seed)];
+                if (slot != no_keyword) return std::nullopt;
+
+                slot = static_cast<std::uint8_t>(i);
+            }
+
+            return table;
+        }
+
+        constexpr perfect_hash_table find_perfect_hash() noexcept {
+            for (std::uint32_t seed = 0;; ++seed) {
+                if (auto table = try_seed(seed)) return *table;
+            }
+        }
+
+        // Found while compiling, so classifying an identifier costs one hash and at most one comparison
+        inline constexpr perfect_hash_table keyword_table = find_perfect_hash();
+    }
+
+    // The keyword kind of _identifier, or nothing if it is not a keyword
+    constexpr std::optional<token_kind> keyword_kind(std::string_view _identifier) noexcept {
+        using namespace keyword_detail;
+
+        auto const slot = keyword_table.slots[hash(_identifier, keyword_table.seed)];
+        if (slot == no_keyword || keywords[slot].spelling != _identifier) return std::nullopt;
+
+        return keywords[slot].kind;
+    }
+}
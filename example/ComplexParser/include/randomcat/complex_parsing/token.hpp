@@ -1,10 +1,13 @@
 #pragma once
 
 #include <any>
+#include <cstddef>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 
+#include <randomcat/parser/chars/shared_char_source.hpp>
+
 //#include "randomcat/complex_parsing/impl_call.hpp"
 
 namespace randomcat::complex_parsing {
@@ -66,6 +69,9 @@ namespace randomcat::complex_parsing {
         slash_star,
         star_slash,
 
+        line_comment,
+        multiline_comment,
+
         identifier,
         string_literal,
 
@@ -137,11 +143,6 @@ namespace randomcat::complex_parsing {
         kw_wchar_t,
         kw_while,
 
-        line_comment_begin = slash_slash,
-        line_comment_end = newline,
-        multiline_comment_begin = slash_star,
-        multiline_comment_end = star_slash,
-
         arrow = minus_greater,
         arrow_star = minus_greater_star,
 
@@ -201,11 +202,26 @@ namespace randomcat::complex_parsing {
 
         static token make_string_literal(std::string _value) noexcept;
 
+        // A string literal that is only unescaped when its value is asked for. _body is its source text between the quotes, which
+        // is returned as is unless _hasEscapes.
+        static token make_lazy_string_literal(parser::shared_string_view _body, bool _hasEscapes) noexcept;
+
         static std::string string_literal_value(token const& _tok) noexcept;
 
+        // Appends the value of _tok to _out, without building it separately
+        static void append_string_literal_value(token const& _tok, std::string& _out) noexcept;
+
+        // At least the size of the value of _tok, found without unescaping it
+        static std::size_t max_string_literal_size(token const& _tok) noexcept;
+
         static std::string name(token _tok) noexcept;
 
     private:
+        struct lazy_string_literal {
+            parser::shared_string_view body;
+            bool hasEscapes;
+        };
+
         template<typename T>
         explicit token(token_kind _kind, T _data) : m_kind(_kind), m_data(std::move(_data)) {}
 
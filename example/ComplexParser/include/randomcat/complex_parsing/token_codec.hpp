@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "randomcat/complex_parsing/token.hpp"
+
+namespace randomcat::complex_parsing {
+    // Maps tokens to the kind/payload pairs stored by randomcat::parser::token_cache and randomcat::parser::token_buffer
+    struct token_codec {
+        using token_type = token;
+
+        std::uint32_t kind(token const& _token) const noexcept { return static_cast<std::uint32_t>(_token.kind()); }
+
+        bool has_payload(token const& _token) const noexcept { return token::is_identifier(_token) || token::is_string_literal(_token); }
+
+        std::optional<std::string> payload(token const& _token) const {
+            if (token::is_identifier(_token)) return token::identifier_value(_token);
+            if (token::is_string_literal(_token)) return token::string_literal_value(_token);
+
+            return std::nullopt;
+        }
+
+        token make(std::uint32_t _kind, std::optional<std::string_view> _payload) const {
+            auto const kind = static_cast<token_kind>(_kind);
+
+            if (kind == token_kind::identifier) return token::make_identifier(std::string(_payload.value_or("")));
+            if (kind == token_kind::string_literal) return token::make_string_literal(std::string(_payload.value_or("")));
+
+            return token(kind);
+        }
+    };
+}
@@ -1,53 +1,36 @@
 #pragma once
 
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <randomcat/parser/chars/char_source.hpp>
+#include <randomcat/parser/chars/dfa_tokenizer.hpp>
+#include <randomcat/parser/chars/scan.hpp>
 #include <randomcat/parser/chars/tokenizer.hpp>
 
-#include "randomcat/complex_parsing/lift.hpp"
+#include "randomcat/complex_parsing/keywords.hpp"
 #include "randomcat/complex_parsing/token.hpp"
 
 namespace randomcat::complex_parsing {
-    constexpr inline std::string_view identifier_start = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
-    constexpr inline std::string_view identifier_part = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
     constexpr parser::default_priority_type identifier_priority = -1;
 
-    class identifier_token_desc {
-    public:
-        using token_type = token;
-        using char_type = char;
-        using char_traits_type = std::char_traits<char_type>;
-        using string_type = std::basic_string<char_type, char_traits_type>;
-        using string_view_type = std::basic_string_view<char_type, char_traits_type>;
-        using error_type = parser::no_matching_token_t;
-        using parse_result_type = parser::parse_result<token_type, error_type>;
-        using priority_type = parser::default_priority_type;
-
-        template<typename CharSource>
-        parse_result_type parse_first_token(CharSource const& _chars) const noexcept {
-            using source_traits = parser::char_source_traits<CharSource>;
-
-            auto const firstChar = source_traits::peek_char(_chars);
-            if (std::find(begin(identifier_start), end(identifier_start), firstChar) == end(identifier_start))
-                return parser::no_matching_token;
-
-
-            auto inputWrapper = typename source_traits::access_wrapper(_chars);
-
-            string_type value;
-
-            while (true) {
-                auto const c = inputWrapper.read_char();
-                if (std::find(begin(identifier_part), end(identifier_part), c) == end(identifier_part)) break;
-                value += c;
-            }
-
-            auto parsedChars = size(value);
+    constexpr inline std::string_view identifier_pattern = "[A-Za-z_][A-Za-z0-9_]*";
 
-            return {token::make_identifier(std::move(value)), parsedChars};
+    // Keywords are told apart from identifiers by looking the matched identifier up in the keyword perfect hash (see keywords.hpp),
+    // rather than by patterns of their own, which would multiply the states of the tokenizer's automaton
+    struct keyword_identifier_token {
+        token operator()(std::string_view _identifier) const {
+            if (auto const keywordKind = keyword_kind(_identifier)) return token(*keywordKind);
+            return token::make_identifier(std::string(_identifier));
         }
-
-        static constexpr priority_type priority() noexcept { return identifier_priority; }
     };
 
+    // An identifier, or the keyword it spells
+    inline auto keyword_identifier_token_desc() {
+        return parser::make_regex_token_descriptor<token>(std::string(identifier_pattern), identifier_priority, keyword_identifier_token());
+    }
+
     struct invalid_char_t {};
     constexpr inline invalid_char_t invalid_char;
 
@@ -125,8 +108,25 @@ namespace randomcat::complex_parsing {
         }
     }
 
+    // Appends the value of a string literal whose body (the chars between its quotes) string_literal_token_desc accepted to _out
+    inline void append_unescaped_string_literal(std::string_view _body, std::string& _out) {
+        auto body = parser::string_view_char_source(_body);
+
+        while (not body.at_end()) {
+            auto const parseResult = parse_char(body);
+            if (not parseResult) throw std::invalid_argument("Invalid string literal body");
+
+            _out += parseResult.value().character;
+            body.advance_head(parseResult.amount_parsed());
+        }
+    }
+
     constexpr parser::default_priority_type string_literal_priority = -1;
 
+    // A quoted string of chars parse_char accepts. Runs of plain chars are found with one search for the next quote, backslash or
+    // control char (see parser::find_first_of) and copied in one go; only the chars it stops at are looked at one by one.
+    // Sources that can share their chars (see parser::shared_char_source) are not copied out of at all: the token keeps a view of
+    // the body and unescapes it only if its value is asked for.
     class string_literal_token_desc {
     public:
         using token_type = token;
@@ -137,34 +137,54 @@ namespace randomcat::complex_parsing {
         using error_type = parser::no_matching_token_t;
         using parse_result_type = parser::parse_result<token_type, error_type>;
         using priority_type = parser::default_priority_type;
+        using size_type = string_type::size_type;
+
+        static inline constexpr char_type quote_mark = '"';
 
-        static inline constexpr auto quote_char = '\"';
+        // Every char parse_char does not take as is, plus the closing quote; the control chars it does take just stop the search
+        static inline constexpr parser::scan_set body_stops = parser::scan_set("\"\\", ' ');
 
         template<typename CharSource>
         parse_result_type parse_first_token(CharSource const& _chars) const noexcept {
-            typename parser::char_source_traits<CharSource>::access_wrapper accessWrapper(_chars);
+            using traits = parser::char_source_traits<CharSource>;
+            constexpr bool isLazy = traits::__has_share_since;
 
-            if (not accessWrapper.expect(quote_char)) return parser::no_matching_token;
+            typename traits::access_wrapper accessWrapper(_chars);
 
-            if (accessWrapper.at_end()) return parser::no_matching_token;
+            if (not accessWrapper.expect(quote_mark)) return parser::no_matching_token;
 
-            std::string value;
+            string_type value;
+            bool hasEscapes = false;
 
             while (true) {
-                auto parseResult = accessWrapper.sub_parse(LIFT(parse_char));
-                if (not parseResult) return parser::no_matching_token;
+                auto const runSize = accessWrapper.find_first_of(body_stops);
 
-                auto parseValue = parseResult.value();
+                if constexpr (isLazy) {
+                    accessWrapper.advance_head(runSize);
+                } else {
+                    accessWrapper.read_into(value, runSize);
+                }
 
-                accessWrapper.advance_head(parseResult.amount_parsed());
+                if (accessWrapper.at_end()) return parser::no_matching_token;
 
-                if ((not parseValue.isEscape) && parseValue.character == quote_char) {
-                    return {token::make_string_literal(std::move(value)), accessWrapper.chars_parsed()};
+                if (accessWrapper.peek_char() == quote_mark) {
+                    accessWrapper.advance_head(1);
+
+                    if constexpr (isLazy) {
+                        auto const literal = accessWrapper.share_parsed();
+                        return {token::make_lazy_string_literal(literal.substr(1, literal.size() - 2), hasEscapes), accessWrapper.chars_parsed()};
+                    } else {
+                        return {token::make_string_literal(std::move(value)), accessWrapper.chars_parsed()};
+                    }
                 }
 
-                if ((not parseValue.isEscape) && parseValue.character == '\n') { return parser::no_matching_token; }
+                auto const parseResult = accessWrapper.sub_parse([](auto const& _source) { return parse_char(_source); });
+                if (not parseResult) return parser::no_matching_token;
+
+                hasEscapes = hasEscapes || parseResult.value().isEscape;
+                if constexpr (not isLazy) value += parseResult.value().character;
 
-                value += parseValue.character;
+                accessWrapper.advance_head(parseResult.amount_parsed());
             }
         }
 
@@ -188,6 +208,9 @@ namespace randomcat::complex_parsing {
         static inline constexpr char_type introduction = 'R';
         static inline constexpr char_type quote_mark = '"';
 
+        // The end of the delimiter, and the chars it cannot contain
+        static inline constexpr parser::scan_set delimiter_stops = parser::scan_set("( \\");
+
         template<typename CharSource>
         parse_result_type parse_first_token(CharSource const& _chars) const noexcept {
             typename parser::char_source_traits<CharSource>::access_wrapper accessWrapper(_chars);
@@ -196,27 +219,30 @@ namespace randomcat::complex_parsing {
             if (not accessWrapper.expect(quote_mark)) return parser::no_matching_token;
 
             string_type delimiter;
+            accessWrapper.read_into(delimiter, accessWrapper.find_first_of(delimiter_stops));
 
-            {
-                char_type delimChar;
-                while ((not accessWrapper.at_end()) && (delimChar = accessWrapper.read_char()) != '(') {
-                    if (delimChar == ' ' || delimChar == '\\') return parser::no_matching_token;
+            if (not accessWrapper.expect('(')) return parser::no_matching_token;
 
-                    delimiter += delimChar;
-                }
-            }
+            // The body is everything up to the first )delimiter", found with one search and copied in one go
+            string_type const literalEnd = ")" + std::move(delimiter) + quote_mark;
 
-            if (accessWrapper.at_end()) return parser::no_matching_token;
+            if constexpr (parser::char_source_traits<CharSource>::__has_share_since) {
+                // Nothing in a raw string is escaped, so a view of the body is its value
+                auto const bodyStart = accessWrapper.chars_parsed();
+                accessWrapper.advance_head(accessWrapper.find(literalEnd));
+                auto const bodySize = accessWrapper.chars_parsed() - bodyStart;
 
-            string_type literalEnd = ")" + std::move(delimiter) + quote_mark;
-            string_type str;
+                if (not accessWrapper.expect(literalEnd)) return parser::no_matching_token;
 
-            while (not accessWrapper.at_end() && not accessWrapper.next_is(literalEnd)) { str += accessWrapper.read_char(); }
+                return {token::make_lazy_string_literal(accessWrapper.share_parsed().substr(bodyStart, bodySize), false), accessWrapper.chars_parsed()};
+            } else {
+                string_type str;
+                accessWrapper.read_into(str, accessWrapper.find(literalEnd));
 
-            if (accessWrapper.at_end()) return parser::no_matching_token;
-            if (not accessWrapper.expect(literalEnd)) throw std::logic_error("Internal logic error while parsing raw string literal");
+                if (not accessWrapper.expect(literalEnd)) return parser::no_matching_token;
 
-            return {token::make_string_literal(std::move(str)), accessWrapper.chars_parsed()};
+                return {token::make_string_literal(std::move(str)), accessWrapper.chars_parsed()};
+            }
         }
 
         static constexpr priority_type priority() noexcept { return raw_string_literal_priority; }
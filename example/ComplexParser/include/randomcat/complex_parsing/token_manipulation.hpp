@@ -1,81 +1,164 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <randomcat/parser/chars/tokenizer.hpp>
+#include <randomcat/parser/tokens/parallel_filter.hpp>
+#include <randomcat/parser/tokens/token_buffer.hpp>
 
 #include "randomcat/complex_parsing/token.hpp"
 
 namespace randomcat::complex_parsing {
     template<typename ForwardIt>
     ForwardIt strip_comments(ForwardIt _begin, ForwardIt _end) noexcept {
-        bool inLineComment = false;
-        bool inMultiLineComment = false;
-
-        return std::remove_if(_begin, _end, [&](auto const& token) {
-            if (inMultiLineComment) {
-                if (token.kind() == token_kind::multiline_comment_end) inMultiLineComment = false;
+        return std::remove_if(_begin, _end, [](auto const& token) {
+            return token.kind() == token_kind::line_comment || token.kind() == token_kind::multiline_comment;
+        });
+    }
 
-                return true;
+    // Removes every token from one of kind _firstStrip up to and including the next one of kind _lastStrip (or to the end), like
+    // strip_from_kind_to_kind_token_stream
+    template<typename ForwardIt>
+    ForwardIt strip_from_kind_to_kind(ForwardIt _begin, ForwardIt _end, token_kind _firstStrip, token_kind _lastStrip) {
+        auto out = _begin;
+        bool inRegion = false;
+
+        for (; _begin != _end; ++_begin) {
+            if (inRegion) {
+                inRegion = _begin->kind() != _lastStrip;
+            } else if (_begin->kind() == _firstStrip) {
+                inRegion = true;
+            } else {
+                if (out != _begin) *out = std::move(*_begin);
+                ++out;
             }
+        }
 
-            if (inLineComment) {
-                if (token.kind() == token_kind::line_comment_end) inLineComment = false;
+        return out;
+    }
 
-                return true;
+    namespace manipulation_detail {
+        struct strip_comments_step {
+            parser::state_filter_step operator()(std::size_t, token const& _token) const noexcept {
+                return {0, _token.kind() != token_kind::line_comment && _token.kind() != token_kind::multiline_comment};
             }
+        };
 
-            if (token.kind() == token_kind::line_comment_begin) {
-                inLineComment = true;
-                return true;
-            }
+        // State 1 is inside a region
+        struct strip_from_kind_to_kind_step {
+            token_kind firstStrip;
+            token_kind lastStrip;
 
-            if (token.kind() == token_kind::multiline_comment_begin) {
-                inMultiLineComment = true;
-                return true;
+            parser::state_filter_step operator()(std::size_t _state, token const& _token) const noexcept {
+                if (_state == 1) return {_token.kind() == lastStrip ? 0u : 1u, false};
+                if (_token.kind() == firstStrip) return {1, false};
+                return {0, true};
             }
+        };
+    }    // namespace manipulation_detail
 
-            return false;
-        });
+    // The tokens strip_comments would keep, filtered on several threads for huge inputs (see parser::parallel_state_filter)
+    inline std::vector<token> parallel_strip_comments(std::vector<token> const& _tokens, parser::parallel_filter_options const& _options = {}) {
+        return parser::parallel_state_filter<1>(_tokens, manipulation_detail::strip_comments_step(), 0, _options);
+    }
+
+    // The tokens strip_from_kind_to_kind would keep, filtered on several threads for huge inputs. Whether a block starts inside a
+    // region depends on every block before it, which is resolved from a summary of each block under both start states.
+    inline std::vector<token> parallel_strip_from_kind_to_kind(std::vector<token> const& _tokens,
+                                                               token_kind _firstStrip,
+                                                               token_kind _lastStrip,
+                                                               parser::parallel_filter_options const& _options = {}) {
+        return parser::parallel_state_filter<2>(_tokens, manipulation_detail::strip_from_kind_to_kind_step{_firstStrip, _lastStrip}, 0, _options);
     }
 
+    // Replaces each pair of consecutive elements that _match with _combine(first, second), compacting the range in the same pass.
+    // Pairs do not overlap: an element that was combined is not matched against the next one. Returns the new end.
     template<typename ForwardIt, typename Match, typename Combine>
     ForwardIt combine_consecutive_elements(ForwardIt _begin, ForwardIt _end, Match&& _match, Combine&& _combine) {
-        if (std::distance(_begin, _end) == 0) return _end;
+        auto out = _begin;
 
-        auto sentinel = static_cast<token_kind>(std::numeric_limits<std::underlying_type_t<token_kind>>::max());
+        while (_begin != _end) {
+            auto const next = std::next(_begin);
 
-        for (; std::next(_begin, 1) != _end; std::advance(_begin, 1)) {
-            auto firstIt = _begin;
-            auto secondIt = std::next(firstIt, 1);
+            if (next != _end && _match(*_begin, *next)) {
+                *out = _combine(*_begin, *next);
+                _begin = std::next(next);
+            } else {
+                if (out != _begin) *out = std::move(*_begin);
+                _begin = next;
+            }
 
-            if (std::forward<Match>(_match)(*firstIt, *secondIt)) {
-                (*firstIt) = std::forward<Combine>(_combine)(*firstIt, *secondIt);
-                (*secondIt) = token(sentinel);
+            ++out;
+        }
+
+        return out;
+    }
+
+    // Replaces each maximal run of two or more consecutive elements that are _inRun with _combine(runBegin, runEnd), compacting the
+    // range in the same pass, so every element is visited once however long the runs are. Returns the new end.
+    template<typename ForwardIt, typename InRun, typename Combine>
+    ForwardIt combine_runs(ForwardIt _begin, ForwardIt _end, InRun&& _inRun, Combine&& _combine) {
+        auto out = _begin;
+
+        while (_begin != _end) {
+            auto runEnd = std::next(_begin);
+
+            if (_inRun(*_begin)) {
+                while (runEnd != _end && _inRun(*runEnd)) ++runEnd;
             }
+
+            if (runEnd != std::next(_begin)) {
+                *out = _combine(_begin, runEnd);
+            } else if (out != _begin) {
+                *out = std::move(*_begin);
+            }
+
+            ++out;
+            _begin = runEnd;
         }
 
-        return std::remove_if(_begin, _end, [&](auto const& tok) { return tok.kind() == sentinel; });
+        return out;
     }
 
+    inline constexpr parser::token_kind_set comment_and_whitespace_kinds = {static_cast<std::uint32_t>(token_kind::whitespace),
+                                                                            static_cast<std::uint32_t>(token_kind::newline),
+                                                                            static_cast<std::uint32_t>(token_kind::line_comment),
+                                                                            static_cast<std::uint32_t>(token_kind::multiline_comment)};
+
     template<typename ForwardIt>
     ForwardIt strip_comments_and_whitespace(ForwardIt _begin, ForwardIt _end) noexcept {
-        _end = strip_comments(_begin, _end);
-        _end = std::remove_if(_begin, _end, [](auto const& token) { return token.kind() == token_kind::whitespace; });
-        _end = std::remove_if(_begin, _end, [](auto const& token) { return token.kind() == token_kind::newline; });
+        return std::remove_if(_begin, _end, [](auto const& token) {
+            return comment_and_whitespace_kinds.contains(static_cast<std::uint8_t>(token.kind()));
+        });
+    }
 
-        return _end;
+    // Compacts every column of _tokens in one pass, checking a block of kinds at a time
+    template<typename Codec>
+    void strip_comments_and_whitespace(parser::token_buffer<Codec>& _tokens) {
+        _tokens.erase(comment_and_whitespace_kinds);
     }
 
+    // Concatenates every run of adjacent string literals into one, allocating its value once
     template<typename ForwardIt>
     ForwardIt combine_string_literals(ForwardIt _begin, ForwardIt _end) noexcept {
-        return combine_consecutive_elements(_begin,
-                                            _end,
-                                            [](auto const& first, auto const& second) {
-                                                return token::is_string_literal(first) && token::is_string_literal(second);
-                                            },
-                                            [](auto const& first, auto const& second) {
-                                                return token::make_string_literal(token::string_literal_value(first) + token::string_literal_value(second));
-                                            });
+        return combine_runs(_begin,
+                            _end,
+                            [](auto const& tok) { return token::is_string_literal(tok); },
+                            [](ForwardIt runBegin, ForwardIt runEnd) {
+                                std::size_t maxSize = 0;
+                                for (auto it = runBegin; it != runEnd; ++it) maxSize += token::max_string_literal_size(*it);
+
+                                std::string value;
+                                value.reserve(maxSize);
+                                for (auto it = runBegin; it != runEnd; ++it) token::append_string_literal_value(*it, value);
+
+                                return token::make_string_literal(std::move(value));
+                            });
     }
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <randomcat/parser/tokens/token_stream/token_stream.hpp>
+
+#include "randomcat/complex_parsing/token.hpp"
+
+namespace randomcat::complex_parsing {
+    template<typename TokenStream>
+    auto strip_token_kind_token_stream(TokenStream _from, token_kind _kindToStrip) {
+        return parser::transform_token_stream(std::move(_from), [=](auto&& read, auto&& peek, auto&& at_end, auto&& emit) {
+            auto token = read();
+            if (token.kind() != _kindToStrip) emit(std::move(token));
+        });
+    }
+
+    template<typename TokenStream>
+    auto strip_from_kind_to_kind_token_stream(TokenStream _from, token_kind _firstStrip, token_kind _lastStrip) {
+        return parser::transform_token_stream(std::move(_from), [=](auto&& read, auto&& peek, auto&& at_end, auto&& emit) {
+            auto token = read();
+            if (token.kind() == _firstStrip) {
+                while (not at_end() && read().kind() != _lastStrip) {}
+            } else {
+                emit(std::move(token));
+            }
+        });
+    }
+
+    template<typename TokenStream>
+    auto strip_multiline_comments_token_stream(TokenStream _from) {
+        return complex_parsing::strip_token_kind_token_stream(std::move(_from), token_kind::multiline_comment);
+    }
+
+    template<typename TokenStream>
+    auto strip_line_comments_token_stream(TokenStream _from) {
+        return complex_parsing::strip_token_kind_token_stream(std::move(_from), token_kind::line_comment);
+    }
+
+    // The tokenizer lexes each comment as a single token, so this only has to drop those
+    template<typename TokenStream>
+    auto strip_comments_token_stream(TokenStream _from) {
+        return parser::transform_token_stream(std::move(_from), [](auto&& read, auto&& peek, auto&& at_end, auto&& emit) {
+            auto token = read();
+            if (token.kind() != token_kind::line_comment && token.kind() != token_kind::multiline_comment) emit(std::move(token));
+        });
+    }
+
+    template<typename TokenStream>
+    auto strip_whitespace_token_stream(TokenStream _from) {
+        return complex_parsing::strip_token_kind_token_stream(complex_parsing::strip_token_kind_token_stream(std::move(_from), token_kind::whitespace),
+                                                              token_kind::newline);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+
+#include <randomcat/parser/chars/dfa_tokenizer.hpp>
+#include <randomcat/parser/chars/tokenizer.hpp>
+
+#include "randomcat/complex_parsing/token.hpp"
+#include "randomcat/complex_parsing/token_descriptors.hpp"
+
+namespace randomcat::complex_parsing {
+    // Everything but comments, string literals and invalid tokens is compiled into one automaton, see dfa_tokenizer
+    inline auto make_tokenizer() {
+        return parser::make_dfa_tokenizer<token>(parser::simple_token_descriptor(token(token_kind::colon_colon), "::"),
+                                                 parser::simple_token_descriptor(token(token_kind::lparen), "("),
+                                                 parser::simple_token_descriptor(token(token_kind::rparen), ")"),
+                                                 parser::simple_token_descriptor(token(token_kind::colon), ":"),
+                                                 parser::simple_token_descriptor(token(token_kind::carat), "^"),
+                                                 parser::simple_token_descriptor(token(token_kind::plus), "+"),
+                                                 parser::simple_token_descriptor(token(token_kind::plus_plus), "++"),
+                                                 parser::simple_token_descriptor(token(token_kind::minus), "-"),
+                                                 parser::simple_token_descriptor(token(token_kind::minus_minus), "--"),
+                                                 parser::simple_token_descriptor(token(token_kind::semicolon), ";"),
+                                                 parser::simple_token_descriptor(token(token_kind::slash), "/"),
+                                                 // Comment bodies are skipped in one scan rather than lexed; a line comment leaves its newline
+                                                 parser::delimited_token_descriptor(token(token_kind::line_comment), "//", "\n", parser::closing_delimiter::left),
+                                                 parser::delimited_token_descriptor(token(token_kind::multiline_comment), "/*", "*/"),
+                                                 parser::simple_token_descriptor(token(token_kind::star_slash), "*/"),
+                                                 parser::simple_token_descriptor(token(token_kind::star), "*"),
+                                                 parser::simple_token_descriptor(token(token_kind::ampersand), "&"),
+                                                 parser::simple_token_descriptor(token(token_kind::ampersand_ampersand), "&&"),
+                                                 parser::simple_token_descriptor(token(token_kind::pipe), "|"),
+                                                 parser::simple_token_descriptor(token(token_kind::tilde), "~"),
+                                                 parser::simple_token_descriptor(token(token_kind::percentage), "%"),
+                                                 parser::simple_token_descriptor(token(token_kind::pipe_pipe), "||"),
+                                                 parser::simple_token_descriptor(token(token_kind::question_mark), "?"),
+                                                 parser::simple_token_descriptor(token(token_kind::backslash), "\\"),
+                                                 parser::simple_token_descriptor(token(token_kind::period), "."),
+                                                 parser::make_multi_form_token_descriptor(token(token_kind::whitespace), 1, " ", "\t"),
+                                                 parser::make_multi_form_token_descriptor(token(token_kind::newline), 1, "\n", "\r"),
+                                                 keyword_identifier_token_desc(),
+                                                 string_literal_token_desc(),
+                                                 raw_string_literal_token_desc(),
+                                                 invalid_token_desc());
+    }
+}
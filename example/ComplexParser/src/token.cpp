@@ -3,6 +3,8 @@
 #include <string>
 #include <string_view>
 
+#include "randomcat/complex_parsing/token_descriptors.hpp"
+
 namespace randomcat::complex_parsing {
     std::string token::name(token _tok) noexcept {
         using namespace std::string_literals;
@@ -147,6 +149,16 @@ namespace randomcat::complex_parsing {
                 break;
             }
 
+            case token_kind::line_comment: {
+                return "line_comment"s;
+                break;
+            }
+
+            case token_kind::multiline_comment: {
+                return "multiline_comment"s;
+                break;
+            }
+
             case token_kind::string_literal: {
                 return "string literal: " + string_literal_value(_tok);
                 break;
@@ -194,5 +206,33 @@ namespace randomcat::complex_parsing {
         return token(token_kind::string_literal, std::move(_value));
     }
 
-    std::string token::string_literal_value(token const& _tok) noexcept { return _tok.data<std::string>(); }
+    token token::make_lazy_string_literal(parser::shared_string_view _body, bool _hasEscapes) noexcept {
+        return token(token_kind::string_literal, lazy_string_literal{std::move(_body), _hasEscapes});
+    }
+
+    std::string token::string_literal_value(token const& _tok) noexcept {
+        std::string value;
+        append_string_literal_value(_tok, value);
+        return value;
+    }
+
+    void token::append_string_literal_value(token const& _tok, std::string& _out) noexcept {
+        if (auto const* lazy = std::any_cast<lazy_string_literal>(&_tok.m_data)) {
+            if (lazy->hasEscapes) {
+                append_unescaped_string_literal(lazy->body, _out);
+            } else {
+                _out += lazy->body.view();
+            }
+
+            return;
+        }
+
+        _out += *std::any_cast<std::string>(&_tok.m_data);
+    }
+
+    std::size_t token::max_string_literal_size(token const& _tok) noexcept {
+        // Unescaping only ever shortens the body
+        if (auto const* lazy = std::any_cast<lazy_string_literal>(&_tok.m_data)) return lazy->body.size();
+        return std::any_cast<std::string>(&_tok.m_data)->size();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "randomcat/simple_parsing/token.hpp"
+
+namespace randomcat::simple_parsing {
+    using pending_variable_list = std::vector<variable_kind>;
+
+    namespace {
+        pending_variable_list const empty_pending_variable_list;
+    }
+
+    template<typename... Ts, typename = std::enable_if_t<(std::is_same_v<Ts, pending_variable_list> && ...)>>
+    inline pending_variable_list merge_pending_variables(Ts const&... _lists) {
+        pending_variable_list totalList = {};
+
+        (std::invoke([&](auto const& list) { totalList.insert(end(totalList), begin(list), end(list)); }, _lists), ...);
+
+        return totalList;
+    }
+
+    class expression {
+    public:
+        using number_type = long double;
+
+        expression(expression const&) = delete;
+        expression(expression&&) = delete;
+        expression& operator=(expression const&) & = delete;
+        expression& operator=(expression&&) & = delete;
+
+        virtual std::unique_ptr<expression> copy() const = 0;
+
+        virtual number_type eval() const = 0;
+
+        virtual pending_variable_list pending_variables() const noexcept = 0;
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept = 0;
+
+        virtual ~expression() noexcept = default;
+
+    protected:
+        explicit expression() noexcept = default;
+    };
+
+    class add_expression final : public expression {
+    public:
+        explicit add_expression(expression const& _left, expression const& _right) : m_left(_left.copy()), m_right(_right.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<add_expression>(*m_left, *m_right); }
+
+        number_type eval() const final { return m_left->eval() + m_right->eval(); }
+
+        virtual pending_variable_list pending_variables() const noexcept override {
+            return merge_pending_variables(m_left->pending_variables(), m_right->pending_variables());
+        }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_left->substitute_variable(_var, _value);
+            m_right->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_left;
+        std::unique_ptr<expression> m_right;
+    };
+
+    class subtract_expression final : public expression {
+    public:
+        explicit subtract_expression(expression const& _left, expression const& _right) : m_left(_left.copy()), m_right(_right.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<subtract_expression>(*m_left, *m_right); }
+
+        number_type eval() const final { return m_left->eval() - m_right->eval(); }
+
+        virtual pending_variable_list pending_variables() const noexcept override {
+            return merge_pending_variables(m_left->pending_variables(), m_right->pending_variables());
+        }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_left->substitute_variable(_var, _value);
+            m_right->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_left;
+        std::unique_ptr<expression> m_right;
+    };
+
+    class divide_expression final : public expression {
+    public:
+        explicit divide_expression(expression const& _left, expression const& _right) : m_left(_left.copy()), m_right(_right.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<divide_expression>(*m_left, *m_right); }
+
+        number_type eval() const final { return m_left->eval() / m_right->eval(); }
+
+        virtual pending_variable_list pending_variables() const noexcept override {
+            return merge_pending_variables(m_left->pending_variables(), m_right->pending_variables());
+        }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_left->substitute_variable(_var, _value);
+            m_right->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_left;
+        std::unique_ptr<expression> m_right;
+    };
+
+    class multiply_expression final : public expression {
+    public:
+        explicit multiply_expression(expression const& _left, expression const& _right) : m_left(_left.copy()), m_right(_right.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<multiply_expression>(*m_left, *m_right); }
+
+        number_type eval() const final { return m_left->eval() * m_right->eval(); }
+
+        virtual pending_variable_list pending_variables() const noexcept override {
+            return merge_pending_variables(m_left->pending_variables(), m_right->pending_variables());
+        }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_left->substitute_variable(_var, _value);
+            m_right->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_left;
+        std::unique_ptr<expression> m_right;
+    };
+
+    class unary_minus_expression final : public expression {
+    public:
+        explicit unary_minus_expression(expression const& _value) : m_value(_value.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<unary_minus_expression>(*m_value); }
+
+        number_type eval() const final { return -(m_value->eval()); }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return m_value->pending_variables(); }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_value->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_value;
+    };
+
+    class integer_literal_expression final : public expression {
+    public:
+        explicit integer_literal_expression(number_type _value) : m_value(std::move(_value)) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<integer_literal_expression>(m_value); }
+
+        number_type eval() const final { return m_value; }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return empty_pending_variable_list; }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {}
+
+    private:
+        number_type m_value;
+    };
+
+    class floating_literal_expression final : public expression {
+    public:
+        explicit floating_literal_expression(number_type _value) : m_value(std::move(_value)) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<floating_literal_expression>(m_value); }
+
+        number_type eval() const final { return m_value; }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return empty_pending_variable_list; }
+
+        virtual void substitute_variable(variable_kind, number_type) noexcept override {}
+
+    private:
+        number_type m_value;
+    };
+
+    class pi_literal_expression final : public expression {
+    public:
+        explicit pi_literal_expression() {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<pi_literal_expression>(); }
+
+        number_type eval() const final { return number_type{1068966896} / number_type{340262731}; }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return empty_pending_variable_list; }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {}
+    };
+
+    class sin_expression final : public expression {
+    public:
+        explicit sin_expression(expression const& _arg) : m_argument(_arg.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<sin_expression>(*m_argument); }
+
+        number_type eval() const final { return std::sin(m_argument->eval()); }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return m_argument->pending_variables(); }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_argument->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_argument;
+    };
+
+    class cos_expression final : public expression {
+    public:
+        explicit cos_expression(expression const& _arg) : m_argument(_arg.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<cos_expression>(*m_argument); }
+
+        number_type eval() const final { return std::cos(m_argument->eval()); }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return m_argument->pending_variables(); }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_argument->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_argument;
+    };
+
+    class tan_expression final : public expression {
+    public:
+        explicit tan_expression(expression const& _arg) : m_argument(_arg.copy()) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<tan_expression>(*m_argument); }
+
+        number_type eval() const final { return std::tan(m_argument->eval()); }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return m_argument->pending_variables(); }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            m_argument->substitute_variable(_var, _value);
+        }
+
+    private:
+        std::unique_ptr<expression> m_argument;
+    };
+
+    class bad_variable_exception : public std::exception {
+    public:
+        explicit bad_variable_exception(variable_kind _var) : m_value(std::string("Bad access to variable: ") + variable_name(_var)) {}
+
+        virtual char const* what() const noexcept override { return m_value.c_str(); }
+
+    private:
+        std::string m_value;
+    };
+
+    class variable_expression final : public expression {
+    public:
+        explicit variable_expression(variable_kind _var) : m_var{std::move(_var)}, m_value(std::nullopt) {}
+
+        std::unique_ptr<expression> copy() const final { return std::make_unique<variable_expression>(m_var); }
+
+        number_type eval() const final {
+            if (not m_value.has_value()) throw bad_variable_exception(m_var);
+
+            return *m_value;
+        }
+
+        virtual pending_variable_list pending_variables() const noexcept override { return {m_var}; }
+
+        virtual void substitute_variable(variable_kind _var, number_type _value) noexcept override {
+            if (_var == m_var) m_value = std::move(_value);
+        }
+
+    private:
+        variable_kind m_var;
+        std::optional<number_type> m_value;
+    };
+
+    class wrap_expression {
+    public:
+        wrap_expression(wrap_expression const& _other) : m_value(_other.raw().copy()) {}
+        
+        wrap_expression& operator=(wrap_expression _other) {
+            swap(*this, _other);
+            return *this;
+        }
+        
+        wrap_expression(expression const& _value) : m_value(_value.copy()) {}
+
+        using number_type = expression::number_type;
+
+        [[nodiscard]] expression const& raw() const noexcept { return *m_value; }
+
+        [[nodiscard]] number_type eval() const { return raw().eval(); }
+
+        /* implicit */ operator expression const&() const noexcept { return raw(); }
+
+        [[nodiscard]] decltype(auto) pending_variables() const noexcept { return raw().pending_variables(); }
+
+        void substitute_variable(variable_kind _var, number_type _value) noexcept { mutable_raw().substitute_variable(_var, _value); }
+
+    private:
+        expression& mutable_raw() noexcept { return *m_value; }
+        
+        friend void swap(wrap_expression& _first, wrap_expression& _second) {
+            using std::swap;
+            swap(_first.m_value, _second.m_value);
+        }
+        
+        std::unique_ptr<expression> m_value;
+    };
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <utility>
+
+#include <randomcat/parser/grammar/grammar_terms.hpp>
+
+#include "randomcat/simple_parsing/expression.hpp"
+#include "randomcat/simple_parsing/lift.hpp"
+#include "randomcat/simple_parsing/token.hpp"
+
+namespace randomcat::simple_parsing {
+    inline auto token_kind_grammar(token_kind _kind) {
+        return parser::single_token_grammar([=](token const& tok) { return tok.kind() == _kind; });
+    }
+
+    // Tags naming the rules in grammar profiles
+    namespace rules {
+        struct primary_expression {
+            static constexpr auto name = "primary_expression";
+        };
+
+        struct parenthesised_expression {
+            static constexpr auto name = "parenthesised_expression";
+        };
+
+        struct unary_minus_expression {
+            static constexpr auto name = "unary_minus_expression";
+        };
+
+        struct integer_literal_expression {
+            static constexpr auto name = "integer_literal_expression";
+        };
+
+        struct floating_literal_expression {
+            static constexpr auto name = "floating_literal_expression";
+        };
+
+        struct pi_literal_expression {
+            static constexpr auto name = "pi_literal_expression";
+        };
+
+        struct function_expression {
+            static constexpr auto name = "function_expression";
+        };
+
+        struct variable_expression {
+            static constexpr auto name = "variable_expression";
+        };
+
+        struct times_expression {
+            static constexpr auto name = "times_expression";
+        };
+
+        struct plus_expression {
+            static constexpr auto name = "plus_expression";
+        };
+    }    // namespace rules
+
+    struct invalid_expression_t {};
+    inline constexpr invalid_expression_t invalid_expression;
+
+    class expression_grammar : parser::grammar_base {
+    public:
+        explicit expression_grammar() noexcept = default;
+
+        template<typename TokenStream>
+        struct traits_for {
+            using value_type = wrap_expression;
+            using error_type = invalid_expression_t;
+            using result_type = parser::parse_result<value_type, error_type>;
+        };
+
+        template<typename TokenStream>
+        typename traits_for<TokenStream>::result_type test(TokenStream const& _tokenStream) const;
+    };
+
+    class primary_expression_grammar : parser::grammar_base {
+    public:
+        explicit primary_expression_grammar() noexcept = default;
+
+        template<typename TokenStream>
+        struct traits_for {
+            using value_type = wrap_expression;
+            using error_type = invalid_expression_t;
+            using result_type = parser::parse_result<value_type, error_type>;
+        };
+
+        template<typename TokenStream>
+        typename traits_for<TokenStream>::result_type test(TokenStream const& _tokenStream) const;
+    };
+
+    inline auto parenthesised_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::sequence_grammar(token_kind_grammar(token_kind::lparen), expression_grammar(), token_kind_grammar(token_kind::rparen)),
+                                    [](auto&& _value) { return parser::get<1>(std::forward<decltype(_value)>(_value)); });
+        return parser::tag_grammar<rules::parenthesised_expression>(std::move(grammar));
+    }
+
+    inline auto unary_minus_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::sequence_grammar(token_kind_grammar(token_kind::minus), primary_expression_grammar()), [](auto&& _value) {
+            return wrap_expression(unary_minus_expression(parser::get<1>(std::forward<decltype(_value)>(_value))));
+        });
+        return parser::tag_grammar<rules::unary_minus_expression>(std::move(grammar));
+    }
+
+    inline auto integer_literal_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::single_token_grammar([](token const& tok) { return token::is_integer_literal(tok); }), [](token const& tok) {
+            return wrap_expression(integer_literal_expression(token::integer_literal_value(tok)));
+        });
+        return parser::tag_grammar<rules::integer_literal_expression>(std::move(grammar));
+    }
+
+    inline auto floating_literal_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::single_token_grammar([](token const& tok) { return token::is_floating_literal(tok); }), [](token const& tok) {
+            return wrap_expression(floating_literal_expression(token::floating_literal_value(tok)));
+        });
+        return parser::tag_grammar<rules::floating_literal_expression>(std::move(grammar));
+    }
+
+    inline auto pi_literal_expression_grammar() {
+        auto grammar = parser::map_value_grammar(token_kind_grammar(token_kind::kw_pi), [](auto&&) { return wrap_expression(pi_literal_expression()); });
+        return parser::tag_grammar<rules::pi_literal_expression>(std::move(grammar));
+    }
+
+    inline auto function_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::selection_grammar(parser::map_value_grammar(parser::sequence_grammar(token_kind_grammar(token_kind::kw_sin),
+                                                                                                  parenthesised_expression_grammar()),
+                                                                              [](auto const& seq) {
+                                                                                  return wrap_expression(sin_expression(parser::get<1>(seq)));
+                                                                              }),
+                                                         parser::map_value_grammar(parser::sequence_grammar(token_kind_grammar(token_kind::kw_cos),
+                                                                                                  parenthesised_expression_grammar()),
+                                                                              [](auto const& seq) {
+                                                                                  return wrap_expression(cos_expression(parser::get<1>(seq)));
+                                                                              }),
+                                                         parser::map_value_grammar(parser::sequence_grammar(token_kind_grammar(token_kind::kw_tan),
+                                                                                                  parenthesised_expression_grammar()),
+                                                                              [](auto const& seq) {
+                                                                                  return wrap_expression(tan_expression(parser::get<1>(seq)));
+                                                                              })),
+                                    [](auto const& variant) {
+                                        return parser::visit([](expression const& exp) { return wrap_expression(exp); }, variant);
+                                    });
+        return parser::tag_grammar<rules::function_expression>(std::move(grammar));
+    }
+
+    inline auto variable_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::single_token_grammar([](token const& _tok) { return token::is_variable(_tok); }),
+                                    [](auto const& _tok) { return wrap_expression(variable_expression(token::variable_value(_tok))); });
+        return parser::tag_grammar<rules::variable_expression>(std::move(grammar));
+    }
+
+    template<typename Tree>
+    inline auto times_expression_tree_to_expression(Tree const& _tree) -> wrap_expression {
+        if (not _tree.has_left()) return _tree.right();
+
+        auto separator = parser::visit([](token const& _token) { return _token; }, _tree.left_separator());
+        switch (separator.kind()) {
+            case token_kind::slash: return divide_expression(times_expression_tree_to_expression(_tree.left_tree()), _tree.right());
+            case token_kind::star: return multiply_expression(times_expression_tree_to_expression(_tree.left_tree()), _tree.right());
+            case token_kind::floating_literal: break;
+        }
+
+        __builtin_unreachable();
+    }
+
+    template<typename Tree>
+    inline auto plus_expression_tree_to_expression(Tree const& _tree) -> wrap_expression {
+        if (not _tree.has_left()) return _tree.right();
+
+        auto separator = parser::visit([](token const& _token) { return _token; }, _tree.left_separator());
+        switch (separator.kind()) {
+            case token_kind::plus: return add_expression(plus_expression_tree_to_expression(_tree.left_tree()), _tree.right());
+            case token_kind::minus: return subtract_expression(plus_expression_tree_to_expression(_tree.left_tree()), _tree.right());
+            case token_kind::floating_literal: break;
+        }
+
+        __builtin_unreachable();
+    }
+
+
+    inline auto times_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::left_recursive_grammar(primary_expression_grammar(),
+                                                              parser::selection_grammar(token_kind_grammar(token_kind::star),
+                                                                                   token_kind_grammar(token_kind::slash))),
+                                    LIFT(times_expression_tree_to_expression));
+        return parser::tag_grammar<rules::times_expression>(std::move(grammar));
+    }
+
+    inline auto plus_expression_grammar() {
+        auto grammar = parser::map_value_grammar(parser::left_recursive_grammar(times_expression_grammar(),
+                                                              parser::selection_grammar(token_kind_grammar(token_kind::plus),
+                                                                                   token_kind_grammar(token_kind::minus))),
+                                    LIFT(plus_expression_tree_to_expression));
+        return parser::tag_grammar<rules::plus_expression>(std::move(grammar));
+    }
+
+    template<typename TokenStream>
+    typename primary_expression_grammar::traits_for<TokenStream>::result_type primary_expression_grammar::test(TokenStream const& _tokenStream) const {
+        auto grammar = parser::map_value_grammar(parser::selection_grammar(parenthesised_expression_grammar(),
+                                                                                unary_minus_expression_grammar(),
+                                                                                integer_literal_expression_grammar(),
+                                                                                floating_literal_expression_grammar(),
+                                                                                pi_literal_expression_grammar(),
+                                                                                function_expression_grammar(),
+                                                                                variable_expression_grammar()),
+                                                           [](auto const& variant) {
+                                                               return parser::visit([](wrap_expression exp) { return exp; }, variant);
+                                                           });
+
+        auto result = parser::grammar_test(parser::tag_grammar<rules::primary_expression>(std::move(grammar)), _tokenStream);
+        if (result.is_error()) return invalid_expression;
+
+        auto amountParsed = result.amount_parsed();
+        return {std::move(result).value(), amountParsed};
+    }
+
+    template<typename TokenStream>
+    typename expression_grammar::traits_for<TokenStream>::result_type expression_grammar::test(TokenStream const& _tokenStream) const {
+        auto result = parser::grammar_test(plus_expression_grammar(), _tokenStream);
+
+        if (result.is_error()) return invalid_expression;
+
+        auto amountParsed = result.amount_parsed();
+        return {wrap_expression(std::move(result).value()), std::move(amountParsed)};
+    }
+}
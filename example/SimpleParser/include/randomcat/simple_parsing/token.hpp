@@ -12,6 +12,7 @@ namespace randomcat::simple_parsing {
         whitespace,
 
         integer_literal,
+        floating_literal,
         variable,
 
         lparen,
@@ -52,6 +53,7 @@ namespace randomcat::simple_parsing {
         using string_view_type = std::basic_string_view<char_type, char_traits_type>;
 
         using integer_literal_value_type = std::uintmax_t;
+        using floating_literal_value_type = double;
 
         explicit token(token_kind _kind) noexcept : m_kind(std::move(_kind)) {}
 
@@ -64,6 +66,10 @@ namespace randomcat::simple_parsing {
         static token make_integer_literal(integer_literal_value_type _value) noexcept;
         static bool is_integer_literal(token const& _tok) noexcept;
         static integer_literal_value_type integer_literal_value(token const& _tok) noexcept;
+
+        static token make_floating_literal(floating_literal_value_type _value) noexcept;
+        static bool is_floating_literal(token const& _tok) noexcept;
+        static floating_literal_value_type floating_literal_value(token const& _tok) noexcept;
         
         static token make_variable(variable_kind _var) noexcept;
         static bool is_variable(token const& _tok) noexcept;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <randomcat/parser/chars/numeric_literal.hpp>
 #include <randomcat/parser/chars/tokenizer.hpp>
 
 #include "randomcat/simple_parsing/lift.hpp"
@@ -26,4 +27,14 @@ namespace randomcat::simple_parsing {
 
         static constexpr priority_type priority() noexcept { return invalid_token_priority; }
     };
-}
\ No newline at end of file
+
+    struct numeric_literal_token {
+        token operator()(parser::numeric_literal const& _literal) const noexcept {
+            if (_literal.kind == parser::numeric_literal::kind_type::floating) return token::make_floating_literal(_literal.floating);
+            return token::make_integer_literal(_literal.integer);
+        }
+    };
+
+    // Integers (decimal or 0x hexadecimal) and decimal fractions with optional exponents, with ' between digits allowed
+    inline auto numeric_literal_token_desc() { return parser::make_numeric_literal_token_descriptor<token>(numeric_literal_token()); }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <randomcat/parser/tokens/token_stream/token_stream.hpp>
+
+#include "randomcat/simple_parsing/token.hpp"
+
+namespace randomcat::simple_parsing {
+    template<typename TokenStream, typename Stats = parser::no_stats>
+    auto strip_token_kind_token_stream(TokenStream _from, token_kind _kindToStrip, Stats _stats = {}) {
+        auto transform = [=](auto&& read, auto&& peek, auto&& at_end, auto&& emit) {
+            auto token = read();
+            if (token.kind() != _kindToStrip) emit(std::move(token));
+        };
+
+        return parser::transform_token_stream(std::move(_from), std::move(transform), std::move(_stats));
+    }
+
+    template<typename TokenStream, typename Stats = parser::no_stats>
+    auto strip_whitespace_token_stream(TokenStream _from, Stats _stats = {}) {
+        return simple_parsing::strip_token_kind_token_stream(std::move(_from), token_kind::whitespace, std::move(_stats));
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+#include <randomcat/parser/chars/tokenizer.hpp>
+
+#include "randomcat/simple_parsing/token.hpp"
+#include "randomcat/simple_parsing/token_descriptors.hpp"
+
+namespace randomcat::simple_parsing {
+    inline auto keyword_parser(token_kind _kw, std::string _value) { return parser::simple_token_descriptor(token(_kw), std::move(_value)); }
+
+    inline auto make_tokenizer() {
+        return parser::make_simple_tokenizer<token>(parser::simple_token_descriptor(token(token_kind::lparen), "("),
+                                                    parser::simple_token_descriptor(token(token_kind::rparen), ")"),
+                                                    parser::simple_token_descriptor(token(token_kind::plus), "+"),
+                                                    parser::simple_token_descriptor(token(token_kind::minus), "-"),
+                                                    parser::simple_token_descriptor(token(token_kind::slash), "/"),
+                                                    parser::simple_token_descriptor(token(token_kind::star), "*"),
+                                                    parser::make_multi_form_token_descriptor(token(token_kind::whitespace), 1, " ", "\t", "\n", "\r"),
+                                                    parser::simple_token_descriptor(token(token_kind::kw_sin), "sin"),
+                                                    parser::simple_token_descriptor(token(token_kind::kw_cos), "cos"),
+                                                    parser::simple_token_descriptor(token(token_kind::kw_tan), "tan"),
+                                                    parser::simple_token_descriptor(token(token_kind::kw_pi), "pi"),
+                                                    parser::simple_token_descriptor(token::make_variable(variable_kind::theta), "theta"),
+                                                    parser::simple_token_descriptor(token::make_variable(variable_kind::theta_prime), "omega"),
+                                                    parser::simple_token_descriptor(token::make_variable(variable_kind::error), "e"),
+                                                    numeric_literal_token_desc(),
+                                                    invalid_token_desc());
+    }
+}
@@ -65,6 +65,18 @@ namespace randomcat::simple_parsing {
         return _tok.data<integer_literal_value_type>();
     }
     
+    token token::make_floating_literal(randomcat::simple_parsing::token::floating_literal_value_type _value) noexcept {
+        return token(token_kind::floating_literal, _value);
+    }
+    
+    bool token::is_floating_literal(randomcat::simple_parsing::token const& _tok) noexcept {
+        return _tok.kind() == token_kind::floating_literal;
+    }
+    
+    token::floating_literal_value_type token::floating_literal_value(randomcat::simple_parsing::token const& _tok) noexcept {
+        return _tok.data<floating_literal_value_type>();
+    }
+    
     token token::make_variable(randomcat::simple_parsing::variable_kind _var) noexcept {
         return token(token_kind::variable, _var);
     }
@@ -84,6 +96,7 @@ namespace randomcat::simple_parsing {
 
         switch (_first.kind()) {
             case token_kind::integer_literal: return token::integer_literal_value(_first) == token::integer_literal_value(_second);
+            case token_kind::floating_literal: return token::floating_literal_value(_first) == token::floating_literal_value(_second);
             case token_kind::variable: return token::variable_value(_first) == token::variable_value(_second);
             default: throw std::logic_error("invalid token kind with data");
         }
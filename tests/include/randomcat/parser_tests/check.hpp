@@ -0,0 +1,24 @@
+#pragma once
+
+#include <iostream>
+
+namespace randomcat::parser_tests {
+    inline int& failure_count() noexcept {
+        static int count = 0;
+        return count;
+    }
+
+    // Unlike assert, keeps checking in release builds and after a failure, so one run reports every broken check
+    inline void check(bool _condition, char const* _description) {
+        if (_condition) return;
+
+        std::cerr << "Check failed: " << _description << "\n";
+        ++failure_count();
+    }
+
+    // What main returns: nonzero if any check failed, which is what CTest counts as a failed test
+    inline int exit_code() {
+        if (failure_count() != 0) std::cerr << failure_count() << " check(s) failed\n";
+        return failure_count() == 0 ? 0 : 1;
+    }
+}    // namespace randomcat::parser_tests
@@ -0,0 +1,109 @@
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "randomcat/complex_parsing/token.hpp"
+#include "randomcat/complex_parsing/token_manipulation.hpp"
+#include "randomcat/parser_tests/check.hpp"
+
+namespace p = randomcat::parser;
+namespace cp = randomcat::complex_parsing;
+namespace t = randomcat::parser_tests;
+
+namespace {
+    // Small blocks on more threads than the machine may have, so that every input below is split into many blocks
+    p::parallel_filter_options const manyBlocks = {4, 64, 4};
+
+    // Identifiers are numbered, so that results can be compared token for token
+    std::vector<cp::token> numbered_identifiers(std::size_t _count) {
+        std::vector<cp::token> tokens;
+        tokens.reserve(_count);
+
+        for (std::size_t i = 0; i < _count; ++i) tokens.push_back(cp::token::make_identifier(std::to_string(i)));
+        return tokens;
+    }
+
+    bool same_tokens(std::vector<cp::token> const& _a, std::vector<cp::token> const& _b) {
+        if (_a.size() != _b.size()) return false;
+
+        for (std::size_t i = 0; i < _a.size(); ++i) {
+            if (_a[i].kind() != _b[i].kind()) return false;
+            if (_a[i].kind() == cp::token_kind::identifier && cp::token::identifier_value(_a[i]) != cp::token::identifier_value(_b[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    std::vector<cp::token> serial_strip(std::vector<cp::token> _tokens, cp::token_kind _first, cp::token_kind _last) {
+        _tokens.erase(cp::strip_from_kind_to_kind(_tokens.begin(), _tokens.end(), _first, _last), _tokens.end());
+        return _tokens;
+    }
+
+    void regions_spanning_several_blocks() {
+        // 16 blocks of 256 tokens
+        auto tokens = numbered_identifiers(4096);
+
+        // Opens in the first block and closes five blocks later, with a nested opener that must not restart the region
+        tokens[100] = cp::token(cp::token_kind::lbrace);
+        tokens[700] = cp::token(cp::token_kind::lbrace);
+        tokens[1400] = cp::token(cp::token_kind::rbrace);
+
+        // A closer outside any region is kept
+        tokens[2000] = cp::token(cp::token_kind::rbrace);
+
+        // Opens on the last token of a block and closes on the first of the next
+        tokens[2559] = cp::token(cp::token_kind::lbrace);
+        tokens[2560] = cp::token(cp::token_kind::rbrace);
+
+        // Never closes
+        tokens[3500] = cp::token(cp::token_kind::lbrace);
+
+        auto const expected = serial_strip(tokens, cp::token_kind::lbrace, cp::token_kind::rbrace);
+        auto const actual = cp::parallel_strip_from_kind_to_kind(tokens, cp::token_kind::lbrace, cp::token_kind::rbrace, manyBlocks);
+
+        t::check(expected.size() == 4096 - 1301 - 2 - 596, "the serial strip removes the regions");
+        t::check(same_tokens(expected, actual), "a region open across block boundaries is stripped like the serial strip does");
+    }
+
+    void random_regions_match_the_serial_strip() {
+        std::mt19937 random(12345);
+
+        for (int round = 0; round < 50; ++round) {
+            auto tokens = numbered_identifiers(1000 + round * 97);
+
+            // Sparse markers, so that regions are often longer than a block
+            std::uniform_int_distribution<int> marker(0, 199);
+
+            for (auto& token : tokens) {
+                auto const roll = marker(random);
+                if (roll == 0) token = cp::token(cp::token_kind::lbrace);
+                if (roll == 1) token = cp::token(cp::token_kind::rbrace);
+            }
+
+            auto const expected = serial_strip(tokens, cp::token_kind::lbrace, cp::token_kind::rbrace);
+            auto const actual = cp::parallel_strip_from_kind_to_kind(tokens, cp::token_kind::lbrace, cp::token_kind::rbrace, manyBlocks);
+
+            t::check(same_tokens(expected, actual), "random regions are stripped like the serial strip does");
+        }
+    }
+
+    void comments_match_the_serial_strip() {
+        auto tokens = numbered_identifiers(3000);
+        for (std::size_t i = 0; i < tokens.size(); i += 7) tokens[i] = cp::token(i % 2 ? cp::token_kind::line_comment : cp::token_kind::multiline_comment);
+
+        auto expected = tokens;
+        expected.erase(cp::strip_comments(expected.begin(), expected.end()), expected.end());
+
+        t::check(same_tokens(expected, cp::parallel_strip_comments(tokens, manyBlocks)), "comments are stripped like the serial strip does");
+    }
+}    // namespace
+
+int main() {
+    regions_spanning_several_blocks();
+    random_regions_match_the_serial_strip();
+    comments_match_the_serial_strip();
+
+    return t::exit_code();
+}
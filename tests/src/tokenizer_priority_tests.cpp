@@ -0,0 +1,152 @@
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <randomcat/parser/chars/char_source.hpp>
+#include <randomcat/parser/chars/tokenizer.hpp>
+
+#include "randomcat/parser_tests/check.hpp"
+
+namespace p = randomcat::parser;
+namespace t = randomcat::parser_tests;
+
+namespace {
+    struct test_token {
+        using char_type = char;
+        using char_traits_type = std::char_traits<char_type>;
+
+        int id;
+    };
+
+    using literal = p::simple_token_descriptor<test_token>;
+
+    // Matches one or more _c with the given priority. It has no max_match_size, so the tokenizer cannot skip it on length alone.
+    class run_descriptor {
+    public:
+        using token_type = test_token;
+        using char_type = char;
+        using char_traits_type = std::char_traits<char_type>;
+        using error_type = p::no_matching_token_t;
+        using priority_type = p::default_priority_type;
+
+        explicit run_descriptor(int _id, char _c, priority_type _priority, std::size_t* _attempts = nullptr) noexcept
+        : m_id(_id), m_c(_c), m_priority(_priority), m_attempts(_attempts) {}
+
+        template<typename CharSource>
+        p::parse_result<test_token, error_type> parse_first_token(CharSource const& _chars) const noexcept {
+            if (m_attempts) ++*m_attempts;
+
+            auto const rest = p::char_source_traits<CharSource>::peek(_chars, p::char_source_traits<CharSource>::chars_remaining(_chars));
+
+            std::size_t size = 0;
+            while (size < rest.size() && rest[size] == m_c) ++size;
+
+            if (size == 0) return p::no_matching_token;
+            return {test_token{m_id}, size};
+        }
+
+        priority_type priority() const noexcept { return m_priority; }
+
+    private:
+        int m_id;
+        char m_c;
+        priority_type m_priority;
+        std::size_t* m_attempts;
+    };
+
+    // A descriptor whose priority is known while compiling, so the tokenizer sorts its evaluation order statically
+    template<int Id, int Priority>
+    class static_literal {
+    public:
+        using token_type = test_token;
+        using char_type = char;
+        using char_traits_type = std::char_traits<char_type>;
+        using error_type = p::no_matching_token_t;
+        using priority_type = p::default_priority_type;
+
+        explicit static_literal(std::string _string) : m_string(std::move(_string)) {}
+
+        template<typename CharSource>
+        p::parse_result<test_token, error_type> parse_first_token(CharSource const& _chars) const noexcept {
+            if (m_string != p::char_source_traits<CharSource>::peek(_chars, m_string.size())) return p::no_matching_token;
+            return {test_token{Id}, m_string.size()};
+        }
+
+        static constexpr priority_type priority() noexcept { return Priority; }
+
+    private:
+        std::string m_string;
+    };
+
+    struct match {
+        int id;
+        std::size_t size;
+    };
+
+    template<typename Tokenizer>
+    match first_token(Tokenizer const& _tokenizer, std::string_view _input) {
+        auto const source = p::string_view_char_source(_input);
+        auto result = p::tokenizer_traits<Tokenizer>::parse_first_token(_tokenizer, source);
+        if (not result) return {-1, 0};
+
+        return {result.value().id, result.amount_parsed()};
+    }
+
+    bool operator==(match const& _a, match const& _b) noexcept { return _a.id == _b.id && _a.size == _b.size; }
+
+    void equal_priorities_pick_the_longest_match() {
+        // Declared shortest first, so declaration order alone would pick the wrong one
+        auto const tokenizer = p::make_simple_tokenizer<test_token>(run_descriptor(1, 'a', 5), literal(test_token{2}, 5, "aaaa"));
+
+        t::check(first_token(tokenizer, "aaaaaab") == match{1, 6}, "a longer run beats a shorter literal of equal priority");
+        t::check(first_token(tokenizer, "aaaab") == match{1, 4}, "an equally long run declared first beats the literal");
+
+        auto const literals = p::make_simple_tokenizer<test_token>(literal(test_token{1}, 3, "x"), literal(test_token{2}, 3, "xyz"), literal(test_token{3}, 3, "xy"));
+        t::check(first_token(literals, "xyzw") == match{2, 3}, "the longest of three equal-priority literals wins");
+    }
+
+    void higher_priority_beats_longer_match() {
+        auto const tokenizer = p::make_simple_tokenizer<test_token>(run_descriptor(1, 'a', 1), literal(test_token{2}, 2, "a"));
+        t::check(first_token(tokenizer, "aaaa") == match{2, 1}, "a one-char match of higher priority beats a longer run");
+
+        auto const statics = p::make_simple_tokenizer<test_token>(static_literal<1, 1>("abcd"), static_literal<2, 9>("ab"));
+        t::check(first_token(statics, "abcd") == match{2, 2}, "statically sorted descriptors still prefer priority over length");
+    }
+
+    void declaration_order_breaks_equal_ties() {
+        auto const tokenizer = p::make_simple_tokenizer<test_token>(literal(test_token{1}, 4, "ab"), literal(test_token{2}, 4, "ab"), literal(test_token{3}, 4, "ab"));
+        t::check(first_token(tokenizer, "ab") == match{1, 2}, "the first declared of identical matches wins");
+
+        auto const runs = p::make_simple_tokenizer<test_token>(literal(test_token{1}, 2, "q"), run_descriptor(2, 'b', 4), run_descriptor(3, 'b', 4));
+        t::check(first_token(runs, "bbb") == match{2, 3}, "equally long runs of equal priority go to the first declared");
+
+        auto const statics = p::make_simple_tokenizer<test_token>(static_literal<1, 3>("ab"), static_literal<2, 3>("ab"));
+        t::check(first_token(statics, "ab") == match{1, 2}, "the static sort is stable");
+    }
+
+    void early_exit_keeps_later_higher_priorities() {
+        std::size_t lowAttempts = 0;
+
+        // The best match is declared last; the low priority run before it must not end the search early
+        auto const tokenizer = p::make_simple_tokenizer<test_token>(run_descriptor(1, 'a', 1, &lowAttempts),
+                                                                    literal(test_token{2}, 2, "zz"),
+                                                                    literal(test_token{3}, 7, "aa"));
+
+        t::check(first_token(tokenizer, "aaaa") == match{3, 2}, "a higher priority declared later is still tried");
+        t::check(lowAttempts == 0, "descriptors below the priority of a match are not attempted");
+
+        t::check(first_token(tokenizer, "abc") == match{1, 1}, "lower priorities are tried when nothing above them matches");
+        t::check(lowAttempts == 1, "the low priority run was attempted once it could win");
+
+        t::check(first_token(tokenizer, "q") == match{-1, 0}, "no match when no descriptor matches");
+    }
+}    // namespace
+
+int main() {
+    equal_priorities_pick_the_longest_match();
+    higher_priority_beats_longer_match();
+    declaration_order_breaks_equal_ties();
+    early_exit_keeps_later_higher_priorities();
+
+    return t::exit_code();
+}